@@ -0,0 +1,558 @@
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <benchmark/benchmark.h>
+
+#include "ARC/ARC_Cache.hpp"
+#include "ARC/ARC_Snapshot.hpp"
+#include "ARC/TieredARC_Cache.hpp"
+#include "ARC/MultiTenantARC_Cache.hpp"
+#include "ARC/CAR_Cache.hpp"
+#include "optimal/optimal_cache.hpp"
+#include "LRU/LRU_ListCache.hpp"
+#include "TwoQ/TwoQ_Cache.hpp"
+#include "LIRS/LIRS_Cache.hpp"
+#include "ClockPro/ClockPro_Cache.hpp"
+#include "TinyLFU/TinyLFU_Cache.hpp"
+#include "utils/workload/workload.hpp"
+#include "../tests/alloc_counter.hpp"
+
+// CoarseSteadyClock exists only where the kernel has a coarse clock
+#ifdef CLOCK_MONOTONIC_COARSE
+using TTLClock = CoarseSteadyClock;
+#else
+using TTLClock = std::chrono::steady_clock;
+#endif
+
+// ARC_flat whose entries live for 10 ms, so expiry keeps draining T1/T2:
+// the difference to ARC_flat is what the timing wheel costs per request
+class TTLARCCache : public ARCCache<ssize_t, ssize_t, FlatHashIndex, FingerprintGhosts,
+                                    NoARCStats, WheelExpiry<TTLClock>>
+{
+public:
+    explicit TTLARCCache(ssize_t capacity)
+             : ARCCache(capacity, WheelExpiry<TTLClock>(std::chrono::milliseconds(4),
+                                                         std::chrono::milliseconds(10))) {}
+};
+
+static constexpr std::size_t TRACE_LENGTH = 1 << 20;
+
+// requests per add_cache_batch call, and a capacity whose ARC (slabs and
+// both indexes) is well past any last-level cache
+static constexpr std::size_t BATCH_SIZE     = 64;
+static constexpr ssize_t     LARGE_CAPACITY = 1 << 21;
+
+static constexpr char        SNAPSHOT_PATH[]     = "cache_bench.snapshot";
+static constexpr ssize_t     SNAPSHOT_CAPACITY   = 10000000;
+
+// the tiered cache keeps L2_RATIO times its memory capacity in the file
+static constexpr char        L2_PATH[]           = "cache_bench.l2";
+static constexpr ssize_t     L2_RATIO            = 16;
+
+// tenants sharing the budget of the multi-tenant group
+static constexpr ssize_t     TENANTS             = 16;
+
+using trace_t = workload::trace_t;
+
+// generators keyed by the name the benchmarks report; the capacity shapes
+// working sets and loops around the cache size
+static const std::map<std::string, std::function<trace_t(ssize_t)>> &workloads()
+{
+    static const std::map<std::string, std::function<trace_t(ssize_t)>> generators =
+    {
+        {"zipf_0.7",  [](ssize_t capacity) { return workload::zipf(TRACE_LENGTH, 20 * capacity, 0.7); }},
+        {"zipf_0.99", [](ssize_t capacity) { return workload::zipf(TRACE_LENGTH, 20 * capacity, 0.99); }},
+        {"scan_loop", [](ssize_t capacity)
+                      {
+                          return workload::scan_loop(TRACE_LENGTH, capacity + capacity / 5, 2 * capacity);
+                      }},
+        {"shifting",  [](ssize_t capacity)
+                      {
+                          return workload::shifting_working_set(TRACE_LENGTH, 2 * capacity, TRACE_LENGTH / 16);
+                      }},
+        {"arc_scan",  [](ssize_t capacity)
+                      {
+                          return workload::arc_scan(TRACE_LENGTH, 4 * capacity, 2 * capacity, 20 * capacity);
+                      }},
+        {"arc_phases",[](ssize_t capacity)
+                      {
+                          return workload::arc_phases(TRACE_LENGTH, capacity / 2, 8 * capacity, TRACE_LENGTH / 8);
+                      }},
+    };
+
+    return generators;
+}
+
+// traces are built once per (workload, capacity) and shared by the policies
+static const trace_t &get_trace(const std::string &name, ssize_t capacity)
+{
+    static std::map<std::pair<std::string, ssize_t>, trace_t> traces;
+
+    auto trace_it = traces.find({name, capacity});
+    if (trace_it == traces.end())
+        trace_it = traces.emplace(std::make_pair(name, capacity), workloads().at(name)(capacity)).first;
+
+    return trace_it->second;
+}
+
+// the high-water mark of the whole process so far: read it per benchmark
+// with --benchmark_filter to get one policy's footprint
+static void report_memory(benchmark::State &state)
+{
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    state.counters["peak_rss_kb"] = static_cast<double>(usage.ru_maxrss);
+}
+
+// caches that account for their own bytes, like ARCCache, also report them
+// per key they track, ghosts included
+template <typename cache_t, typename = void>
+struct reports_tracked_bytes : std::false_type {};
+
+template <typename cache_t>
+struct reports_tracked_bytes<cache_t, std::void_t<decltype(std::declval<const cache_t &>().memory_usage()),
+                                                  decltype(std::declval<const cache_t &>().tracked_count())>>
+       : std::true_type {};
+
+template <typename cache_t>
+static void report_tracked_bytes(benchmark::State &state, const cache_t &cache)
+{
+    if constexpr (reports_tracked_bytes<cache_t>::value)
+    {
+        const std::size_t tracked = cache.tracked_count();
+        state.counters["bytes_per_key"] = tracked ? static_cast<double>(cache.memory_usage()) /
+                                                    static_cast<double>(tracked) : 0.0;
+    }
+}
+
+// the add_cache hot path: one warm-up pass over the trace, then every
+// iteration is a single request, cycling through the trace; hit_ratio is
+// over the timed, warm requests only
+template <typename cache_t>
+static void bench_add_cache(benchmark::State &state, const std::string &name)
+{
+    const ssize_t  capacity = state.range(0);
+    const trace_t &trace    = get_trace(name, capacity);
+
+    cache_t cache(capacity);
+    for (const auto &request : trace)
+        cache.add_cache(request.first, request.second);
+
+    const ssize_t hits_before     = cache.get_hit_count();
+    const ssize_t requests_before = cache.get_request_count();
+
+    std::size_t position = 0;
+    const std::size_t allocations_before = allocations();
+
+    for (auto _ : state)
+    {
+        const auto &request = trace[position];
+        benchmark::DoNotOptimize(cache.add_cache(request.first, request.second));
+
+        if (++position == trace.size()) position = 0;
+    }
+
+    const std::size_t allocated = allocations() - allocations_before;
+    const double requests = static_cast<double>(cache.get_request_count() - requests_before);
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hit_ratio"]      = requests > 0 ? static_cast<double>(cache.get_hit_count() - hits_before) / requests : 0.0;
+    state.counters["allocs_per_op"]  = static_cast<double>(allocated) / static_cast<double>(state.iterations());
+    report_memory(state);
+    report_tracked_bytes(state, cache);
+}
+
+// the same warm loop through add_cache_batch, BATCH_SIZE requests an
+// iteration; items are requests, so it compares directly with the above
+template <typename cache_t>
+static void bench_add_cache_batch(benchmark::State &state, const std::string &name)
+{
+    static_assert(TRACE_LENGTH % BATCH_SIZE == 0, "a batch must not wrap around the trace");
+
+    const ssize_t  capacity = state.range(0);
+    const trace_t &trace    = get_trace(name, capacity);
+    const RequestSpan<ssize_t, ssize_t> requests(trace);
+
+    cache_t cache(capacity);
+    cache.add_cache_batch(requests);
+
+    const ssize_t hits_before     = cache.get_hit_count();
+    const ssize_t requests_before = cache.get_request_count();
+
+    std::size_t position = 0;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cache.add_cache_batch(requests.subspan(position, BATCH_SIZE)));
+
+        position += BATCH_SIZE;
+        if (position == trace.size()) position = 0;
+    }
+
+    const double processed = static_cast<double>(cache.get_request_count() - requests_before);
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(BATCH_SIZE));
+    state.counters["hit_ratio"] = processed > 0 ? static_cast<double>(cache.get_hit_count() - hits_before) / processed : 0.0;
+    report_memory(state);
+}
+
+// std::string keys longer than the small-string buffer, looked up through
+// a std::string_view with emplace: allocs_per_op is what admissions cost,
+// since a hit builds neither the key nor the item
+template <typename cache_t>
+static void bench_string_keys(benchmark::State &state, const std::string &name)
+{
+    const ssize_t  capacity = state.range(0);
+    const trace_t &trace    = get_trace(name, capacity);
+
+    std::vector<std::string> keys;
+    keys.reserve(trace.size());
+    for (const auto &request : trace)
+        keys.push_back("cache_bench/string_key/" + std::to_string(request.first));
+
+    cache_t cache(capacity);
+    for (std::size_t i = 0; i < trace.size(); i++)
+        cache.emplace(std::string_view(keys[i]), trace[i].second);
+
+    const ssize_t hits_before     = cache.get_hit_count();
+    const ssize_t requests_before = cache.get_request_count();
+
+    std::size_t position = 0;
+    const std::size_t allocations_before = allocations();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cache.emplace(std::string_view(keys[position]), trace[position].second));
+
+        if (++position == trace.size()) position = 0;
+    }
+
+    const std::size_t allocated = allocations() - allocations_before;
+    const double requests = static_cast<double>(cache.get_request_count() - requests_before);
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hit_ratio"]     = requests > 0 ? static_cast<double>(cache.get_hit_count() - hits_before) / requests : 0.0;
+    state.counters["allocs_per_op"] = static_cast<double>(allocated) / static_cast<double>(state.iterations());
+    report_memory(state);
+}
+
+// fills all four lists: half the keys come twice in a row and go to T2,
+// and twice the capacity of keys pushes both halves into the ghosts
+template <typename cache_t>
+static void fill_for_snapshot(cache_t &cache, ssize_t capacity)
+{
+    for (ssize_t i = 0; i < 2 * capacity; i++)
+    {
+        const ssize_t key = workload::scatter(static_cast<std::size_t>(i));
+        cache.add_cache(key, key);
+
+        if (i % 2 == 0) cache.add_cache(key, key);
+    }
+}
+
+// copy_state is all the cache waits for; the write runs on a copy and
+// would go to a pool thread in a server, here it is timed with the rest.
+// The copy is kept across snapshots, as a server would keep it
+template <typename cache_t>
+static void bench_snapshot_save(benchmark::State &state)
+{
+    const ssize_t capacity = state.range(0);
+
+    cache_t cache(capacity);
+    fill_for_snapshot(cache, capacity);
+
+    typename cache_t::StateCopy copy;
+    cache.copy_state(copy);
+
+    double copy_seconds = 0.0;
+
+    for (auto _ : state)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        cache.copy_state(copy);
+        copy_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        benchmark::DoNotOptimize(write_arc_snapshot(SNAPSHOT_PATH, copy));
+    }
+
+    state.SetItemsProcessed(state.iterations() * capacity);
+    state.counters["copy_pause_ms"] = copy_seconds * 1e3 / static_cast<double>(state.iterations());
+    report_memory(state);
+}
+
+// a warm restart: a fresh cache maps the snapshot and rebuilds lists and
+// indexes from it; the file is written once and sits in the page cache
+template <typename cache_t>
+static void bench_snapshot_restore(benchmark::State &state)
+{
+    const ssize_t capacity = state.range(0);
+
+    {
+        cache_t cache(capacity);
+        fill_for_snapshot(cache, capacity);
+
+        if (!save_arc_snapshot(SNAPSHOT_PATH, cache))
+        {
+            state.SkipWithError("can not write the snapshot");
+            return;
+        }
+    }
+
+    std::unique_ptr<cache_t> cache;
+    ssize_t restored = 0;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        cache.reset();
+        cache.reset(new cache_t(capacity));
+        state.ResumeTiming();
+
+        restore_arc_snapshot(SNAPSHOT_PATH, *cache);
+        benchmark::ClobberMemory();
+    }
+
+    if (cache != nullptr)
+    {
+        const auto copy = cache->copy_state();
+        for (std::size_t i = 0; i < ARC_LISTS; i++)
+            restored += static_cast<ssize_t>(copy.size(static_cast<ARCList>(i)));
+    }
+
+    std::remove(SNAPSHOT_PATH);
+
+    state.SetItemsProcessed(state.iterations() * restored);
+    state.counters["restored_keys"] = static_cast<double>(restored);
+    report_memory(state);
+}
+
+// bench_add_cache over an L1 ARC backed by an L2 file: the timed loop pays
+// for demotions and for the preads of L2 hits, and each tier reports its
+// own share of the warm requests
+static void bench_tiered(benchmark::State &state, const std::string &name)
+{
+    const ssize_t  capacity = state.range(0);
+    const trace_t &trace    = get_trace(name, capacity);
+
+    TieredARCCache<ssize_t, ssize_t> cache(capacity, L2_PATH,
+                                           static_cast<std::size_t>(L2_RATIO * capacity) * sizeof(ssize_t));
+    for (const auto &request : trace)
+        cache.add_cache(request.first, request.second);
+
+    const ssize_t l1_before       = cache.get_l1_hit_count();
+    const ssize_t l2_before       = cache.get_l2_hit_count();
+    const ssize_t requests_before = cache.get_request_count();
+
+    std::size_t position = 0;
+
+    for (auto _ : state)
+    {
+        const auto &request = trace[position];
+        benchmark::DoNotOptimize(cache.add_cache(request.first, request.second));
+
+        if (++position == trace.size()) position = 0;
+    }
+
+    const double requests = static_cast<double>(cache.get_request_count() - requests_before);
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["l1_hit_ratio"] = requests > 0 ? static_cast<double>(cache.get_l1_hit_count() - l1_before) / requests : 0.0;
+    state.counters["l2_hit_ratio"] = requests > 0 ? static_cast<double>(cache.get_l2_hit_count() - l2_before) / requests : 0.0;
+    state.counters["l2_p99_ns"]    = static_cast<double>(cache.latency(TieredARCCache<ssize_t, ssize_t>::Tier::L2)
+                                                             .value_at_quantile(0.99));
+    report_memory(state);
+}
+
+// bench_add_cache over TENANTS ARC caches sharing capacity entries on the
+// tenant_mix trace; a rebalance_period of 0 is the static even split, the
+// baseline of the adaptive runs. moved_per_op is the capacity rebalancing
+// shifted per timed request
+static void bench_tenants(benchmark::State &state, ssize_t rebalance_period)
+{
+    using group_t = MultiTenantARCCache<ssize_t, ssize_t>;
+
+    const ssize_t capacity = state.range(0);
+
+    static std::map<ssize_t, trace_t> traces;
+    auto trace_it = traces.find(capacity);
+    if (trace_it == traces.end())
+        trace_it = traces.emplace(capacity, workload::tenant_mix(TRACE_LENGTH, TENANTS, capacity / TENANTS)).first;
+
+    const trace_t &trace = trace_it->second;
+
+    group_t cache(capacity, TENANTS, rebalance_period, [](const ssize_t &key) { return workload::tenant_of(key); });
+    for (const auto &request : trace)
+        cache.add_cache(request.first, request.second);
+
+    const ssize_t hits_before     = cache.get_hit_count();
+    const ssize_t requests_before = cache.get_request_count();
+    const ssize_t moved_before    = cache.get_moved_count();
+
+    std::size_t position = 0;
+
+    for (auto _ : state)
+    {
+        const auto &request = trace[position];
+        benchmark::DoNotOptimize(cache.add_cache(request.first, request.second));
+
+        if (++position == trace.size()) position = 0;
+    }
+
+    const double requests = static_cast<double>(cache.get_request_count() - requests_before);
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hit_ratio"]    = requests > 0 ? static_cast<double>(cache.get_hit_count() - hits_before) / requests : 0.0;
+    state.counters["moved_per_op"] = static_cast<double>(cache.get_moved_count() - moved_before) /
+                                     static_cast<double>(state.iterations());
+    report_memory(state);
+}
+
+// OPT decides offline, so an iteration is a whole run_cache; this is where
+// remove_farest shows up. Its hit_ratio includes the cold start, unlike the
+// warm ratio of the online policies
+static void bench_opt(benchmark::State &state, const std::string &name)
+{
+    const ssize_t  capacity = state.range(0);
+    const trace_t &trace    = get_trace(name, capacity);
+
+    ssize_t hits = 0;
+    const std::size_t allocations_before = allocations();
+
+    for (auto _ : state)
+    {
+        OPT_cache<ssize_t, ssize_t> cache(capacity);
+        hits = cache.run_cache(trace);
+        benchmark::DoNotOptimize(hits);
+    }
+
+    const std::size_t allocated = allocations() - allocations_before;
+    const double requests = static_cast<double>(state.iterations()) * static_cast<double>(trace.size());
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(requests));
+    state.counters["hit_ratio"]     = static_cast<double>(hits) / static_cast<double>(trace.size());
+    state.counters["allocs_per_op"] = static_cast<double>(allocated) / requests;
+    report_memory(state);
+}
+
+template <typename cache_t>
+static void register_policy(const std::string &policy)
+{
+    for (const auto &generator : workloads())
+    {
+        const std::string name = generator.first;
+        benchmark::RegisterBenchmark((policy + "/" + name).c_str(),
+                                     [name](benchmark::State &state) { bench_add_cache<cache_t>(state, name); })
+            ->Arg(1000)->Arg(100000);
+    }
+}
+
+// per-request against batched, on the Zipf traces where most requests go
+// to a random spot of a large index and the node it points to
+template <typename cache_t>
+static void register_batch(const std::string &policy)
+{
+    for (const std::string name : {"zipf_0.7", "zipf_0.99"})
+    {
+        benchmark::RegisterBenchmark((policy + "/" + name).c_str(),
+                                     [name](benchmark::State &state) { bench_add_cache<cache_t>(state, name); })
+            ->Arg(LARGE_CAPACITY);
+
+        benchmark::RegisterBenchmark((policy + "_batch/" + name).c_str(),
+                                     [name](benchmark::State &state) { bench_add_cache_batch<cache_t>(state, name); })
+            ->Arg(1000)->Arg(100000)->Arg(LARGE_CAPACITY);
+    }
+}
+
+template <typename cache_t>
+static void register_snapshot(const std::string &policy)
+{
+    benchmark::RegisterBenchmark((policy + "_snapshot/save").c_str(), bench_snapshot_save<cache_t>)
+        ->Arg(1 << 20)->Arg(SNAPSHOT_CAPACITY)->Unit(benchmark::kMillisecond);
+
+    benchmark::RegisterBenchmark((policy + "_snapshot/restore").c_str(), bench_snapshot_restore<cache_t>)
+        ->Arg(1 << 20)->Arg(SNAPSHOT_CAPACITY)->Unit(benchmark::kMillisecond);
+}
+
+int main(int argc, char **argv)
+{
+    // a new policy is one more line here
+    register_policy<ARCCache<ssize_t, ssize_t>>("ARC");
+    register_policy<ARCCache<ssize_t, ssize_t, FlatHashIndex, FingerprintGhosts>>("ARC_flat");
+    register_policy<ARCCache<ssize_t, ssize_t, FlatHashIndex, KeyGhosts>>("ARC_flat_keys");
+    register_policy<ARCCache<ssize_t, ssize_t, StdHashIndex, KeyGhosts, ARCStats>>("ARC_stats");
+    register_policy<TTLARCCache>("ARC_ttl");
+    register_policy<CARCache<ssize_t, ssize_t>>("CAR");
+    register_policy<LRUListCache<ssize_t, ssize_t>>("LRU");
+    register_policy<TwoQCache<ssize_t, ssize_t>>("2Q");
+    register_policy<LIRSCache<ssize_t, ssize_t>>("LIRS");
+    register_policy<ClockProCache<ssize_t, ssize_t>>("CLOCK-Pro");
+    register_policy<TinyLFUCache<ssize_t, ssize_t>>("W-TinyLFU");
+
+    register_batch<ARCCache<ssize_t, ssize_t, FlatHashIndex, FingerprintGhosts>>("ARC_flat");
+    register_snapshot<ARCCache<ssize_t, ssize_t, FlatHashIndex, FingerprintGhosts>>("ARC_flat");
+
+    for (const std::string name : {"zipf_0.7", "zipf_0.99"})
+    {
+        benchmark::RegisterBenchmark(("ARC_string/" + name).c_str(), [name](benchmark::State &state)
+                                     { bench_string_keys<ARCCache<std::string, ssize_t>>(state, name); })
+            ->Arg(1000)->Arg(100000);
+
+        benchmark::RegisterBenchmark(("ARC_flat_string/" + name).c_str(), [name](benchmark::State &state)
+                                     { bench_string_keys<ARCCache<std::string, ssize_t, FlatHashIndex>>(state, name); })
+            ->Arg(1000)->Arg(100000);
+    }
+
+    for (const std::string name : {"zipf_0.7", "zipf_0.99"})
+        benchmark::RegisterBenchmark(("ARC_tiered/" + name).c_str(),
+                                     [name](benchmark::State &state) { bench_tiered(state, name); })
+            ->Arg(1000)->Arg(100000);
+
+    benchmark::RegisterBenchmark("ARC_tenants/static",
+                                 [](benchmark::State &state) { bench_tenants(state, 0); })
+        ->Arg(1000)->Arg(100000);
+
+    benchmark::RegisterBenchmark("ARC_tenants/adaptive",
+                                 [](benchmark::State &state)
+                                 { bench_tenants(state, MultiTenantARCCache<ssize_t, ssize_t>::STD_REBALANCE_PERIOD); })
+        ->Arg(1000)->Arg(100000);
+
+    for (const auto &generator : workloads())
+    {
+        const std::string name = generator.first;
+        benchmark::RegisterBenchmark(("OPT/" + name).c_str(),
+                                     [name](benchmark::State &state) { bench_opt(state, name); })
+            ->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+    }
+
+    // JSON unless asked otherwise, so results can be diffed across commits
+    std::vector<char *> arguments(argv, argv + argc);
+    bool has_format = false;
+    for (int i = 1; i < argc; i++)
+        has_format = has_format || std::string(argv[i]).rfind("--benchmark_format", 0) == 0;
+
+    static char json_format[] = "--benchmark_format=json";
+    if (!has_format)
+        arguments.push_back(json_format);
+
+    int arguments_amount = static_cast<int>(arguments.size());
+
+    log_open("cache_bench_log");
+
+    benchmark::Initialize(&arguments_amount, arguments.data());
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    log_close();
+    return 0;
+}
@@ -2,16 +2,137 @@
 #define ARCCache_HPP
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
-#include <list>
 #include <vector>
 #include <unordered_map>
 #include <cassert>
-
-#include "utils/logger.hpp"
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "utils/log_config/log_config.hpp"
 #include "CacheInterface.hpp"
+#include "ARC/NodeSlab.hpp"
+#include "ARC/ARC_Stats.hpp"
+#include "ARC/ARC_Expiry.hpp"
+#include "utils/flat_map/flat_hash_map.hpp"
+
+// std::hash, except that a std::string key also hashes its views: both
+// are transparent there, so a std::string index can be searched with a
+// std::string_view or a literal. std::hash gives a string and its view the
+// same value, so nothing else changes
+template <typename key_t>
+struct IndexHash : std::hash<key_t> {};
+
+template <>
+struct IndexHash<std::string>
+{
+    using is_transparent = void;
+
+    inline std::size_t operator()(std::string_view key) const { return std::hash<std::string_view>()(key); }
+};
+
+template <typename key_t>
+using IndexEqual = typename std::conditional<std::is_same<key_t, std::string>::value,
+                                             std::equal_to<>, std::equal_to<key_t>>::type;
+
+// key -> location index used by ARCCache, picked through its map_t parameter
+template <typename map_key_t, typename map_value_t>
+using StdHashIndex = std::unordered_map<map_key_t, map_value_t, IndexHash<map_key_t>, IndexEqual<map_key_t>>;
+
+template <typename map_key_t, typename map_value_t>
+using FlatHashIndex = FlatHashMap<map_key_t, map_value_t, IndexHash<map_key_t>, IndexEqual<map_key_t>>;
+
+// whether an index finds a key by another type without building a key_t;
+// std::unordered_map learned that in C++20, so StdHashIndex builds one
+// before that
+template <typename map_type>
+struct HeterogeneousIndex
+{
+    static constexpr bool ENABLED = false;
+};
+
+template <typename map_key_t, typename map_value_t, typename hash_t, typename key_equal_t>
+struct HeterogeneousIndex<FlatHashMap<map_key_t, map_value_t, hash_t, key_equal_t>>
+{
+    static constexpr bool ENABLED = TransparentLookup<hash_t, key_equal_t>::value;
+};
+
+#if defined(__cpp_lib_generic_unordered_lookup)
+template <typename map_key_t, typename map_value_t, typename hash_t, typename key_equal_t, typename alloc_t>
+struct HeterogeneousIndex<std::unordered_map<map_key_t, map_value_t, hash_t, key_equal_t, alloc_t>>
+{
+    static constexpr bool ENABLED = TransparentLookup<hash_t, key_equal_t>::value;
+};
+#endif
+
+// whether an index can split find() into hash and prefetch steps for the
+// batched calls; FlatHashMap can, std::unordered_map hides its buckets
+template <typename map_type>
+struct IndexPrefetch
+{
+    static constexpr bool ENABLED = false;
+};
+
+template <typename map_key_t, typename map_value_t, typename hash_t, typename key_equal_t>
+struct IndexPrefetch<FlatHashMap<map_key_t, map_value_t, hash_t, key_equal_t>>
+{
+    static constexpr bool ENABLED = true;
+};
 
-template <typename key_t, typename item_t> 
+// whether an index has find_bounded(), a probe that ends even when read
+// while being written; FlatHashMap has, std::unordered_map can not
+template <typename map_type>
+struct BoundedIndexFind
+{
+    static constexpr bool ENABLED = false;
+};
+
+template <typename map_key_t, typename map_value_t, typename hash_t, typename key_equal_t>
+struct BoundedIndexFind<FlatHashMap<map_key_t, map_value_t, hash_t, key_equal_t>>
+{
+    static constexpr bool ENABLED = true;
+};
+
+// what B1/B2 remember about an evicted key, picked through ghost_t:
+// the key itself, or a 32-bit fingerprint that may rarely collide. Both
+// also take whatever the index looks keys up by
+template <typename key_t>
+struct KeyGhosts
+{
+    using ghost_key_t = key_t;
+
+    // passes the key through, so an evicted key can be moved into B1/B2
+    template <typename lookup_t>
+    static inline lookup_t &&ghost_key(lookup_t &&key) { return std::forward<lookup_t>(key); }
+};
+
+template <typename key_t>
+struct FingerprintGhosts
+{
+    using ghost_key_t = std::uint32_t;
+
+    template <typename lookup_t>
+    static inline std::uint32_t ghost_key(const lookup_t &key)
+    {
+        std::uint64_t h = static_cast<std::uint64_t>(IndexHash<key_t>()(key));
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        return static_cast<std::uint32_t>(h);
+    }
+};
+
+template <typename key_t, typename item_t,
+          template <typename, typename> class map_t = StdHashIndex,
+          template <typename> class ghost_t = KeyGhosts,
+          typename stats_t = NoARCStats,
+          typename expiry_t = NoExpiry>
 class ARCCache : public CacheInterface<key_t, item_t>
 {
 private:
@@ -33,42 +154,88 @@ private:
         CacheEntry(const key_t &k, const item_t &i) : key(k), item(i) {}
     };
 
-    using ListType = typename std::list<CacheEntry>;
-    using ListIter = typename ListType::iterator;
-    
+    using GhostPolicy = ghost_t<key_t>;
+    using GhostKey    = typename GhostPolicy::ghost_key_t;
+
+    using SlabType      = NodeSlab<CacheEntry>;
+    using GhostSlabType = NodeSlab<GhostKey>;
+    using ListType      = typename SlabType::IndexList;
+    using GhostListType = typename GhostSlabType::IndexList;
+    using NodeIndex     = typename SlabType::index_t;
+
+    static constexpr NodeIndex NIL_NODE = SlabType::NIL;
 
     struct LocationInfo
     {
         ListLocation location;
-        ListIter list_iter;
+        NodeIndex node;
     
-        LocationInfo() : location(ListLocation::NOT_FOUND), list_iter() {}
-        LocationInfo(ListLocation loc, ListIter it) : location(loc), list_iter(it) {}    
+        LocationInfo() : location(ListLocation::NOT_FOUND), node(NIL_NODE) {}
+        LocationInfo(ListLocation loc, NodeIndex index) : location(loc), node(index) {}    
     };
 
     ssize_t capacity_;
     ssize_t hits_counter_;
+    ssize_t requests_counter_;
+    ssize_t ghost_hits_counter_;
     double adapt_param_;
+
+    // T1 + T2 hold at most capacity_ entries and B1 + B2 at most capacity_
+    // keys, so both slabs are sized in the constructor (and in set_capacity)
+    // and every move below is a relink; ghosts never carry an item
+    SlabType      entries_;
+    GhostSlabType ghosts_;
     
-    ListType list_first_,       list_frequent_;
-    ListType list_first_ghost_, list_frequent_ghost_; 
+    ListType      list_first_,       list_frequent_;
+    GhostListType list_first_ghost_, list_frequent_ghost_; 
 
-    using CacheMapType = typename std::unordered_map<key_t, LocationInfo>;
+    using CacheMapType = map_t<key_t, LocationInfo>;
     using CacheMapIter = typename CacheMapType::iterator;
+    using CacheMapConstIter = typename CacheMapType::const_iterator;
+
+    using GhostMapType = map_t<GhostKey, LocationInfo>;
+    using GhostMapIter = typename GhostMapType::iterator;
 
     CacheMapType cache_map_;
+    GhostMapType ghost_map_;
+
+    stats_t  stats_;
+    expiry_t expiry_;
+
+    using TTL = typename expiry_t::duration;
+
+    using EvictionHandler = std::function<void(const key_t &, const item_t &)>;
+
+    EvictionHandler evicted_;
 
     static constexpr ssize_t STD_CAPACITY = 64;
 
+    // due entries dropped per operation: more than one, so the backlog of
+    // a burst of expiries shrinks while every request adds at most one
+    static constexpr std::size_t EXPIRE_BUDGET = 4;
+
+    // keys whose index walks are overlapped by the batched calls: enough to
+    // keep the line fill buffers busy, few enough to stay in L1
+    static constexpr std::size_t PREFETCH_GROUP = 16;
+
+    // below this the whole cache sits in L2 and the extra pass is overhead
+    static constexpr ssize_t PREFETCH_MIN_CAPACITY = 1 << 14;
+
+    // ListLocation and ARCList enumerate the lists in the same order
+    static inline ARCList stats_list(ListLocation location)
+    {
+        return static_cast<ARCList>(location);
+    }
+
     void adapt_ghost(ListLocation location)
     {
         assert(location != ListLocation::NOT_FOUND);
 
         const auto &nominator   = (location == ListLocation::FIRST_LIST_GHOST) 
-                                ?  list_frequent_ghost_.size() : list_first_ghost_.size();
+                                ?  list_frequent_ghost_.size : list_first_ghost_.size;
 
         const auto &denominator = (location == ListLocation::FIRST_LIST_GHOST) 
-                                ? list_first_ghost_.size() : list_frequent_ghost_.size();
+                                ? list_first_ghost_.size : list_frequent_ghost_.size;
                                 
         double ratio_between_ghosts_size = static_cast<double>(nominator) / 
                                            static_cast<double>(denominator);
@@ -76,6 +243,8 @@ private:
         double max_  = std::max(1.0, ratio_between_ghosts_size);
         adapt_param_ += (location == ListLocation::FIRST_LIST_GHOST) ? max_ : -max_;
         adapt_param_ = std::clamp(adapt_param_, 0.0, static_cast<double>(capacity_)); 
+
+        stats_.on_adapt(requests_counter_, adapt_param_);
     }
 
     inline char const *get_location(ListLocation loc) const
@@ -101,119 +270,208 @@ private:
         return "UNDEFINED";
     }
 
-    inline bool not_empty_and_adaptive() const
+    // REPLACE only runs on a full cache: after expiries T1 + T2 may be
+    // short of capacity_ while B1/B2 are not, and then the free room is used
+    inline bool cache_full() const
+    {
+        return static_cast<ssize_t>(list_first_.size + list_frequent_.size) >= capacity_;
+    }
+
+    inline bool not_empty_and_adaptive(ListLocation request_location) const
     {
-        const ssize_t list_size_tmp = list_first_.size(); // size1
+        const ssize_t list_size_tmp = list_first_.size; // size1
 
         bool is_list_not_empty = list_size_tmp >= 1;
         bool is_list_adaptive_enough = list_size_tmp > static_cast<ssize_t>(adapt_param_) || 
-                                        (list_size_tmp == static_cast<ssize_t>(adapt_param_) && !list_frequent_ghost_.empty());
+                                       (list_size_tmp == static_cast<ssize_t>(adapt_param_) && 
+                                        request_location == ListLocation::FREQUENT_LIST_GHOST);
 
         return is_list_not_empty && is_list_adaptive_enough;
     }
 
+    inline GhostListType &ghost_list(ListLocation location)
+    {
+        return (location == ListLocation::FIRST_LIST_GHOST) ? list_first_ghost_ : list_frequent_ghost_;
+    }
+
+    // evicts the LRU entry of a resident list, leaving only its key behind
     inline void move_tail_to_front(
         ListType &src,
-        ListType &dest,
+        GhostListType &dest,
         ListLocation dest_location)
     {
         assert(!src.empty());
 
-        const CacheEntry tail_element = std::move(src.back());
-        src.pop_back();
+        stats_.on_eviction(dest_location == ListLocation::FIRST_LIST_GHOST ? ARCList::T1 : ARCList::T2);
+
+        NodeIndex tail_node = entries_.pop_back(src);
+        CacheEntry &entry = entries_[tail_node];
+
+        if (evicted_) evicted_(entry.key, entry.item);
+
+        cache_map_.erase(entry.key);
+        expiry_.cancel(tail_node);
+
+        NodeIndex ghost_node = ghosts_.acquire();
+        ghosts_[ghost_node] = GhostPolicy::ghost_key(std::move(entry.key));
+        ghosts_.push_front(dest, ghost_node);
+        entries_.release(tail_node);
+
+        auto [ghost_map_it, inserted] = ghost_map_.emplace(ghosts_[ghost_node], LocationInfo(dest_location, ghost_node));
+        if (!inserted)
+        {
+            // fingerprint collision: the older ghost is forgotten
+            LocationInfo &old = ghost_map_it->second;
+            stats_.on_eviction(stats_list(old.location));
+
+            ghosts_.unlink(ghost_list(old.location), old.node);
+            ghosts_.release(old.node);
 
-        dest.push_front(tail_element);
-        update_cache_map(tail_element.key, dest_location, dest.begin());
+            old = LocationInfo(dest_location, ghost_node);
+        }
     }
 
-    void replace_for_adapt()
+    void replace_for_adapt(ListLocation request_location)
     {
-        if (not_empty_and_adaptive())
-            move_tail_to_front(list_first_, list_first_ghost_, ListLocation::FREQUENT_LIST);
+        if (not_empty_and_adaptive(request_location) || list_frequent_.empty())
+            move_tail_to_front(list_first_, list_first_ghost_, ListLocation::FIRST_LIST_GHOST);
         else
-            move_tail_to_front(list_frequent_, list_frequent_, ListLocation::FREQUENT_LIST);
+            move_tail_to_front(list_frequent_, list_frequent_ghost_, ListLocation::FREQUENT_LIST_GHOST);
     }
 
-    inline void update_cache_map(const key_t &key, ListLocation location, ListIter list_it)
+    inline void move_to_dest_front(ListType &src, ListType &dest, 
+        const CacheMapIter &cache_map_it, ListLocation location)
     {
-        cache_map_[key] = LocationInfo(location, list_it);
+        entries_.move_to_front(src, dest, cache_map_it->second.node);
+        cache_map_it->second.location = location;
     }
 
-    void move_to_dest_front(ListType &src, ListType &dest, 
-        ListIter list_iterator, const ListLocation &location, const key_t &key)
+    void move_to_frequent(const CacheMapIter &cache_map_it)
     {
-        CacheEntry element = std::move(*list_iterator);
-        src.erase(list_iterator);
-
-        dest.push_front(std::move(element));
-        update_cache_map(key, location, dest.begin());
-    }
-
-    void move_to_frequent(ListLocation loc, const key_t &key, const ListIter &list_iterator)
-    {
-        const auto &tmp = *list_iterator;
-        switch(loc)
+        switch(cache_map_it->second.location)
         {
             case ListLocation::FIRST_LIST:
-                move_to_dest_front(list_first_, list_frequent_, list_iterator, loc, key);
+                move_to_dest_front(list_first_, list_frequent_, cache_map_it, ListLocation::FREQUENT_LIST);
                 break;
 
-            case ListLocation::FIRST_LIST_GHOST:
-                move_to_dest_front(list_first_ghost_, list_frequent_, list_iterator, loc, key);
+            case ListLocation::FREQUENT_LIST:
+                move_to_dest_front(list_frequent_, list_frequent_, cache_map_it, ListLocation::FREQUENT_LIST);
                 break;
-            
+
+            case ListLocation::FIRST_LIST_GHOST:
+                [[fallthrough]];
             case ListLocation::FREQUENT_LIST_GHOST:
-                move_to_dest_front(list_frequent_ghost_, list_frequent_, list_iterator, loc, key);
+                [[fallthrough]];
+            case ListLocation::NOT_FOUND:
+                assert(!"ghosts are not kept in the cache map");
                 break;
-            
-            case ListLocation::FREQUENT_LIST:
-                return;
-
         }
-        list_frequent_.push_front(tmp);
-        update_cache_map(key, ListLocation::FREQUENT_LIST, list_frequent_.begin());
     }
 
-    void handle_ghost(ListLocation location, key_t key, ListIter list_iterator)
+    // the ghost is dropped before REPLACE so that neither slab ever needs
+    // more than capacity_ nodes
+    template <typename key_arg_t, typename... item_args_t>
+    void handle_ghost(const GhostMapIter &ghost_map_it, TTL ttl, key_arg_t &&key, item_args_t &&... item_args)
     {
+        const ListLocation location = ghost_map_it->second.location;
+        const NodeIndex ghost_node  = ghost_map_it->second.node;
+
+        stats_.on_ghost_hit(stats_list(location));
+        ghost_hits_counter_++;
         adapt_ghost(location);
-        replace_for_adapt();
-        move_to_frequent(location, key, list_iterator);
+
+        ghosts_.unlink(ghost_list(location), ghost_node);
+        ghosts_.release(ghost_node);
+        ghost_map_.erase(ghost_map_it);
+
+        if (cache_full())
+            replace_for_adapt(location);
+
+        insert_entry(list_frequent_, ListLocation::FREQUENT_LIST, ttl,
+                     std::forward<key_arg_t>(key), std::forward<item_args_t>(item_args)...);
     }
 
-    bool handle_existing_item(const CacheMapIter &cache_map_it, const key_t &key)
+    inline bool handle_existing_item(const CacheMapIter &cache_map_it)
     {      
-        ListLocation location  = cache_map_it->second.location;
-        ListIter list_iterator = cache_map_it->second.list_iter;
+        stats_.on_hit(stats_list(cache_map_it->second.location));
+        move_to_frequent(cache_map_it);
+        hits_counter_++;
+        return true;
+    }
+
+    inline void remove_ghost_tail(GhostListType &list, ListLocation location)
+    {
+        stats_.on_eviction(stats_list(location));
+
+        NodeIndex tail_node = ghosts_.pop_back(list);
+
+        ghost_map_.erase(ghosts_[tail_node]);
+        ghosts_.release(tail_node);
+    }
 
-        switch(location)
+    inline void remove_tail(ListType &list, ListLocation location)
+    {
+        stats_.on_eviction(stats_list(location));
+
+        NodeIndex tail_node = entries_.pop_back(list);
+
+        if (evicted_) evicted_(entries_[tail_node].key, entries_[tail_node].item);
+
+        cache_map_.erase(entries_[tail_node].key);
+        expiry_.cancel(tail_node);
+        entries_.release(tail_node);
+    }
+
+    // the oldest ghost of B1 while L1 = T1 + B1 is at c, else of B2
+    inline void drop_ghost()
+    {
+        const bool first_full = static_cast<ssize_t>(list_first_.size + list_first_ghost_.size) >= capacity_;
+
+        if (!list_first_ghost_.empty() && (first_full || list_frequent_ghost_.empty()))
+            remove_ghost_tail(list_first_ghost_, ListLocation::FIRST_LIST_GHOST);
+        else if (!list_frequent_ghost_.empty())
+            remove_ghost_tail(list_frequent_ghost_, ListLocation::FREQUENT_LIST_GHOST);
+    }
+
+    // an expired entry just leaves: no ghost is kept and p does not move,
+    // since its age says nothing about recency or frequency
+    void remove_expired(const CacheMapIter &cache_map_it)
+    {
+        const NodeIndex node = cache_map_it->second.node;
+
+        ListType &list = (cache_map_it->second.location == ListLocation::FIRST_LIST)
+                       ? list_first_ : list_frequent_;
+
+        stats_.on_expire();
+
+        entries_.unlink(list, node);
+        expiry_.cancel(node);
+        cache_map_.erase(cache_map_it);
+        entries_.release(node);
+    }
+
+    inline void expire_due()
+    {
+        if constexpr (expiry_t::ENABLED)
         {
-            case ListLocation::FIRST_LIST:
-                move_to_frequent(location, key, list_iterator);             
-                [[fallthrough]];
-            case ListLocation::FREQUENT_LIST: 
-                hits_counter_++;
-                return true;
+            expiry_.advance();
 
-            case ListLocation::FIRST_LIST_GHOST:
-                [[fallthrough]];
-            case ListLocation::FREQUENT_LIST_GHOST:
-                handle_ghost(location, key, list_iterator);
-                return false;
-                
-            case ListLocation::NOT_FOUND:
-                return false;
-        };
+            for (std::size_t i = 0; i < EXPIRE_BUDGET; i++)
+            {
+                const NodeIndex node = expiry_.pop_expired();
+                if (node == NIL_NODE) break;
 
-        return false;
+                remove_expired(cache_map_.find(entries_[node].key));
+            }
+        }
     }
 
     inline void handle_cache_overflow()
     {
-        ssize_t list1_size   = list_first_.size();
-        ssize_t list1gh_size = list_first_ghost_.size();
-        ssize_t list2_size   = list_frequent_.size();
-        ssize_t list2gh_size = list_frequent_ghost_.size();
+        ssize_t list1_size   = list_first_.size;
+        ssize_t list1gh_size = list_first_ghost_.size;
+        ssize_t list2_size   = list_frequent_.size;
+        ssize_t list2gh_size = list_frequent_ghost_.size;
 
         ssize_t sum_size_lists = list1_size + list2_size + list1gh_size + list2gh_size;
         if (list1_size + list1gh_size == capacity_)
@@ -221,41 +479,254 @@ private:
             if (list1_size < capacity_)
             {
                 if (!list_first_ghost_.empty())
-                {
-                    cache_map_.erase(list_first_ghost_.back().key);
-                    list_first_ghost_.pop_back();
-                }
-                replace_for_adapt();
+                    remove_ghost_tail(list_first_ghost_, ListLocation::FIRST_LIST_GHOST);
+
+                if (cache_full())
+                    replace_for_adapt(ListLocation::NOT_FOUND);
             }
             else
-            {
-                if (!cache_map_.empty())
-                {
-                    cache_map_.erase(list_first_.back().key);
-                    list_first_.pop_back();
-                }
-            }
+                remove_tail(list_first_, ListLocation::FIRST_LIST);
         }
         else if (list1_size + list1gh_size < capacity_ && sum_size_lists >= capacity_)      
         {    
             if (sum_size_lists == 2 * capacity_)
             { 
                 if (!list_frequent_ghost_.empty())
-                {    
-                    cache_map_.erase(list_frequent_ghost_.back().key);
-                    list_frequent_ghost_.pop_back();       
-                }
+                    remove_ghost_tail(list_frequent_ghost_, ListLocation::FREQUENT_LIST_GHOST);
             }
-            replace_for_adapt();
+
+            if (cache_full())
+                replace_for_adapt(ListLocation::NOT_FOUND);
         }
     }
 
-    void add_new_item(const key_t &key, const item_t &item)
+    // an item is assigned over the old one only from what converts to it
+    // implicitly; anything else (a std::string from an int) is constructed
+    template <typename item_arg_t>
+    static inline void assign_item(item_t &item, item_arg_t &&item_arg)
+    {
+        if constexpr (std::is_convertible<item_arg_t &&, item_t>::value &&
+                      std::is_assignable<item_t &, item_arg_t &&>::value)
+            item = std::forward<item_arg_t>(item_arg);
+        else
+            item = item_t(std::forward<item_arg_t>(item_arg));
+    }
+
+    // the key and the item are built straight into the recycled node, so a
+    // string keeps the buffer it had there when the new value fits; the
+    // index gets its own copy of the key
+    template <typename key_arg_t, typename... item_args_t>
+    void insert_entry(ListType &list, ListLocation location, TTL ttl, key_arg_t &&key, item_args_t &&... item_args)
     {
+        NodeIndex node = entries_.acquire();
+        CacheEntry &entry = entries_[node];
+
+        if constexpr (std::is_assignable<key_t &, key_arg_t &&>::value)
+            entry.key = std::forward<key_arg_t>(key);
+        else
+            entry.key = key_t(std::forward<key_arg_t>(key));
+
+        if constexpr (sizeof...(item_args_t) == 1)
+            assign_item(entry.item, std::forward<item_args_t>(item_args)...);
+        else
+            entry.item = item_t(std::forward<item_args_t>(item_args)...);
+
+        entries_.push_front(list, node);
+        expiry_.schedule(node, ttl);
+
+        cache_map_.emplace(entry.key, LocationInfo(location, node));
+    }
+
+    template <typename key_arg_t, typename... item_args_t>
+    void add_new_item(TTL ttl, key_arg_t &&key, item_args_t &&... item_args)
+    {
+        stats_.on_miss();
         handle_cache_overflow();
 
-        list_first_.push_front(CacheEntry(key, item));
-        update_cache_map(key, ListLocation::FIRST_LIST, list_first_.begin());
+        insert_entry(list_first_, ListLocation::FIRST_LIST, ttl,
+                     std::forward<key_arg_t>(key), std::forward<item_args_t>(item_args)...);
+    }
+
+    // find() by whatever the key came as: as is where the index is
+    // heterogeneous, else through a temporary of its key type
+    template <typename map_type, typename lookup_t>
+    static inline auto index_find(map_type &map, const lookup_t &key)
+    {
+        using index_key_t = typename std::remove_const<map_type>::type::key_type;
+
+        if constexpr (std::is_same<lookup_t, index_key_t>::value ||
+                      HeterogeneousIndex<typename std::remove_const<map_type>::type>::ENABLED)
+            return map.find(key);
+        else
+            return map.find(index_key_t(key));
+    }
+
+    // index_find() with a bounded probe where the index has one
+    template <typename map_type, typename lookup_t>
+    static inline auto index_find_bounded(const map_type &map, const lookup_t &key)
+    {
+        using index_key_t = typename map_type::key_type;
+
+        if constexpr (!BoundedIndexFind<map_type>::ENABLED)
+            return index_find(map, key);
+        else if constexpr (std::is_same<lookup_t, index_key_t>::value || HeterogeneousIndex<map_type>::ENABLED)
+            return map.find_bounded(key);
+        else
+            return map.find_bounded(index_key_t(key));
+    }
+
+    // nothing is built from key_arg and item_args on a hit
+    template <typename key_arg_t, typename... item_args_t>
+    bool process_request(TTL ttl, key_arg_t &&key, item_args_t &&... item_args)
+    {
+        if (capacity_ <= 0) return false;
+
+        requests_counter_++;
+        expire_due();
+        
+        CacheMapIter cache_map_it = index_find(cache_map_, key); 
+
+        if (cache_map_it != cache_map_.end())
+        {
+            if (!expiry_.expired(cache_map_it->second.node))
+                return handle_existing_item(cache_map_it);
+
+            // a stale hit is a miss: the entry goes now, not in its turn
+            remove_expired(cache_map_it);
+        }
+
+        GhostMapIter ghost_map_it = index_find(ghost_map_, GhostPolicy::ghost_key(key));
+
+        if (ghost_map_it != ghost_map_.end())
+            handle_ghost(ghost_map_it, ttl, std::forward<key_arg_t>(key), std::forward<item_args_t>(item_args)...);
+        else                           
+            add_new_item(ttl, std::forward<key_arg_t>(key), std::forward<item_args_t>(item_args)...);
+
+        return false; 
+    }
+
+    template <typename key_arg_t, typename... item_args_t>
+    bool timed_request(TTL ttl, key_arg_t &&key, item_args_t &&... item_args)
+    {
+        if constexpr (stats_t::ENABLED)
+        {
+            if (stats_.sample_latency())
+            {
+                const auto start = std::chrono::steady_clock::now();
+                const bool is_hit = process_request(ttl, std::forward<key_arg_t>(key),
+                                                    std::forward<item_args_t>(item_args)...);
+                const auto end = std::chrono::steady_clock::now();
+
+                stats_.record_latency(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+                return is_hit;
+            }
+        }
+
+        return process_request(ttl, std::forward<key_arg_t>(key), std::forward<item_args_t>(item_args)...);
+    }
+
+    // walks the index for a group of keys one step at a time, control
+    // bytes first and then the slot, so their cache misses overlap. Nothing
+    // changes state here: when an earlier request of the group moves a
+    // later key, the stale slot only costs a wasted prefetch
+    template <typename key_at_t>
+    void prefetch_group(const key_at_t &key_at, std::size_t amount) const
+    {
+        std::size_t hashes[PREFETCH_GROUP];
+
+        for (std::size_t i = 0; i < amount; i++)
+        {
+            hashes[i] = cache_map_.hash(key_at(i));
+            cache_map_.prefetch(hashes[i]);
+        }
+
+        for (std::size_t i = 0; i < amount; i++)
+            cache_map_.prefetch_slot(hashes[i]);
+    }
+
+    inline bool worth_prefetch() const { return capacity_ >= PREFETCH_MIN_CAPACITY; }
+
+    // back to an empty cache of the same capacity; the counters stay
+    void reset()
+    {
+        entries_.for_each(list_first_,    [&](NodeIndex node, const CacheEntry &) { expiry_.cancel(node); });
+        entries_.for_each(list_frequent_, [&](NodeIndex node, const CacheEntry &) { expiry_.cancel(node); });
+
+        entries_ = SlabType(capacity_);
+        ghosts_  = GhostSlabType(capacity_);
+
+        list_first_       = ListType();
+        list_frequent_    = ListType();
+        list_first_ghost_ = GhostListType();
+        list_frequent_ghost_ = GhostListType();
+
+        cache_map_.clear();
+        ghost_map_.clear();
+
+        adapt_param_ = 0.0;
+    }
+
+    // snapshot lists come LRU first, so every entry goes to the front in
+    // turn; the first skip entries, the least recent, are left out
+    template <typename snapshot_t>
+    void restore_list(const snapshot_t &snapshot, ARCList list, std::size_t skip)
+    {
+        const ListLocation location = static_cast<ListLocation>(list);
+        ListType &dest = (list == ARCList::T1) ? list_first_ : list_frequent_;
+
+        for (std::size_t i = skip; i < snapshot.size(list); i++)
+        {
+            const key_t &key = snapshot.key(list, i);
+            if (cache_map_.find(key) != cache_map_.end())
+            {
+                LOG_WARNING("ARC snapshot", "duplicate key skipped: ", key);
+                continue;
+            }
+
+            NodeIndex node = entries_.acquire();
+            entries_[node] = CacheEntry(key, snapshot.item(list, i));
+            entries_.push_front(dest, node);
+            expiry_.schedule(node, expiry_.default_ttl());
+
+            cache_map_.emplace(key, LocationInfo(location, node));
+        }
+    }
+
+    template <typename snapshot_t>
+    void restore_ghost_list(const snapshot_t &snapshot, ARCList list, std::size_t skip)
+    {
+        const ListLocation location = static_cast<ListLocation>(list);
+        GhostListType &dest = ghost_list(location);
+
+        for (std::size_t i = skip; i < snapshot.size(list); i++)
+        {
+            const GhostKey &ghost_key = snapshot.ghost_key(list, i);
+            if (ghost_map_.find(ghost_key) != ghost_map_.end())
+                continue;
+
+            NodeIndex node = ghosts_.acquire();
+            ghosts_[node] = ghost_key;
+            ghosts_.push_front(dest, node);
+
+            ghost_map_.emplace(ghost_key, LocationInfo(location, node));
+        }
+    }
+
+    template <typename map_key_t, typename map_value_t, typename hash_t, typename key_equal_t>
+    static std::size_t index_memory(const std::unordered_map<map_key_t, map_value_t, hash_t, key_equal_t> &map)
+    {
+        // bucket array plus one node (next pointer, cached hash, value) per key
+        using node_size = std::integral_constant<std::size_t,
+            sizeof(void *) + sizeof(std::size_t) + sizeof(std::pair<const map_key_t, map_value_t>)>;
+
+        return map.bucket_count() * sizeof(void *) + map.size() * node_size::value;
+    }
+
+    template <typename map_key_t, typename map_value_t, typename hash_t, typename key_equal_t>
+    static std::size_t index_memory(const FlatHashMap<map_key_t, map_value_t, hash_t, key_equal_t> &map)
+    {
+        return map.memory_usage();
     }
 
 
@@ -265,19 +736,26 @@ private:
         for (const auto &pair : cache_map)
         {
             const LocationInfo &loc_info = pair.second;
-            const ListIter     &list_it  = loc_info.list_iter;
+            const NodeIndex    &node     = loc_info.node;
 
             LOG_DUMP("Cache map", 
-                "key = ", pair.first, "\nitem location: ", get_location(loc_info.location));
+                "key = ", log_value(pair.first), "\nitem location: ", get_location(loc_info.location));
             
-            if (list_it != ListIter())
-                LOG_DUMP("List iterator in cache map", " item: ", list_it->item,
-                "\nkey by cache info: ", list_it->key); 
+            if (node != NIL_NODE)
+                LOG_DUMP("Node index in cache map", " item: ", log_value(entries_[node].item),
+                "\nkey by cache info: ", log_value(entries_[node].key)); 
             else 
-                LOG_DUMP("List iterator in cache map", " INVALID ITERATOR");
+                LOG_DUMP("Node index in cache map", " INVALID NODE");
         }
     }
 
+    void ghost_map_dump(const GhostMapType &ghost_map) const
+    {
+        for (const auto &pair : ghost_map)
+            LOG_DUMP("Ghost map", 
+                "ghost key = ", log_value(pair.first), "\nlocation: ", get_location(pair.second.location));
+    }
+
     inline char const * list_header(const ListLocation which_list) const
     {
         switch(which_list)
@@ -304,23 +782,115 @@ private:
     void list_dump(const ListType &list, const ListLocation which_list) const
     {
         ssize_t i = 0;
-        ssize_t size = list.size();
-        for (const auto &cache : list) 
+        entries_.for_each(list, [&](NodeIndex, const CacheEntry &cache)
         {
-            item_t item = cache.item;
-            key_t  key  = cache.key;
+            const item_t &item = cache.item;
+            const key_t  &key  = cache.key;
 
-            LOG_DUMP(list_header(which_list), "[ item", i++, " = ", item, "(cache_map key: ", key,  ") ]");
-        }
+            LOG_DUMP(list_header(which_list), "[ item", i++, " = ", log_value(item), "(cache_map key: ", log_value(key),  ") ]");
+        });
+    }
+
+    void list_dump(const GhostListType &list, const ListLocation which_list) const
+    {
+        ssize_t i = 0;
+        ghosts_.for_each(list, [&](NodeIndex, const GhostKey &ghost_key)
+        {
+            LOG_DUMP(list_header(which_list), "[ ghost", i++, " key: ", log_value(ghost_key), " ]");
+        });
     }
 
 public:
-    explicit ARCCache() : capacity_(0), hits_counter_(0), adapt_param_(0.0)  
+    using key_type       = key_t;
+    using item_type      = item_t;
+    using ghost_key_type = GhostKey;
+
+    // A frozen copy of the whole ARC state. The slabs are copied wholesale,
+    // so taking one pauses the cache for a copy of its arrays and nothing
+    // more; walking the lists and encoding the items (write_arc_snapshot)
+    // then runs on any thread while the cache keeps serving
+    class StateCopy
+    {
+    private:
+        friend class ARCCache;
+
+        ssize_t       capacity_;
+        double        adapt_param_;
+        SlabType      entries_;
+        GhostSlabType ghosts_;
+        ListType      lists_[2];
+        GhostListType ghost_lists_[2];
+
+        StateCopy(const ARCCache &cache)
+            : capacity_(cache.capacity_), adapt_param_(cache.adapt_param_),
+              entries_(cache.entries_), ghosts_(cache.ghosts_),
+              lists_{cache.list_first_, cache.list_frequent_},
+              ghost_lists_{cache.list_first_ghost_, cache.list_frequent_ghost_} {}
+
+        // same-size slabs are assigned in place, so a copy kept from the
+        // last snapshot takes the next one without touching fresh pages
+        void assign(const ARCCache &cache)
+        {
+            capacity_       = cache.capacity_;
+            adapt_param_    = cache.adapt_param_;
+            entries_        = cache.entries_;
+            ghosts_         = cache.ghosts_;
+            lists_[0]       = cache.list_first_;
+            lists_[1]       = cache.list_frequent_;
+            ghost_lists_[0] = cache.list_first_ghost_;
+            ghost_lists_[1] = cache.list_frequent_ghost_;
+        }
+
+        inline const ListType &resident(ARCList list) const
+        {
+            return lists_[(list == ARCList::T1) ? 0 : 1];
+        }
+
+        inline const GhostListType &ghost(ARCList list) const
+        {
+            return ghost_lists_[(list == ARCList::B1) ? 0 : 1];
+        }
+
+    public:
+        using key_type       = key_t;
+        using item_type      = item_t;
+        using ghost_key_type = GhostKey;
+
+        StateCopy() : capacity_(0), adapt_param_(0.0), entries_(), ghosts_(), lists_(), ghost_lists_() {}
+
+        inline ssize_t capacity()    const { return capacity_; }
+        inline double  adapt_param() const { return adapt_param_; }
+
+        inline std::size_t size(ARCList list) const
+        {
+            return (list == ARCList::T1 || list == ARCList::T2) ? resident(list).size : ghost(list).size;
+        }
+
+        // T1/T2, least recent first: func(key, item)
+        template <typename func_t>
+        void for_each_entry(ARCList list, func_t &&func) const
+        {
+            for (NodeIndex it = resident(list).tail; it != NIL_NODE; it = entries_.prev(it))
+                func(entries_[it].key, entries_[it].item);
+        }
+
+        // B1/B2, least recent first: func(ghost_key)
+        template <typename func_t>
+        void for_each_ghost(ARCList list, func_t &&func) const
+        {
+            for (NodeIndex it = ghost(list).tail; it != NIL_NODE; it = ghosts_.prev(it))
+                func(ghosts_[it]);
+        }
+    };
+
+    explicit ARCCache() : capacity_(0), hits_counter_(0), requests_counter_(0), ghost_hits_counter_(0), adapt_param_(0.0),
+                          entries_(), ghosts_()  
     {
  //       HtmlLogger::init("CacheDriver");
     }
 
-    explicit ARCCache(ssize_t capacity) : capacity_(capacity), hits_counter_(0), adapt_param_(0.0) 
+    explicit ARCCache(ssize_t capacity) : capacity_(capacity), hits_counter_(0), requests_counter_(0), ghost_hits_counter_(0),
+                                          adapt_param_(0.0), entries_(), ghosts_() 
     {
         LOG_INFO("OPT_Cache", "Cache initialized with capacity: ", capacity);
         
@@ -330,33 +900,318 @@ public:
             capacity_ = STD_CAPACITY;
         }
 
+        entries_.reserve(capacity_);
+        ghosts_.reserve(capacity_);
+        expiry_.reserve(capacity_);
+        cache_map_.reserve(capacity_);
+        ghost_map_.reserve(capacity_);
     }
 
-    item_t get_item(const key_t &key) const
+    // for an expiry_t with its own tick or default TTL
+    explicit ARCCache(ssize_t capacity, const expiry_t &expiry) : ARCCache(capacity)
     {
-        CacheMapIter cache_map_it = cache_map_.find(key);
+        expiry_ = expiry;
+        expiry_.reserve(capacity_);
+    }
+
+    template <typename lookup_t>
+    item_t get_item(const lookup_t &key) const
+    {
+        CacheMapConstIter cache_map_it = index_find(cache_map_, key);
         
             if (cache_map_it == cache_map_.end()) return item_t();
 
-        return cache_map_it->second.list_iter->item;
+        if (expiry_.expired_now(cache_map_it->second.node)) return item_t();
+
+        return entries_[cache_map_it->second.node].item;
     }
 
-    bool add_cache(const key_t &key, const item_t &item)
+    // lookup of a resident entry that does not touch ARC state. The probe
+    // is bounded and the node is range-checked, so a caller validating the
+    // read afterwards (a seqlock) may run it concurrently with a writer as
+    // long as the index and slabs never reallocate
+    template <typename lookup_t>
+    bool peek(const lookup_t &key, item_t &item) const
     {
-        if (capacity_ <= 0) return false;
-        
-        CacheMapIter cache_map_it = cache_map_.find(key); 
+        CacheMapConstIter cache_map_it = index_find_bounded(cache_map_, key);
+        if (cache_map_it == cache_map_.end()) return false;
 
-        if (cache_map_it != cache_map_.end()) 
-            return handle_existing_item(cache_map_it, key);
-        else                           
-        { 
-            add_new_item(key, item); 
-            return false; 
+        const NodeIndex node = cache_map_it->second.node;
+        if (node >= entries_.capacity()) return false;
+
+        if constexpr (expiry_t::ENABLED)
+        {
+            if (expiry_.expired_now(node)) return false;
         }
+
+        item = entries_[node].item;
+        return true;
+    }
+
+    // applies the list move of a hit that was already counted elsewhere
+    bool promote(const key_t &key)
+    {
+        CacheMapIter cache_map_it = cache_map_.find(key);
+        if (cache_map_it == cache_map_.end()) return false;
+
+        move_to_frequent(cache_map_it);
+        return true;
+    }
+
+    inline bool add_cache(const key_t &key, const item_t &item)
+    {
+        return timed_request(expiry_.default_ttl(), key, item);
+    }
+
+    // a missed key and its item are moved into the cache, so move-only
+    // items go through here or through emplace
+    inline bool add_cache(key_t &&key, item_t &&item)
+    {
+        return timed_request(expiry_.default_ttl(), std::move(key), std::move(item));
+    }
+
+    // ttl applies if the request admits the key; a hit keeps the deadline
+    // and the item it has. Without an expiry_t policy ttl is ignored
+    inline bool add_cache(const key_t &key, const item_t &item, TTL ttl)
+    {
+        return timed_request(ttl, key, item);
+    }
+
+    inline bool add_cache(key_t &&key, item_t &&item, TTL ttl)
+    {
+        return timed_request(ttl, std::move(key), std::move(item));
+    }
+
+    // add_cache that builds the key and the item only when the request
+    // admits the key: item_args construct the item, and key may be any type
+    // the index looks keys up by (a std::string_view for std::string keys),
+    // so a hit builds neither
+    template <typename key_arg_t, typename... item_args_t>
+    inline bool emplace(key_arg_t &&key, item_args_t &&... item_args)
+    {
+        return timed_request(expiry_.default_ttl(), std::forward<key_arg_t>(key),
+                             std::forward<item_args_t>(item_args)...);
+    }
+
+    inline const stats_t &stats() const { return stats_; }
+
+    inline StateCopy copy_state() const { return StateCopy(*this); }
+
+    inline void copy_state(StateCopy &copy) const { copy.assign(*this); }
+
+    // Replaces the whole state with the one a snapshot describes: list
+    // order, p and items. A smaller cache keeps the most recent part of
+    // every list in proportion (p scales too), so the ARC invariants hold
+    // at any capacity. TTLs start over from the default one. snapshot_t
+    // is MappedSnapshot or anything with its accessors
+    template <typename snapshot_t>
+    void restore(const snapshot_t &snapshot)
+    {
+        if (capacity_ <= 0)
+        {
+            LOG_ERROR("ARC snapshot", "capacity is INVALID, nothing restored");
+            return;
+        }
+
+        reset();
+
+        const std::size_t capacity = static_cast<std::size_t>(capacity_);
+        const std::size_t from     = std::max<std::size_t>(1, snapshot.capacity());
+
+        auto skipped = [&](ARCList list)
+        {
+            const std::size_t size = snapshot.size(list);
+            return (capacity >= from) ? 0 : size - size * capacity / from;
+        };
+
+        const double scale = (capacity >= from) ? 1.0 : static_cast<double>(capacity) / static_cast<double>(from);
+        adapt_param_ = std::clamp(snapshot.adapt_param() * scale, 0.0, static_cast<double>(capacity_));
+
+        restore_ghost_list(snapshot, ARCList::B1, skipped(ARCList::B1));
+        restore_ghost_list(snapshot, ARCList::B2, skipped(ARCList::B2));
+        restore_list(snapshot, ARCList::T1, skipped(ARCList::T1));
+        restore_list(snapshot, ARCList::T2, skipped(ARCList::T2));
+
+        LOG_INFO("ARC snapshot", "restored t1: ", list_first_.size, " t2: ", list_frequent_.size,
+                 " b1: ", list_first_ghost_.size, " b2: ", list_frequent_ghost_.size, " p: ", adapt_param_);
+    }
+
+    // handler(key, item) sees every resident entry the cache drops for
+    // room, just before its item goes: the T1/T2 victims of REPLACE, the T1
+    // tail dropped without a ghost when |T1| = c (case IV), and what
+    // set_capacity evicts on a shrink. Expired entries and entries replaced
+    // by restore do not go through it. The handler must not call back into
+    // this cache
+    inline void set_eviction_handler(EvictionHandler handler) { evicted_ = std::move(handler); }
+
+    // Resizes the cache in place. Growing reserves the slabs, the indexes
+    // and the expiry wheel for the new size up front, so peek() callers
+    // must not run across it. Shrinking runs REPLACE until T1 + T2 fit and
+    // then drops the oldest ghosts until |T1| + |B1| <= c and the whole
+    // directory <= 2c; the eviction handler sees those entries as usual.
+    // p scales with c. The slabs keep their nodes, so growing back to an
+    // earlier size allocates nothing
+    bool set_capacity(ssize_t capacity)
+    {
+        if (capacity <= 0)
+        {
+            LOG_ERROR("ARC cache", "capacity is INVALID, kept ", capacity_);
+            return false;
+        }
+
+        if (capacity_ > 0)
+            adapt_param_ = adapt_param_ * static_cast<double>(capacity) / static_cast<double>(capacity_);
+
+        capacity_    = capacity;
+        adapt_param_ = std::clamp(adapt_param_, 0.0, static_cast<double>(capacity_));
+
+        entries_.reserve(capacity_);
+        ghosts_.reserve(capacity_);
+        expiry_.reserve(capacity_);
+        cache_map_.reserve(capacity_);
+        ghost_map_.reserve(capacity_);
+
+        while (static_cast<ssize_t>(list_first_.size + list_frequent_.size) > capacity_)
+        {
+            // room for the ghost REPLACE leaves, so the ghost slab never
+            // grows on the way down
+            if (static_cast<ssize_t>(list_first_ghost_.size + list_frequent_ghost_.size) >= capacity_)
+                drop_ghost();
+
+            replace_for_adapt(ListLocation::NOT_FOUND);
+        }
+
+        while (static_cast<ssize_t>(list_first_.size + list_first_ghost_.size) > capacity_)
+            remove_ghost_tail(list_first_ghost_, ListLocation::FIRST_LIST_GHOST);
+
+        while (static_cast<ssize_t>(list_first_.size + list_frequent_.size +
+                                    list_first_ghost_.size + list_frequent_ghost_.size) > 2 * capacity_)
+            remove_ghost_tail(list_frequent_ghost_, ListLocation::FREQUENT_LIST_GHOST);
+
+        return true;
+    }
+
+    inline ssize_t capacity() const { return capacity_; }
+
+    // resident entries, T1 + T2
+    inline std::size_t size() const { return list_first_.size + list_frequent_.size; }
+
+    inline expiry_t       &expiry()       { return expiry_; }
+    inline const expiry_t &expiry() const { return expiry_; }
+
+    // the hit half of add_cache: the resident item, or nullptr on a miss
+    // (an expired entry is one). The pointer stays valid until the next
+    // call that changes the cache. A miss is not counted here, the caller
+    // inserts the loaded item with add_cache or emplace and that counts it;
+    // a caller that inserts nothing counts it with count_miss()
+    template <typename lookup_t>
+    item_t *lookup(const lookup_t &key)
+    {
+        if (capacity_ <= 0) return nullptr;
+
+        expire_due();
+
+        CacheMapIter cache_map_it = index_find(cache_map_, key);
+        if (cache_map_it == cache_map_.end()) return nullptr;
+
+        if (expiry_.expired(cache_map_it->second.node))
+        {
+            remove_expired(cache_map_it);
+            return nullptr;
+        }
+
+        requests_counter_++;
+        handle_existing_item(cache_map_it);
+        return &entries_[cache_map_it->second.node].item;
+    }
+
+    // lookup that copies the item out
+    template <typename lookup_t>
+    bool lookup(const lookup_t &key, item_t &item)
+    {
+        const item_t *cached = lookup(key);
+        if (cached == nullptr) return false;
+
+        item = *cached;
+        return true;
+    }
+
+    // read-through access: on a miss loader(key) produces the item, which
+    // then goes through the usual ARC admission
+    template <typename lookup_t, typename loader_t>
+    item_t get_or_load(const lookup_t &key, loader_t &&loader)
+    {
+        if (const item_t *cached = lookup(key)) return *cached;
+
+        item_t item = loader(key);
+        emplace(key, item);
+        return item;
     }
     
-    ssize_t run_cache(const std::vector<std::pair<key_t, item_t>> &input_key_item) override
+    // add_cache over a batch, with the index walks of each PREFETCH_GROUP
+    // requests overlapped first. The transitions still run one request at
+    // a time in order, so hits and final state are those of add_cache
+    ssize_t add_cache_batch(RequestSpan<key_t, item_t> batch)
+    {
+        const ssize_t hits_before = hits_counter_;
+
+        for (std::size_t start = 0; start < batch.size(); start += PREFETCH_GROUP)
+        {
+            const std::size_t amount = std::min(PREFETCH_GROUP, batch.size() - start);
+
+            if constexpr (IndexPrefetch<CacheMapType>::ENABLED)
+            {
+                if (worth_prefetch())
+                    prefetch_group([&](std::size_t i) -> const key_t & { return batch.key(start + i); }, amount);
+            }
+
+            for (std::size_t i = start; i < start + amount; i++)
+                add_cache(batch.key(i), batch.item(i));
+        }
+
+        return hits_counter_ - hits_before;
+    }
+
+    // a request that lookup() missed and that will not be inserted
+    inline void count_miss()
+    {
+        requests_counter_++;
+        stats_.on_miss();
+    }
+
+    // lookup over a batch, prefetched the same way: found[i] tells whether
+    // items[i] now holds the item of keys[i]; returns how many were found.
+    // Nothing is inserted, so every key not found is counted as a miss here
+    // and the request count grows by amount
+    std::size_t get_batch(const key_t *keys, std::size_t amount, item_t *items, bool *found)
+    {
+        std::size_t found_amount = 0;
+
+        for (std::size_t start = 0; start < amount; start += PREFETCH_GROUP)
+        {
+            const std::size_t group = std::min(PREFETCH_GROUP, amount - start);
+
+            if constexpr (IndexPrefetch<CacheMapType>::ENABLED)
+            {
+                if (worth_prefetch())
+                    prefetch_group([&](std::size_t i) -> const key_t & { return keys[start + i]; }, group);
+            }
+
+            for (std::size_t i = start; i < start + group; i++)
+            {
+                found[i] = lookup(keys[i], items[i]);
+                found_amount += found[i];
+
+                if (!found[i]) count_miss();
+            }
+        }
+
+        return found_amount;
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
     {
         if (capacity_ <= 0)
         {
@@ -364,16 +1219,63 @@ public:
             return 0;
         }
         
-        for (ssize_t i = 0; i < input_key_item.size(); i++)
-            add_cache(input_key_item[i].first, input_key_item[i].second);
+        feed(input_key_item);
+        return finish();
+    }
 
-        return get_hit_count();
+    // ARC decides every request on arrival, so a batch is simply replayed.
+    // A span hands out copies of its items, so move-only ones can not be;
+    // that throws, since logging is compiled out of release builds and a
+    // dropped batch would look like a run with no hits
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        if constexpr (std::is_copy_constructible<item_t>::value)
+            add_cache_batch(batch);
+        else
+        {
+            LOG_ERROR("ARC cache", "MOVE-ONLY ITEMS can not be replayed, use add_cache or emplace");
+            throw std::logic_error("ARCCache::feed: move-only items can not be replayed, use add_cache or emplace");
+        }
     }
 
+    inline ssize_t finish() override { return get_hit_count(); }
+
     ~ARCCache() = default;
     //{ HtmlLogger::close(); }
 
     inline ssize_t get_hit_count() const override { return hits_counter_; }
+
+    inline ssize_t get_request_count() const override { return requests_counter_; }
+
+    // requests that found their key in B1 or B2: each one would have been
+    // a hit in a larger cache, which makes their rate the marginal value
+    // of more capacity
+    inline ssize_t get_ghost_hit_count() const { return ghost_hits_counter_; }
+
+    // resident bytes of the slabs and both indexes
+    std::size_t memory_usage() const
+    {
+        return entries_.memory_usage() + ghosts_.memory_usage() +
+               index_memory(cache_map_) + index_memory(ghost_map_);
+    }
+
+    // keys in T1, T2, B1 and B2, which is what memory_usage() pays for
+    inline std::size_t tracked_count() const
+    {
+        return list_first_.size + list_frequent_.size + list_first_ghost_.size + list_frequent_ghost_.size;
+    }
+
+    void print_memory_report() const
+    {
+        const std::size_t tracked = tracked_count();
+        const std::size_t bytes   = memory_usage();
+
+        std::cout << "memory: " << bytes << " bytes, tracked keys: " << tracked;
+        if (tracked != 0)
+            std::cout << ", bytes per tracked key: " << static_cast<double>(bytes) / tracked;
+
+        std::cout << std::endl;
+    }
     
     inline void print_hit_count() const override
     {
@@ -382,6 +1284,7 @@ public:
 
     void dump() const override
     {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
 
         LOG_DUMP("Adaptive replacement cache DUMP",
         "capacity: ", capacity_,
@@ -389,6 +1292,7 @@ public:
         "\nadadptive parametr:", static_cast<double>(adapt_param_));
 
         cache_map_dump(cache_map_);
+        ghost_map_dump(ghost_map_);
 
         list_dump(list_first_, ListLocation::FIRST_LIST);
         list_dump(list_frequent_, ListLocation::FREQUENT_LIST);
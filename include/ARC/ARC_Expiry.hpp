@@ -0,0 +1,122 @@
+#ifndef ARC_EXPIRY_HPP
+#define ARC_EXPIRY_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <time.h>
+
+#include "utils/timing_wheel/timing_wheel.hpp"
+
+// ARCCache asks an expiry_t policy when its entries go stale. NoExpiry, the
+// default, never expires anything and reads no clock. WheelExpiry keeps a
+// deadline per cache node in a TimingWheel: the cache advances it once per
+// operation and drops a few due entries each time, so expiry costs a clock
+// read and O(1) work per request and no thread ever scans the cache.
+struct NoExpiry
+{
+    static constexpr bool ENABLED = false;
+
+    using id_t     = TimingWheel::id_t;
+    using duration = std::chrono::nanoseconds;
+
+    inline void reserve(std::size_t) {}
+
+    inline duration default_ttl() const { return duration::zero(); }
+
+    inline void schedule(id_t, duration) {}
+    inline void cancel(id_t) {}
+
+    inline void advance() {}
+    inline id_t pop_expired() { return TimingWheel::NIL; }
+
+    inline bool expired(id_t) const     { return false; }
+    inline bool expired_now(id_t) const { return false; }
+};
+
+#ifdef CLOCK_MONOTONIC_COARSE
+// steady clock at the kernel tick (1-4 ms) that reads in a few ns instead
+// of the tens a precise read takes under some hypervisors; pair it with a
+// wheel tick no finer than its resolution
+struct CoarseSteadyClock
+{
+    using duration   = std::chrono::nanoseconds;
+    using rep        = duration::rep;
+    using period     = duration::period;
+    using time_point = std::chrono::time_point<CoarseSteadyClock>;
+
+    static constexpr bool is_steady = true;
+
+    static time_point now()
+    {
+        timespec now{};
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+        return time_point(std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec));
+    }
+};
+#endif
+
+// entries expire after write: the TTL runs from admission, and a hit
+// neither moves the deadline nor rewrites the item. A TTL of zero means
+// the entry never expires. clock_t only needs now(), so a manual clock can
+// stand in for steady_clock
+template <typename clock_t = std::chrono::steady_clock>
+class WheelExpiry
+{
+public:
+    static constexpr bool ENABLED = true;
+
+    using id_t     = TimingWheel::id_t;
+    using duration = typename clock_t::duration;
+
+private:
+    using tick_t     = TimingWheel::tick_t;
+    using time_point = typename clock_t::time_point;
+
+    TimingWheel wheel_;
+    time_point  start_;
+    duration    tick_;
+    duration    default_ttl_;
+
+    inline tick_t ticks_since_start() const
+    {
+        return static_cast<tick_t>((clock_t::now() - start_) / tick_);
+    }
+
+public:
+    // tick is the resolution: a TTL is rounded up to whole ticks
+    explicit WheelExpiry(duration tick = std::chrono::milliseconds(1), duration default_ttl = duration::zero())
+             : wheel_(), start_(clock_t::now()), tick_(tick > duration::zero() ? tick : duration(1)),
+               default_ttl_(default_ttl) {}
+
+    inline void reserve(std::size_t max_entries) { wheel_.reserve(max_entries); }
+
+    inline duration default_ttl() const { return default_ttl_; }
+    inline void set_default_ttl(duration ttl) { default_ttl_ = ttl; }
+
+    void schedule(id_t node, duration ttl)
+    {
+        if (ttl <= duration::zero()) return;
+
+        const tick_t ticks = static_cast<tick_t>((ttl + tick_ - duration(1)) / tick_);
+        wheel_.schedule(node, wheel_.now() + ticks);
+    }
+
+    inline void cancel(id_t node) { wheel_.cancel(node); }
+
+    inline void advance() { wheel_.advance(ticks_since_start()); }
+
+    inline id_t pop_expired() { return wheel_.pop_expired(); }
+
+    // as of the last advance(), for the paths that just advanced
+    inline bool expired(id_t node) const { return wheel_.expired(node); }
+
+    // against the clock, for const readers that may run long after the
+    // last operation
+    inline bool expired_now(id_t node) const
+    {
+        return wheel_.scheduled(node) && wheel_.deadline(node) <= ticks_since_start();
+    }
+};
+
+#endif
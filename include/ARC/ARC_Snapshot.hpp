@@ -0,0 +1,440 @@
+#ifndef ARC_SNAPSHOT_HPP
+#define ARC_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils/log_config/log_config.hpp"
+#include "utils/thread_pool/thread_pool.hpp"
+#include "ARC/ARC_Stats.hpp"
+
+// ARC snapshot layout (native byte order):
+//
+//   SnapshotHeader, padded to a multiple of SNAPSHOT_ALIGNMENT bytes
+//   resident keys: T1 then T2, least recent first, padded
+//   ghost keys:    B1 then B2, least recent first, padded
+//   item offsets:  t1 + t2 + 1 uint64, padded; only for variable-size codecs
+//   item bytes:    the codec's encoding of every resident item, in key order
+//
+// Least recent first lets a restore push every entry to the front in file
+// order, so it reads the mapping front to back and copies nothing first.
+
+static constexpr char          SNAPSHOT_MAGIC[8]     = {'A', 'R', 'C', 'S', 'N', 'A', 'P', 'S'};
+static constexpr std::uint32_t SNAPSHOT_VERSION      = 1;
+static constexpr std::uint32_t SNAPSHOT_FIXED_ITEMS  = 1u << 0;
+static constexpr std::size_t   SNAPSHOT_ALIGNMENT    = 64;
+
+struct SnapshotHeader
+{
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint32_t key_width;
+    std::uint32_t ghost_width;
+    std::uint32_t item_width;   // encoded item size, 0 for variable-size codecs
+    std::uint32_t reserved;
+    std::uint64_t capacity;
+    double        adapt_param;
+    std::uint64_t sizes[ARC_LISTS];
+};
+
+inline std::size_t snapshot_align_up(std::size_t size)
+{
+    return (size + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+static constexpr std::size_t SNAPSHOT_HEADER_AREA = (sizeof(SnapshotHeader) + SNAPSHOT_ALIGNMENT - 1) /
+                                                    SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+
+// An item codec turns items into bytes and back. FIXED_SIZE is the size of
+// every encoding, or 0 when it varies and the snapshot keeps offsets.
+template <typename item_t>
+struct TrivialItemCodec
+{
+    static_assert(std::is_trivially_copyable<item_t>::value, "TrivialItemCodec copies raw items");
+
+    static constexpr std::size_t FIXED_SIZE = sizeof(item_t);
+
+    inline std::size_t encoded_size(const item_t &) const { return sizeof(item_t); }
+
+    inline void encode(const item_t &item, unsigned char *out) const { std::memcpy(out, &item, sizeof(item_t)); }
+
+    inline item_t decode(const unsigned char *in, std::size_t) const
+    {
+        item_t item;
+        std::memcpy(&item, in, sizeof(item_t));
+        return item;
+    }
+};
+
+struct StringItemCodec
+{
+    static constexpr std::size_t FIXED_SIZE = 0;
+
+    inline std::size_t encoded_size(const std::string &item) const { return item.size(); }
+
+    inline void encode(const std::string &item, unsigned char *out) const
+    {
+        std::memcpy(out, item.data(), item.size());
+    }
+
+    inline std::string decode(const unsigned char *in, std::size_t size) const
+    {
+        return std::string(reinterpret_cast<const char *>(in), size);
+    }
+};
+
+// Writes a state copy (ARCCache::copy_state) to path. The file appears
+// under its name only once complete: it is written next to it and renamed,
+// so a crash mid-write leaves the previous snapshot in place.
+template <typename state_t, typename codec_t = TrivialItemCodec<typename state_t::item_type>>
+bool write_arc_snapshot(const std::string &path, const state_t &state, const codec_t &codec = codec_t())
+{
+    using key_t       = typename state_t::key_type;
+    using ghost_key_t = typename state_t::ghost_key_type;
+
+    static_assert(std::is_trivially_copyable<key_t>::value &&
+                  std::is_trivially_copyable<ghost_key_t>::value, "snapshots store raw keys");
+
+    static constexpr std::size_t WRITE_BUFFER = 1 << 20;
+
+    const std::string temp_path = path + ".tmp";
+
+    std::FILE *file = std::fopen(temp_path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        LOG_ERROR("ARC snapshot", "CAN NOT OPEN FOR WRITING: ", temp_path);
+        return false;
+    }
+
+    std::vector<char> buffer(WRITE_BUFFER);
+    std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version     = SNAPSHOT_VERSION;
+    header.flags       = (codec_t::FIXED_SIZE != 0) ? SNAPSHOT_FIXED_ITEMS : 0;
+    header.key_width   = sizeof(key_t);
+    header.ghost_width = sizeof(ghost_key_t);
+    header.item_width  = static_cast<std::uint32_t>(codec_t::FIXED_SIZE);
+    header.capacity    = static_cast<std::uint64_t>(state.capacity());
+    header.adapt_param = state.adapt_param();
+
+    for (std::size_t i = 0; i < ARC_LISTS; i++)
+        header.sizes[i] = state.size(static_cast<ARCList>(i));
+
+    bool        ok      = true;
+    std::size_t written = 0;
+
+    auto write = [&](const void *data, std::size_t size)
+    {
+        ok = ok && (size == 0 || std::fwrite(data, size, 1, file) == 1);
+        written += size;
+    };
+
+    auto pad = [&]()
+    {
+        static const char padding[SNAPSHOT_ALIGNMENT] = {};
+        write(padding, snapshot_align_up(written) - written);
+    };
+
+    write(&header, sizeof(header));
+    pad();
+
+    for (ARCList list : {ARCList::T1, ARCList::T2})
+        state.for_each_entry(list, [&](const key_t &key, const auto &) { write(&key, sizeof(key_t)); });
+    pad();
+
+    for (ARCList list : {ARCList::B1, ARCList::B2})
+        state.for_each_ghost(list, [&](const ghost_key_t &ghost_key) { write(&ghost_key, sizeof(ghost_key_t)); });
+    pad();
+
+    if constexpr (codec_t::FIXED_SIZE == 0)
+    {
+        std::uint64_t offset = 0;
+        for (ARCList list : {ARCList::T1, ARCList::T2})
+            state.for_each_entry(list, [&](const key_t &, const auto &item)
+            {
+                write(&offset, sizeof(offset));
+                offset += codec.encoded_size(item);
+            });
+
+        write(&offset, sizeof(offset));
+        pad();
+    }
+
+    std::vector<unsigned char> encoded;
+    for (ARCList list : {ARCList::T1, ARCList::T2})
+        state.for_each_entry(list, [&](const key_t &, const auto &item)
+        {
+            encoded.resize(codec.encoded_size(item));
+            if (encoded.empty()) return;
+
+            codec.encode(item, encoded.data());
+            write(encoded.data(), encoded.size());
+        });
+
+    ok = (std::fclose(file) == 0) && ok;
+    if (ok && std::rename(temp_path.c_str(), path.c_str()) != 0)
+        ok = false;
+
+    if (!ok)
+    {
+        LOG_ERROR("ARC snapshot", "WRITE FAILED: ", path);
+        std::remove(temp_path.c_str());
+    }
+
+    return ok;
+}
+
+// copies and writes on the calling thread
+template <typename cache_t, typename codec_t = TrivialItemCodec<typename cache_t::item_type>>
+bool save_arc_snapshot(const std::string &path, const cache_t &cache, const codec_t &codec = codec_t())
+{
+    return write_arc_snapshot(path, cache.copy_state(), codec);
+}
+
+// only copy_state() runs on the calling thread, under whatever lock guards
+// the cache; a pool worker walks, encodes and writes the copy
+template <typename cache_t, typename codec_t = TrivialItemCodec<typename cache_t::item_type>>
+std::future<bool> save_arc_snapshot_async(const std::string &path, const cache_t &cache, ThreadPool &pool,
+                                          const codec_t &codec = codec_t())
+{
+    return pool.submit([path, state = cache.copy_state(), codec]()
+    {
+        return write_arc_snapshot(path, state, codec);
+    });
+}
+
+// Read-only mapping of a snapshot, in the shape ARCCache::restore expects.
+// Keys are read in place; items are decoded one at a time as asked for.
+template <typename key_t, typename ghost_key_t, typename item_t, typename codec_t = TrivialItemCodec<item_t>>
+class MappedSnapshot
+{
+    static_assert(std::is_trivially_copyable<key_t>::value &&
+                  std::is_trivially_copyable<ghost_key_t>::value, "snapshots store raw keys");
+
+private:
+    void          *data_;
+    std::size_t    length_;
+    SnapshotHeader header_;
+    codec_t        codec_;
+
+    const key_t               *keys_;
+    const ghost_key_t         *ghost_keys_;
+    const std::uint64_t       *offsets_;
+    const unsigned char       *items_;
+
+    void unmap()
+    {
+        if (data_ != nullptr)
+            munmap(data_, length_);
+
+        data_   = nullptr;
+        length_ = 0;
+    }
+
+    inline std::size_t resident_index(ARCList list, std::size_t index) const
+    {
+        return (list == ARCList::T2) ? header_.sizes[0] + index : index;
+    }
+
+    inline std::size_t ghost_index(ARCList list, std::size_t index) const
+    {
+        return (list == ARCList::B2) ? header_.sizes[2] + index : index;
+    }
+
+    bool validate(const std::string &path)
+    {
+        if (std::memcmp(header_.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+            header_.version != SNAPSHOT_VERSION)
+        {
+            LOG_ERROR("ARC snapshot", "NOT A SNAPSHOT FILE (or unknown version): ", path);
+            return false;
+        }
+
+        const bool fixed = (header_.flags & SNAPSHOT_FIXED_ITEMS) != 0;
+        if (header_.key_width != sizeof(key_t) || header_.ghost_width != sizeof(ghost_key_t) ||
+            fixed != (codec_t::FIXED_SIZE != 0) || header_.item_width != codec_t::FIXED_SIZE)
+        {
+            LOG_ERROR("ARC snapshot", "KEY/GHOST/ITEM WIDTH MISMATCH in ", path,
+                      "\nkey width: ", header_.key_width, " ghost width: ", header_.ghost_width,
+                      " item width: ", header_.item_width);
+            return false;
+        }
+
+        const std::uint64_t t1 = header_.sizes[0], t2 = header_.sizes[1];
+        const std::uint64_t b1 = header_.sizes[2], b2 = header_.sizes[3];
+        const std::uint64_t capacity = header_.capacity;
+
+        // every key takes a byte at least, which also keeps the sums below
+        // from overflowing
+        for (std::uint64_t size : header_.sizes)
+            if (size > length_)
+            {
+                LOG_ERROR("ARC snapshot", "TRUNCATED FILE: ", path);
+                return false;
+            }
+
+        if (capacity == 0 || t1 + t2 > capacity || t1 + b1 > capacity || (t1 + t2 + b1 + b2 + 1) / 2 > capacity)
+        {
+            LOG_ERROR("ARC snapshot", "LIST SIZES BREAK THE ARC INVARIANTS in ", path);
+            return false;
+        }
+
+        std::size_t position = SNAPSHOT_HEADER_AREA;
+        const unsigned char *base = static_cast<const unsigned char *>(data_);
+
+        keys_ = reinterpret_cast<const key_t *>(base + position);
+        position += snapshot_align_up((t1 + t2) * sizeof(key_t));
+
+        ghost_keys_ = reinterpret_cast<const ghost_key_t *>(base + position);
+        position += snapshot_align_up((b1 + b2) * sizeof(ghost_key_t));
+
+        std::uint64_t items_length = (t1 + t2) * codec_t::FIXED_SIZE;
+        if constexpr (codec_t::FIXED_SIZE == 0)
+        {
+            if (length_ < position + (t1 + t2 + 1) * sizeof(std::uint64_t))
+            {
+                LOG_ERROR("ARC snapshot", "TRUNCATED FILE: ", path);
+                return false;
+            }
+
+            offsets_ = reinterpret_cast<const std::uint64_t *>(base + position);
+            position += snapshot_align_up((t1 + t2 + 1) * sizeof(std::uint64_t));
+
+            // a decreasing offset would decode a huge item past the mapping
+            for (std::size_t i = 0; i < t1 + t2; i++)
+                if (offsets_[i] > offsets_[i + 1])
+                {
+                    LOG_ERROR("ARC snapshot", "BROKEN ITEM OFFSETS in ", path);
+                    return false;
+                }
+
+            items_length = offsets_[t1 + t2];
+        }
+
+        items_ = base + position;
+
+        if (length_ < position + items_length)
+        {
+            LOG_ERROR("ARC snapshot", "TRUNCATED FILE: ", path, "\nsize: ", length_,
+                      " expected: ", position + items_length);
+            return false;
+        }
+
+        return true;
+    }
+
+public:
+    explicit MappedSnapshot(const codec_t &codec = codec_t())
+             : data_(nullptr), length_(0), header_(), codec_(codec),
+               keys_(nullptr), ghost_keys_(nullptr), offsets_(nullptr), items_(nullptr) {}
+
+    MappedSnapshot(const MappedSnapshot &) = delete;
+    MappedSnapshot &operator=(const MappedSnapshot &) = delete;
+
+    ~MappedSnapshot() { unmap(); }
+
+    bool open(const std::string &path)
+    {
+        unmap();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            LOG_ERROR("ARC snapshot", "CAN NOT OPEN: ", path);
+            return false;
+        }
+
+        struct stat file_stat{};
+        if (fstat(fd, &file_stat) != 0 || static_cast<std::size_t>(file_stat.st_size) < SNAPSHOT_HEADER_AREA)
+        {
+            LOG_ERROR("ARC snapshot", "FILE IS TOO SMALL: ", path);
+            ::close(fd);
+            return false;
+        }
+
+        length_ = static_cast<std::size_t>(file_stat.st_size);
+        data_   = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if (data_ == MAP_FAILED)
+        {
+            LOG_ERROR("ARC snapshot", "MMAP FAILED: ", path);
+            data_ = nullptr;
+            length_ = 0;
+            return false;
+        }
+
+        // restore walks every column front to back
+        madvise(data_, length_, MADV_SEQUENTIAL);
+
+        std::memcpy(&header_, data_, sizeof(header_));
+        if (!validate(path))
+        {
+            unmap();
+            return false;
+        }
+
+        return true;
+    }
+
+    inline bool is_open() const { return data_ != nullptr; }
+
+    inline const SnapshotHeader &header() const { return header_; }
+
+    inline std::size_t capacity()    const { return static_cast<std::size_t>(header_.capacity); }
+    inline double      adapt_param() const { return header_.adapt_param; }
+
+    inline std::size_t size(ARCList list) const
+    {
+        return static_cast<std::size_t>(header_.sizes[static_cast<std::size_t>(list)]);
+    }
+
+    // index 0 is the least recent entry of the list
+    inline const key_t &key(ARCList list, std::size_t index) const
+    {
+        return keys_[resident_index(list, index)];
+    }
+
+    inline const ghost_key_t &ghost_key(ARCList list, std::size_t index) const
+    {
+        return ghost_keys_[ghost_index(list, index)];
+    }
+
+    item_t item(ARCList list, std::size_t index) const
+    {
+        const std::size_t resident = resident_index(list, index);
+
+        if constexpr (codec_t::FIXED_SIZE != 0)
+            return codec_.decode(items_ + resident * codec_t::FIXED_SIZE, codec_t::FIXED_SIZE);
+        else
+            return codec_.decode(items_ + offsets_[resident], offsets_[resident + 1] - offsets_[resident]);
+    }
+};
+
+template <typename cache_t, typename codec_t = TrivialItemCodec<typename cache_t::item_type>>
+bool restore_arc_snapshot(const std::string &path, cache_t &cache, const codec_t &codec = codec_t())
+{
+    MappedSnapshot<typename cache_t::key_type, typename cache_t::ghost_key_type,
+                   typename cache_t::item_type, codec_t> snapshot(codec);
+
+    if (!snapshot.open(path)) return false;
+
+    cache.restore(snapshot);
+    return true;
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef ARC_STATS_HPP
+#define ARC_STATS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <sys/types.h>
+
+#include "utils/stats/latency_histogram.hpp"
+
+// ARCCache reports what it does to a stats_t policy. NoARCStats, the
+// default, has empty inline hooks and no state worth speaking of, so a
+// cache built without stats compiles to the same code as before.
+enum class ARCList : std::size_t
+{
+    T1,
+    T2,
+    B1,
+    B2,
+};
+
+static constexpr std::size_t ARC_LISTS = 4;
+
+inline const char *arc_list_name(ARCList list)
+{
+    switch (list)
+    {
+        case ARCList::T1: return "t1";
+        case ARCList::T2: return "t2";
+        case ARCList::B1: return "b1";
+        case ARCList::B2: return "b2";
+    }
+
+    return "unknown";
+}
+
+struct NoARCStats
+{
+    static constexpr bool ENABLED = false;
+
+    inline void on_hit(ARCList) {}
+    inline void on_ghost_hit(ARCList) {}
+    inline void on_miss() {}
+    inline void on_eviction(ARCList) {}
+    inline void on_expire() {}
+    inline void on_adapt(ssize_t, double) {}
+
+    inline bool sample_latency() { return false; }
+    inline void record_latency(std::uint64_t) {}
+};
+
+// Counters have one writer, the thread holding the cache, and may be read
+// from anywhere at any time. The adapt_param_ trajectory is a plain vector:
+// read it while the cache is idle or under its lock.
+class ARCStats
+{
+public:
+    static constexpr bool ENABLED = true;
+
+    static constexpr std::uint32_t STD_LATENCY_PERIOD = 64;
+    static constexpr std::size_t   MAX_TRAJECTORY     = 1024;
+
+    struct AdaptSample
+    {
+        ssize_t request;
+        double  adapt_param;
+    };
+
+private:
+    RelaxedCounter hits_[ARC_LISTS];
+    RelaxedCounter evictions_[ARC_LISTS];
+    RelaxedCounter misses_;
+    RelaxedCounter expirations_;
+
+    std::atomic<double> adapt_param_;
+
+    LatencyHistogram latency_;
+    std::uint32_t    latency_period_;
+    std::uint32_t    latency_countdown_;
+
+    // one sample per trajectory_interval_ requests at most; when the vector
+    // fills up every other sample is dropped and the interval doubles, so
+    // any run length ends up with between MAX_TRAJECTORY / 2 and
+    // MAX_TRAJECTORY evenly spread points
+    std::vector<AdaptSample> trajectory_;
+    ssize_t                  trajectory_interval_;
+    ssize_t                  next_sample_;
+
+    static inline std::size_t index(ARCList list) { return static_cast<std::size_t>(list); }
+
+public:
+    // latency_period: time one add_cache in that many, 1 times every call
+    explicit ARCStats(std::uint32_t latency_period = STD_LATENCY_PERIOD)
+             : misses_(), expirations_(), adapt_param_(0.0), latency_(), latency_period_(latency_period ? latency_period : 1),
+               latency_countdown_(1), trajectory_(), trajectory_interval_(1), next_sample_(0)
+    {
+        trajectory_.reserve(MAX_TRAJECTORY);
+    }
+
+    // T1/T2 hits are resident hits, B1/B2 hits are ghost hits
+    inline void on_hit(ARCList list)       { hits_[index(list)].add(); }
+    inline void on_ghost_hit(ARCList list) { hits_[index(list)].add(); }
+    inline void on_miss()                  { misses_.add(); }
+
+    // T1/T2 evictions leave a ghost behind, B1/B2 ones forget the key
+    inline void on_eviction(ARCList list)  { evictions_[index(list)].add(); }
+
+    // TTL removals leave no ghost and are not evictions
+    inline void on_expire()                { expirations_.add(); }
+
+    void on_adapt(ssize_t request, double adapt_param)
+    {
+        adapt_param_.store(adapt_param, std::memory_order_relaxed);
+
+        if (request < next_sample_) return;
+
+        if (trajectory_.size() == MAX_TRAJECTORY)
+        {
+            for (std::size_t i = 0; i < MAX_TRAJECTORY / 2; i++)
+                trajectory_[i] = trajectory_[2 * i];
+
+            trajectory_.resize(MAX_TRAJECTORY / 2);
+            trajectory_interval_ *= 2;
+        }
+
+        trajectory_.push_back({request, adapt_param});
+        next_sample_ = request + trajectory_interval_;
+    }
+
+    inline bool sample_latency()
+    {
+        if (--latency_countdown_ != 0) return false;
+
+        latency_countdown_ = latency_period_;
+        return true;
+    }
+
+    inline void record_latency(std::uint64_t nanoseconds) { latency_.record(nanoseconds); }
+
+    // counters and latencies add up, and so do the T1 targets of shards;
+    // a trajectory belongs to one cache, so the merged one stays as it was
+    void merge(const ARCStats &other)
+    {
+        adapt_param_.store(adapt_param() + other.adapt_param(), std::memory_order_relaxed);
+
+        for (std::size_t i = 0; i < ARC_LISTS; i++)
+        {
+            hits_[i].add(other.hits_[i].get());
+            evictions_[i].add(other.evictions_[i].get());
+        }
+
+        misses_.add(other.misses_.get());
+        expirations_.add(other.expirations_.get());
+        latency_.merge(other.latency_);
+    }
+
+    inline std::uint64_t hits(ARCList list)      const { return hits_[index(list)].get(); }
+    inline std::uint64_t evictions(ARCList list) const { return evictions_[index(list)].get(); }
+    inline std::uint64_t misses()                const { return misses_.get(); }
+    inline std::uint64_t expirations()           const { return expirations_.get(); }
+
+    inline std::uint64_t requests() const
+    {
+        std::uint64_t requests = misses();
+        for (std::size_t i = 0; i < ARC_LISTS; i++)
+            requests += hits_[i].get();
+
+        return requests;
+    }
+
+    inline double adapt_param() const { return adapt_param_.load(std::memory_order_relaxed); }
+
+    inline const LatencyHistogram &latency() const { return latency_; }
+
+    inline std::uint32_t latency_period() const { return latency_period_; }
+
+    inline const std::vector<AdaptSample> &trajectory() const { return trajectory_; }
+};
+
+#endif
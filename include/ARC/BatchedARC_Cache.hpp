@@ -0,0 +1,404 @@
+#ifndef BATCHED_ARC_CACHE_HPP
+#define BATCHED_ARC_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "utils/log_config/log_config.hpp"
+#include "CacheInterface.hpp"
+#include "ARC/ARC_Cache.hpp"
+#include "ARC/ShardedARC_Cache.hpp"
+#include "utils/spin_lock/spin_lock.hpp"
+
+// BP-Wrapper style front end over sharded ARC.
+//
+// A hit is found without taking any lock: each shard is guarded by a
+// sequence counter and readers retry when a writer ran during their lookup.
+// Instead of moving the node to T2 right away, the hit key goes into a
+// striped ring buffer (one stripe per thread in practice). Whoever holds the
+// shard lock next drains the buffers and applies the recorded promotions in
+// one batch; a full buffer drops records rather than block the reader.
+//
+// Speculative reads require every structure a lookup touches to stay at a
+// fixed address, so shards always use the flat index and plain-data keys
+// and items.
+//
+// The speculative read is a data race: optimistic_peek() loads control
+// bytes, slots and the item with plain loads while a writer holding the
+// shard lock may be storing to them. A torn read is thrown away when the
+// version moved. Meanwhile peek() probes through FlatHashMap::find_bounded,
+// which visits every group at most once, and range-checks the node, so a
+// torn read stays inside the shard's memory and ends. That relies on the
+// compiler turning those loads into single moves, which is true of GCC and
+// Clang for the trivially copyable types allowed here, but the C++ memory
+// model does not promise it. ThreadSanitizer reports these reads;
+// tests/tsan.supp silences them and nothing else, and the batched_tsan
+// test (-DBUILD_TSAN_TESTS=ON) runs the cache under it.
+template <typename key_t, typename item_t, typename lock_t = SpinLock>
+class BatchedARCCache : public CacheInterface<key_t, item_t>
+{
+private:
+    static_assert(std::is_trivially_copyable<key_t>::value &&
+                  std::is_trivially_copyable<item_t>::value,
+                  "optimistic reads need trivially copyable keys and items");
+
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+    static constexpr ssize_t     STD_SHARDS      = 16;
+
+    static constexpr std::uint32_t BUFFER_SIZE     = 64;
+    static constexpr std::uint32_t DRAIN_THRESHOLD = BUFFER_SIZE / 2;
+    static constexpr int           READ_RETRIES    = 4;
+
+    using ShardCache = ARCCache<key_t, item_t, FlatHashIndex>;
+
+    // bounded MPSC ring: producers reserve a position with a CAS on tail,
+    // the single consumer is whoever holds the shard lock
+    struct alignas(CACHE_LINE_SIZE) ReadBuffer
+    {
+        struct Slot
+        {
+            std::atomic<std::uint32_t> sequence;
+            key_t key;
+        };
+
+        std::atomic<std::uint32_t> tail;
+        std::atomic<std::uint32_t> head;
+        std::atomic<ssize_t>       hits;
+
+        // get_item misses, which never reach the shard cache
+        std::atomic<ssize_t>       misses;
+
+        Slot slots[BUFFER_SIZE];
+
+        ReadBuffer() : tail(0), head(0), hits(0), misses(0)
+        {
+            for (std::uint32_t i = 0; i < BUFFER_SIZE; i++)
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        // returns the amount of pending records, or 0 when the record was dropped
+        std::uint32_t push(const key_t &key)
+        {
+            std::uint32_t pos = tail.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Slot &slot = slots[pos % BUFFER_SIZE];
+                std::uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+                std::int32_t  diff     = static_cast<std::int32_t>(sequence - pos);
+
+                if (diff == 0)
+                {
+                    if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        slot.key = key;
+                        slot.sequence.store(pos + 1, std::memory_order_release);
+                        return pos + 1 - head.load(std::memory_order_relaxed);
+                    }
+                }
+                else if (diff < 0)
+                    return 0;
+                else
+                    pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        bool pop(key_t &key)
+        {
+            std::uint32_t pos = head.load(std::memory_order_relaxed);
+            Slot &slot = slots[pos % BUFFER_SIZE];
+
+            if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+                return false;
+
+            key = slot.key;
+            slot.sequence.store(pos + BUFFER_SIZE, std::memory_order_release);
+            head.store(pos + 1, std::memory_order_relaxed);
+            return true;
+        }
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        std::atomic<std::uint64_t> version;
+        mutable lock_t lock;
+
+        alignas(CACHE_LINE_SIZE) ShardCache cache;
+
+        std::unique_ptr<ReadBuffer[]> buffers;
+
+        Shard(ssize_t capacity, std::size_t stripes)
+            : version(0), lock(), cache(capacity), buffers(new ReadBuffer[stripes]) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t shard_mask_;
+    std::size_t stripe_mask_;
+    ssize_t capacity_;
+
+    inline Shard &shard_for(const key_t &key) const
+    {
+        return *shards_[shard_hash(key) & shard_mask_];
+    }
+
+    inline ReadBuffer &buffer_for(Shard &shard) const
+    {
+        static thread_local const std::size_t thread_stripe =
+            std::hash<std::thread::id>()(std::this_thread::get_id());
+
+        return shard.buffers[thread_stripe & stripe_mask_];
+    }
+
+    static std::size_t round_up_pow2(std::size_t value)
+    {
+        std::size_t pow2 = 1;
+        while (pow2 < value)
+            pow2 *= 2;
+
+        return pow2;
+    }
+
+    // writers hold the shard lock and keep the version odd while they mutate
+    inline void begin_write(Shard &shard)
+    {
+        shard.version.store(shard.version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    inline void end_write(Shard &shard)
+    {
+        shard.version.store(shard.version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // a seqlock read: the loads of peek() race with the writer by design,
+    // see the note at the top
+    bool optimistic_peek(const Shard &shard, const key_t &key, item_t &item) const
+    {
+        for (int attempt = 0; attempt < READ_RETRIES; attempt++)
+        {
+            std::uint64_t before = shard.version.load(std::memory_order_acquire);
+            if (before & 1) continue;
+
+            // a torn attempt must not leave its item behind for a later
+            // attempt that misses
+            item_t candidate{};
+            bool found = shard.cache.peek(key, candidate);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (shard.version.load(std::memory_order_relaxed) == before)
+            {
+                if (found) item = candidate;
+                return found;
+            }
+        }
+
+        std::lock_guard<lock_t> guard(shard.lock);
+        return shard.cache.peek(key, item);
+    }
+
+    // caller holds shard.lock and has called begin_write()
+    void drain_buffers(Shard &shard)
+    {
+        key_t key{};
+        for (std::size_t stripe = 0; stripe <= stripe_mask_; stripe++)
+            while (shard.buffers[stripe].pop(key))
+                shard.cache.promote(key);
+    }
+
+    void on_hit(Shard &shard, const key_t &key)
+    {
+        ReadBuffer &buffer = buffer_for(shard);
+        buffer.hits.fetch_add(1, std::memory_order_relaxed);
+
+        std::uint32_t pending = buffer.push(key);
+        if ((pending == 0 || pending >= DRAIN_THRESHOLD) && shard.lock.try_lock())
+        {
+            begin_write(shard);
+            drain_buffers(shard);
+            end_write(shard);
+
+            shard.lock.unlock();
+        }
+    }
+
+public:
+    explicit BatchedARCCache(ssize_t capacity, ssize_t shards_amount = STD_SHARDS,
+                             ssize_t stripes_amount = 0)
+             : shards_(), shard_mask_(0), stripe_mask_(0), capacity_(capacity)
+    {
+        LOG_INFO("Batched ARC cache", "Cache initialized with capacity: ", capacity,
+                                      "\nshards: ", shards_amount);
+        if (shards_amount <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Shards amount is INVALID, set\n shards = STD_SHARDS = ", STD_SHARDS);
+            shards_amount = STD_SHARDS;
+        }
+
+        if (stripes_amount <= 0)
+            stripes_amount = std::max<ssize_t>(1, std::thread::hardware_concurrency());
+
+        const std::size_t shards_pow2  = round_up_pow2(static_cast<std::size_t>(shards_amount));
+        const std::size_t stripes_pow2 = round_up_pow2(static_cast<std::size_t>(stripes_amount));
+
+        shard_mask_  = shards_pow2 - 1;
+        stripe_mask_ = stripes_pow2 - 1;
+
+        const ssize_t shards = static_cast<ssize_t>(shards_pow2);
+        if (capacity_ > 0 && capacity_ < shards)
+        {
+            LOG_WARNING("BAD INPUT", "Capacity is less than one entry per shard, set\n capacity = ", shards);
+            capacity_ = shards;
+        }
+
+        // the remainder goes one entry each to the first shards, so the
+        // shards add up to the capacity exactly
+        const ssize_t share = capacity_ / shards;
+
+        shards_.reserve(shards_pow2);
+        for (ssize_t i = 0; i < shards; i++)
+            shards_.push_back(std::make_unique<Shard>(share + (i < capacity_ % shards ? 1 : 0), stripes_pow2));
+    }
+
+    // entries all shards hold together at most
+    ssize_t capacity() const
+    {
+        ssize_t total = 0;
+        for (const auto &shard : shards_)
+            total += shard->cache.capacity();
+
+        return total;
+    }
+
+    item_t get_item(const key_t &key)
+    {
+        Shard &shard = shard_for(key);
+        item_t item{};
+
+        if (optimistic_peek(shard, key, item))
+            on_hit(shard, key);
+        else
+            buffer_for(shard).misses.fetch_add(1, std::memory_order_relaxed);
+
+        return item;
+    }
+
+    bool add_cache(const key_t &key, const item_t &item)
+    {
+        Shard &shard = shard_for(key);
+        item_t cached{};
+
+        if (optimistic_peek(shard, key, cached))
+        {
+            on_hit(shard, key);
+            return true;
+        }
+
+        std::lock_guard<lock_t> guard(shard.lock);
+
+        begin_write(shard);
+        drain_buffers(shard);
+        bool is_hit = shard.cache.add_cache(key, item);
+        end_write(shard);
+
+        return is_hit;
+    }
+
+    // applies every recorded promotion; run it periodically when the read
+    // buffers are not drained often enough by misses
+    void maintenance()
+    {
+        for (auto &shard : shards_)
+        {
+            std::lock_guard<lock_t> guard(shard->lock);
+
+            begin_write(*shard);
+            drain_buffers(*shard);
+            end_write(*shard);
+        }
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        if (capacity_ <= 0)
+        {
+            LOG_ERROR("Batched ARC cache", "capacity is INVALID. STOP IT");
+            return 0;
+        }
+
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    // promotions still sitting in the read buffers are applied here
+    ssize_t finish() override
+    {
+        maintenance();
+        return get_hit_count();
+    }
+
+    ssize_t get_hit_count() const override
+    {
+        ssize_t hits = 0;
+        for (const auto &shard : shards_)
+        {
+            for (std::size_t stripe = 0; stripe <= stripe_mask_; stripe++)
+                hits += shard->buffers[stripe].hits.load(std::memory_order_relaxed);
+
+            std::lock_guard<lock_t> guard(shard->lock);
+            hits += shard->cache.get_hit_count();
+        }
+
+        return hits;
+    }
+
+    // hits served from the optimistic path and get_item misses never reach
+    // the shard cache, they are counted by the read buffers
+    ssize_t get_request_count() const override
+    {
+        ssize_t requests = 0;
+        for (const auto &shard : shards_)
+        {
+            for (std::size_t stripe = 0; stripe <= stripe_mask_; stripe++)
+                requests += shard->buffers[stripe].hits.load(std::memory_order_relaxed) +
+                            shard->buffers[stripe].misses.load(std::memory_order_relaxed);
+
+            std::lock_guard<lock_t> guard(shard->lock);
+            requests += shard->cache.get_request_count();
+        }
+
+        return requests;
+    }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << get_hit_count() << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("Batched ARC cache DUMP", "capacity: ", capacity_, "\nshards: ", shards_.size(),
+                                         "\nstripes: ", stripe_mask_ + 1);
+
+        for (const auto &shard : shards_)
+        {
+            std::lock_guard<lock_t> guard(shard->lock);
+            shard->cache.dump();
+        }
+    }
+};
+
+#endif
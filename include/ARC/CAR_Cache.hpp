@@ -0,0 +1,297 @@
+#ifndef CAR_CACHE_HPP
+#define CAR_CACHE_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+
+#include "utils/log_config/log_config.hpp"
+#include "CacheInterface.hpp"
+#include "ARC/NodeSlab.hpp"
+#include "ARC/ARC_Cache.hpp"
+
+// CAR, CLOCK with Adaptive Replacement (Bansal & Modha). Same T1/T2 split,
+// B1/B2 ghosts and adapt_param_ target as ARCCache, but T1 and T2 are
+// clocks: a hit only sets the reference bit of its entry and never relinks
+// a node. The hand (the tail of each list) gives referenced entries of T1
+// a second life in T2 and those of T2 another round in T2; unreferenced
+// ones are demoted to the ghosts.
+template <typename key_t, typename item_t,
+          template <typename, typename> class map_t = StdHashIndex,
+          template <typename> class ghost_t = KeyGhosts>
+class CARCache : public CacheInterface<key_t, item_t>
+{
+private:
+    enum class ListLocation
+    {
+        FIRST_LIST_GHOST,
+        FREQUENT_LIST_GHOST
+    };
+
+    struct CacheEntry
+    {
+        key_t key;
+        item_t item;
+        bool referenced;
+
+        CacheEntry() : key(), item(), referenced(false) {}
+        CacheEntry(const key_t &k, const item_t &i) : key(k), item(i), referenced(false) {}
+    };
+
+    using GhostPolicy = ghost_t<key_t>;
+    using GhostKey    = typename GhostPolicy::ghost_key_t;
+
+    using SlabType      = NodeSlab<CacheEntry>;
+    using GhostSlabType = NodeSlab<GhostKey>;
+    using ListType      = typename SlabType::IndexList;
+    using GhostListType = typename GhostSlabType::IndexList;
+    using NodeIndex     = typename SlabType::index_t;
+
+    struct GhostInfo
+    {
+        ListLocation location;
+        NodeIndex node;
+
+        GhostInfo() : location(ListLocation::FIRST_LIST_GHOST), node(SlabType::NIL) {}
+        GhostInfo(ListLocation loc, NodeIndex index) : location(loc), node(index) {}
+    };
+
+    static constexpr ssize_t STD_CAPACITY = 64;
+
+    ssize_t capacity_;
+    ssize_t hits_counter_;
+    ssize_t requests_counter_;
+    double adapt_param_;
+
+    SlabType      entries_;
+    GhostSlabType ghosts_;
+
+    // list head is the newest entry, the clock hand sits at the tail
+    ListType      clock_first_,      clock_frequent_;
+    GhostListType list_first_ghost_, list_frequent_ghost_;
+
+    using CacheMapType = map_t<key_t, NodeIndex>;
+    using GhostMapType = map_t<GhostKey, GhostInfo>;
+    using GhostMapIter = typename GhostMapType::iterator;
+
+    CacheMapType cache_map_;
+    GhostMapType ghost_map_;
+
+    inline GhostListType &ghost_list(ListLocation location)
+    {
+        return (location == ListLocation::FIRST_LIST_GHOST) ? list_first_ghost_ : list_frequent_ghost_;
+    }
+
+    inline ssize_t resident_size() const
+    {
+        return static_cast<ssize_t>(clock_first_.size + clock_frequent_.size);
+    }
+
+    void remove_ghost_tail(GhostListType &list)
+    {
+        NodeIndex tail = ghosts_.pop_back(list);
+        ghost_map_.erase(ghosts_[tail]);
+        ghosts_.release(tail);
+    }
+
+    void demote_to_ghost(ListType &clock, GhostListType &dest, ListLocation dest_location)
+    {
+        NodeIndex tail_node = entries_.pop_back(clock);
+        const GhostKey ghost_key = GhostPolicy::ghost_key(entries_[tail_node].key);
+
+        cache_map_.erase(entries_[tail_node].key);
+        entries_.release(tail_node);
+
+        NodeIndex ghost_node = ghosts_.acquire();
+        ghosts_[ghost_node] = ghost_key;
+        ghosts_.push_front(dest, ghost_node);
+
+        auto [ghost_map_it, inserted] = ghost_map_.emplace(ghost_key, GhostInfo(dest_location, ghost_node));
+        if (!inserted)
+        {
+            // fingerprint collision: the older ghost is forgotten
+            GhostInfo &old = ghost_map_it->second;
+            ghosts_.unlink(ghost_list(old.location), old.node);
+            ghosts_.release(old.node);
+
+            old = GhostInfo(dest_location, ghost_node);
+        }
+    }
+
+    // sweeps the hands until one unreferenced entry leaves for a ghost list
+    void replace()
+    {
+        for (;;)
+        {
+            if (static_cast<double>(clock_first_.size) >= std::max(1.0, adapt_param_))
+            {
+                const NodeIndex hand = clock_first_.tail;
+                if (!entries_[hand].referenced)
+                {
+                    demote_to_ghost(clock_first_, list_first_ghost_, ListLocation::FIRST_LIST_GHOST);
+                    return;
+                }
+
+                entries_[hand].referenced = false;
+                entries_.move_to_front(clock_first_, clock_frequent_, hand);
+            }
+            else
+            {
+                const NodeIndex hand = clock_frequent_.tail;
+                if (!entries_[hand].referenced)
+                {
+                    demote_to_ghost(clock_frequent_, list_frequent_ghost_, ListLocation::FREQUENT_LIST_GHOST);
+                    return;
+                }
+
+                entries_[hand].referenced = false;
+                entries_.move_to_front(clock_frequent_, clock_frequent_, hand);
+            }
+        }
+    }
+
+    void insert_entry(ListType &clock, const key_t &key, const item_t &item)
+    {
+        NodeIndex node = entries_.acquire();
+        entries_[node] = CacheEntry(key, item);
+        entries_.push_front(clock, node);
+        cache_map_.emplace(key, node);
+    }
+
+public:
+    explicit CARCache() : capacity_(0), hits_counter_(0), requests_counter_(0), adapt_param_(0.0),
+                          entries_(), ghosts_() {}
+
+    explicit CARCache(ssize_t capacity) : capacity_(capacity), hits_counter_(0), requests_counter_(0),
+                                          adapt_param_(0.0), entries_(), ghosts_()
+    {
+        LOG_INFO("CAR cache", "Cache initialized with capacity: ", capacity);
+
+        if (capacity <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Capacity is INVALID, set\n capacity = STD_CAPACITY = ", STD_CAPACITY);
+            capacity_ = STD_CAPACITY;
+        }
+
+        entries_.reserve(capacity_);
+        ghosts_.reserve(capacity_);
+        cache_map_.reserve(capacity_);
+        ghost_map_.reserve(capacity_);
+    }
+
+    item_t get_item(const key_t &key) const
+    {
+        auto cache_map_it = cache_map_.find(key);
+        if (cache_map_it == cache_map_.end()) return item_t();
+
+        return entries_[cache_map_it->second].item;
+    }
+
+    bool add_cache(const key_t &key, const item_t &item)
+    {
+        if (capacity_ <= 0) return false;
+
+        requests_counter_++;
+
+        auto cache_map_it = cache_map_.find(key);
+        if (cache_map_it != cache_map_.end())
+        {
+            entries_[cache_map_it->second].referenced = true;
+            hits_counter_++;
+            return true;
+        }
+
+        // the ghost leaves its list before replace() may add to the lists,
+        // so a fingerprint collision there cannot take this one with it
+        GhostMapIter ghost_map_it = ghost_map_.find(GhostPolicy::ghost_key(key));
+        const bool   is_ghost     = ghost_map_it != ghost_map_.end();
+        ListLocation location     = ListLocation::FIRST_LIST_GHOST;
+
+        if (is_ghost)
+        {
+            location = ghost_map_it->second.location;
+            ghosts_.unlink(ghost_list(location), ghost_map_it->second.node);
+            ghosts_.release(ghost_map_it->second.node);
+            ghost_map_.erase(ghost_map_it);
+        }
+
+        if (resident_size() == capacity_)
+        {
+            replace();
+
+            if (!is_ghost)
+            {
+                const ssize_t ghost_size = static_cast<ssize_t>(list_first_ghost_.size + list_frequent_ghost_.size);
+
+                if (static_cast<ssize_t>(clock_first_.size + list_first_ghost_.size) == capacity_ &&
+                    !list_first_ghost_.empty())
+                    remove_ghost_tail(list_first_ghost_);
+                else if (resident_size() + ghost_size == 2 * capacity_ && !list_frequent_ghost_.empty())
+                    remove_ghost_tail(list_frequent_ghost_);
+            }
+        }
+
+        if (!is_ghost)
+        {
+            insert_entry(clock_first_, key, item);
+            return false;
+        }
+
+        // ghost list sizes as they were with the requested key still in them
+        const double first_ghosts    = static_cast<double>(list_first_ghost_.size) +
+                                       (location == ListLocation::FIRST_LIST_GHOST ? 1.0 : 0.0);
+        const double frequent_ghosts = static_cast<double>(list_frequent_ghost_.size) +
+                                       (location == ListLocation::FREQUENT_LIST_GHOST ? 1.0 : 0.0);
+
+        if (location == ListLocation::FIRST_LIST_GHOST)
+            adapt_param_ = std::min(adapt_param_ + std::max(1.0, frequent_ghosts / first_ghosts),
+                                    static_cast<double>(capacity_));
+        else
+            adapt_param_ = std::max(adapt_param_ - std::max(1.0, first_ghosts / frequent_ghosts), 0.0);
+
+        insert_entry(clock_frequent_, key, item);
+        return false;
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        if (capacity_ <= 0)
+        {
+            LOG_ERROR("CAR cache", "capacity is INVALID. STOP IT");
+            return 0;
+        }
+
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    inline ssize_t finish() override { return hits_counter_; }
+
+    inline ssize_t get_hit_count()     const override { return hits_counter_; }
+    inline ssize_t get_request_count() const override { return requests_counter_; }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << hits_counter_ << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("CAR cache DUMP", "capacity: ", capacity_, "\nhit count: ", hits_counter_,
+                                   "\nadaptive parameter: ", adapt_param_,
+                                   "\nT1: ", clock_first_.size, " T2: ", clock_frequent_.size,
+                                   "\nB1: ", list_first_ghost_.size, " B2: ", list_frequent_ghost_.size);
+    }
+};
+
+#endif
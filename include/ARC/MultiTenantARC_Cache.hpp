@@ -0,0 +1,267 @@
+#ifndef MULTI_TENANT_ARC_CACHE_HPP
+#define MULTI_TENANT_ARC_CACHE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "utils/log_config/log_config.hpp"
+#include "CacheInterface.hpp"
+#include "ARC/ARC_Cache.hpp"
+#include "ARC/ShardedARC_Cache.hpp"
+
+// A group of ARC caches, one per tenant, that share one budget of entries.
+// Each tenant starts from an even split, and every rebalance_period
+// requests one step of capacity moves from the tenant whose extra room is
+// worth least to the one whose extra room is worth most. A ghost hit is a
+// request a larger cache would have served, so a tenant's ghost hits per
+// entry of capacity, decayed over past windows, is its marginal utility.
+// A rebalance is a scan over the tenants plus one set_capacity on each
+// side, so its cost does not grow with the budget. Capacities always add
+// up to the budget. Like ARCCache it is not thread-safe.
+template <typename key_t, typename item_t,
+          template <typename, typename> class map_t = FlatHashIndex>
+class MultiTenantARCCache : public CacheInterface<key_t, item_t>
+{
+public:
+    using TenantCache    = ARCCache<key_t, item_t, map_t>;
+    using TenantSelector = std::function<std::size_t(const key_t &)>;
+
+    static constexpr ssize_t STD_TENANTS          = 16;
+    static constexpr ssize_t STD_REBALANCE_PERIOD = 4096;
+
+private:
+    // a step is 1 / STEP_DIVISOR of the even split, and no tenant goes
+    // below 1 / MIN_DIVISOR of it, so a cold tenant keeps its hottest keys
+    static constexpr ssize_t STEP_DIVISOR = 32;
+    static constexpr ssize_t MIN_DIVISOR  = 16;
+
+    // weight of the windows before the last one in a tenant's utility
+    static constexpr double UTILITY_DECAY = 0.75;
+
+    struct Tenant
+    {
+        TenantCache cache;
+        ssize_t     ghost_hits_seen;
+        double      utility;
+
+        explicit Tenant(ssize_t capacity) : cache(capacity), ghost_hits_seen(0), utility(0.0) {}
+    };
+
+    std::vector<std::unique_ptr<Tenant>> tenants_;
+    TenantSelector      tenant_of_;
+
+    ssize_t budget_;
+    ssize_t step_;
+    ssize_t min_capacity_;
+
+    ssize_t rebalance_period_;
+    ssize_t rebalance_countdown_;
+    ssize_t rebalances_;
+    ssize_t moved_;
+
+    inline void count_request()
+    {
+        if (rebalance_period_ > 0 && --rebalance_countdown_ == 0)
+        {
+            rebalance_countdown_ = rebalance_period_;
+            rebalance();
+        }
+    }
+
+    inline Tenant &tenant_for(std::size_t tenant) { return *tenants_[tenant % tenants_.size()]; }
+
+public:
+    // budget entries over tenants_amount tenants; tenant_of maps a key to
+    // its tenant for feed() and the tenant-less calls, and defaults to a
+    // hash of the key. A rebalance_period of 0 keeps the static split
+    // unless rebalance() is called from outside
+    explicit MultiTenantARCCache(ssize_t budget, ssize_t tenants_amount = STD_TENANTS,
+                                 ssize_t rebalance_period = STD_REBALANCE_PERIOD, TenantSelector tenant_of = {})
+             : tenants_(), tenant_of_(std::move(tenant_of)), budget_(budget), step_(1), min_capacity_(1),
+               rebalance_period_(std::max<ssize_t>(0, rebalance_period)), rebalance_countdown_(rebalance_period_),
+               rebalances_(0), moved_(0)
+    {
+        LOG_INFO("Multi-tenant ARC cache", "Cache initialized with budget: ", budget,
+                                           "\ntenants: ", tenants_amount);
+        if (tenants_amount <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Tenants amount is INVALID, set\n tenants = STD_TENANTS = ", STD_TENANTS);
+            tenants_amount = STD_TENANTS;
+        }
+
+        if (budget_ < tenants_amount)
+        {
+            LOG_WARNING("BAD INPUT", "Budget is less than one entry per tenant, set\n budget = ", tenants_amount);
+            budget_ = tenants_amount;
+        }
+
+        if (!tenant_of_)
+            tenant_of_ = [](const key_t &key) { return shard_hash(key); };
+
+        const ssize_t share = budget_ / tenants_amount;
+
+        step_         = std::max<ssize_t>(1, share / STEP_DIVISOR);
+        min_capacity_ = std::max<ssize_t>(1, share / MIN_DIVISOR);
+
+        tenants_.reserve(static_cast<std::size_t>(tenants_amount));
+        for (ssize_t i = 0; i < tenants_amount; i++)
+            tenants_.push_back(std::make_unique<Tenant>(share + (i < budget_ % tenants_amount ? 1 : 0)));
+    }
+
+    MultiTenantARCCache(const MultiTenantARCCache &) = delete;
+    MultiTenantARCCache &operator=(const MultiTenantARCCache &) = delete;
+
+    // one step from the tenant of lowest utility to the one of highest,
+    // when they differ; returns whether capacity moved
+    bool rebalance()
+    {
+        std::size_t receiver = 0;
+        std::size_t donor    = tenants_.size();
+
+        for (std::size_t i = 0; i < tenants_.size(); i++)
+        {
+            Tenant &tenant = *tenants_[i];
+
+            const ssize_t ghost_hits = tenant.cache.get_ghost_hit_count();
+            const double  window     = static_cast<double>(ghost_hits - tenant.ghost_hits_seen) /
+                                       static_cast<double>(tenant.cache.capacity());
+
+            tenant.ghost_hits_seen = ghost_hits;
+            tenant.utility         = UTILITY_DECAY * tenant.utility + window;
+
+            if (tenant.utility > tenants_[receiver]->utility)
+                receiver = i;
+
+            if (tenant.cache.capacity() - step_ >= min_capacity_ &&
+                (donor == tenants_.size() || tenant.utility < tenants_[donor]->utility))
+                donor = i;
+        }
+
+        if (donor == tenants_.size() || donor == receiver ||
+            !(tenants_[receiver]->utility > tenants_[donor]->utility))
+            return false;
+
+        Tenant &from = *tenants_[donor];
+        Tenant &to   = *tenants_[receiver];
+
+        from.cache.set_capacity(from.cache.capacity() - step_);
+        to.cache.set_capacity(to.cache.capacity() + step_);
+
+        rebalances_++;
+        moved_ += step_;
+        return true;
+    }
+
+    bool add_cache(std::size_t tenant, const key_t &key, const item_t &item)
+    {
+        count_request();
+        return tenant_for(tenant).cache.add_cache(key, item);
+    }
+
+    inline bool add_cache(const key_t &key, const item_t &item)
+    {
+        return add_cache(tenant_of_(key), key, item);
+    }
+
+    item_t get_item(std::size_t tenant, const key_t &key) const
+    {
+        return tenants_[tenant % tenants_.size()]->cache.get_item(key);
+    }
+
+    // read-through access within a tenant: loader(key) runs on a miss
+    template <typename loader_t>
+    item_t get_or_load(std::size_t tenant, const key_t &key, loader_t &&loader)
+    {
+        count_request();
+        return tenant_for(tenant).cache.get_or_load(key, std::forward<loader_t>(loader));
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    inline ssize_t finish() override { return get_hit_count(); }
+
+    ssize_t get_hit_count() const override
+    {
+        ssize_t hits = 0;
+        for (const auto &tenant : tenants_)
+            hits += tenant->cache.get_hit_count();
+
+        return hits;
+    }
+
+    ssize_t get_request_count() const override
+    {
+        ssize_t requests = 0;
+        for (const auto &tenant : tenants_)
+            requests += tenant->cache.get_request_count();
+
+        return requests;
+    }
+
+    inline std::size_t tenants_amount() const { return tenants_.size(); }
+
+    inline ssize_t budget() const { return budget_; }
+
+    inline const TenantCache &tenant(std::size_t tenant) const { return tenants_[tenant % tenants_.size()]->cache; }
+
+    inline double utility(std::size_t tenant) const { return tenants_[tenant % tenants_.size()]->utility; }
+
+    // rebalances that moved capacity, and the entries they moved in total
+    inline ssize_t get_rebalance_count() const { return rebalances_; }
+    inline ssize_t get_moved_count()     const { return moved_; }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << get_hit_count() << std::endl;
+    }
+
+    // capacity, hit ratio and utility of every tenant
+    void print_tenant_report() const
+    {
+        for (std::size_t i = 0; i < tenants_.size(); i++)
+        {
+            const TenantCache &cache    = tenants_[i]->cache;
+            const ssize_t      requests = cache.get_request_count();
+
+            std::cout << "tenant " << i << ": capacity: " << cache.capacity()
+                      << ", requests: " << requests
+                      << ", hit ratio: " << (requests ? static_cast<double>(cache.get_hit_count()) /
+                                                        static_cast<double>(requests) : 0.0)
+                      << ", ghost hits: " << cache.get_ghost_hit_count()
+                      << ", utility: " << tenants_[i]->utility << std::endl;
+        }
+
+        std::cout << "budget: " << budget_ << ", rebalances: " << rebalances_
+                  << ", entries moved: " << moved_ << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("Multi-tenant ARC cache DUMP", "budget: ", budget_, "\ntenants: ", tenants_.size(),
+                 "\nrebalances: ", rebalances_);
+
+        for (const auto &tenant : tenants_)
+            tenant->cache.dump();
+    }
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef NODE_SLAB_HPP
+#define NODE_SLAB_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <cassert>
+
+// All nodes live in one contiguous arena and are linked by 32-bit indices,
+// so a list move is a relink of a few integers and never touches the heap.
+template <typename value_t>
+class NodeSlab
+{
+public:
+    using index_t = std::uint32_t;
+
+    static constexpr index_t NIL = UINT32_MAX;
+
+    struct IndexList
+    {
+        index_t head = NIL;
+        index_t tail = NIL;
+        std::size_t size = 0;
+
+        inline bool empty() const { return size == 0; }
+    };
+
+private:
+    struct Node
+    {
+        value_t value;
+        index_t prev;
+        index_t next;
+
+        Node() : value(), prev(NIL), next(NIL) {}
+    };
+
+    std::vector<Node> nodes_;
+    index_t free_head_;
+
+public:
+    explicit NodeSlab() : nodes_(), free_head_(NIL) {}
+
+    explicit NodeSlab(std::size_t capacity) : nodes_(), free_head_(NIL)
+    {
+        reserve(capacity);
+    }
+
+    void reserve(std::size_t capacity)
+    {
+        assert(capacity < NIL);
+
+        std::size_t old_size = nodes_.size();
+        if (capacity <= old_size) return;
+
+        nodes_.resize(capacity);
+        for (std::size_t i = capacity; i > old_size; i--)
+        {
+            nodes_[i - 1].next = free_head_;
+            free_head_ = static_cast<index_t>(i - 1);
+        }
+    }
+
+    inline std::size_t capacity() const { return nodes_.size(); }
+
+    inline std::size_t memory_usage() const { return nodes_.capacity() * sizeof(Node); }
+
+    // grows the arena only when the free list is exhausted, so after warm-up
+    // acquire() is a pop from the free list
+    index_t acquire()
+    {
+        if (free_head_ == NIL)
+            reserve(nodes_.empty() ? 1 : 2 * nodes_.size());
+
+        index_t index = free_head_;
+        free_head_ = nodes_[index].next;
+
+        nodes_[index].prev = NIL;
+        nodes_[index].next = NIL;
+        return index;
+    }
+
+    inline void release(index_t index)
+    {
+        assert(index < nodes_.size());
+
+        nodes_[index].prev = NIL;
+        nodes_[index].next = free_head_;
+        free_head_ = index;
+    }
+
+    inline value_t       &operator[](index_t index)       { return nodes_[index].value; }
+    inline const value_t &operator[](index_t index) const { return nodes_[index].value; }
+
+    inline index_t next(index_t index) const { return nodes_[index].next; }
+    inline index_t prev(index_t index) const { return nodes_[index].prev; }
+
+    void push_front(IndexList &list, index_t index)
+    {
+        Node &node = nodes_[index];
+        node.prev = NIL;
+        node.next = list.head;
+
+        if (list.head != NIL)
+            nodes_[list.head].prev = index;
+        else
+            list.tail = index;
+
+        list.head = index;
+        list.size++;
+    }
+
+    void unlink(IndexList &list, index_t index)
+    {
+        assert(!list.empty());
+
+        Node &node = nodes_[index];
+
+        if (node.prev != NIL) nodes_[node.prev].next = node.next;
+        else                  list.head = node.next;
+
+        if (node.next != NIL) nodes_[node.next].prev = node.prev;
+        else                  list.tail = node.prev;
+
+        node.prev = NIL;
+        node.next = NIL;
+        list.size--;
+    }
+
+    inline void move_to_front(IndexList &src, IndexList &dest, index_t index)
+    {
+        unlink(src, index);
+        push_front(dest, index);
+    }
+
+    inline index_t pop_back(IndexList &list)
+    {
+        index_t tail = list.tail;
+        unlink(list, tail);
+        return tail;
+    }
+
+    template <typename func_t>
+    void for_each(const IndexList &list, func_t &&func) const
+    {
+        for (index_t it = list.head; it != NIL; it = nodes_[it].next)
+            func(it, nodes_[it].value);
+    }
+};
+
+#endif
@@ -0,0 +1,365 @@
+#ifndef SHARDED_ARC_CACHE_HPP
+#define SHARDED_ARC_CACHE_HPP
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/log_config/log_config.hpp"
+#include "CacheInterface.hpp"
+#include "ARC/ARC_Cache.hpp"
+#include "utils/spin_lock/spin_lock.hpp"
+#include "utils/thread_pool/thread_pool.hpp"
+
+// the top bits pick the shard, the flat index inside a shard uses the low ones
+template <typename key_t>
+inline std::size_t shard_hash(const key_t &key)
+{
+    std::uint64_t h = static_cast<std::uint64_t>(std::hash<key_t>()(key));
+    h ^= h >> 31;
+    h *= 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 29;
+
+    return static_cast<std::size_t>(h >> 32);
+}
+
+// Keys are hash-partitioned over independent ARC shards, each behind its own
+// lock, so threads only contend when they hit the same shard.
+template <typename key_t, typename item_t,
+          typename lock_t = SpinLock,
+          template <typename, typename> class map_t = FlatHashIndex,
+          typename stats_t = NoARCStats>
+class ShardedARCCache : public CacheInterface<key_t, item_t>
+{
+private:
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+    static constexpr ssize_t     STD_SHARDS      = 16;
+
+    using ShardCache = ARCCache<key_t, item_t, map_t, KeyGhosts, stats_t>;
+
+    // a load in flight and the requests waiting on it
+    struct Loading
+    {
+        std::shared_future<item_t> future;
+        ssize_t                    joined;
+    };
+
+    // one shard per cache line at least, so a lock and the hot fields of
+    // the neighbouring shard never share a line
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        mutable lock_t lock;
+        ShardCache cache;
+
+        // keys whose loader is running; later requesters wait on the same result
+        std::unordered_map<key_t, Loading> loading;
+
+        // requests that joined a load, and those of them whose load
+        // succeeded; they never reach the shard cache's counters
+        ssize_t coalesced;
+        ssize_t coalesced_hits;
+
+        explicit Shard(ssize_t capacity) : lock(), cache(capacity), loading(), coalesced(0), coalesced_hits(0) {}
+    };
+
+    enum class LoadRole
+    {
+        HIT,
+        JOINED,
+        LEADER
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t shard_mask_;
+    ssize_t capacity_;
+
+    inline Shard &shard_for(const key_t &key) const
+    {
+        return *shards_[shard_hash(key) & shard_mask_];
+    }
+
+    // decides under the shard lock who serves a read-through request: the
+    // cache, a load already in flight (future), or the caller, who then
+    // runs the loader and fulfils promise
+    LoadRole claim(Shard &shard, const key_t &key, item_t &item,
+                   std::shared_future<item_t> &future, std::promise<item_t> &promise)
+    {
+        std::lock_guard<lock_t> guard(shard.lock);
+
+        if (shard.cache.lookup(key, item))
+            return LoadRole::HIT;
+
+        auto [loading_it, inserted] = shard.loading.try_emplace(key);
+        if (!inserted)
+        {
+            shard.coalesced++;
+            loading_it->second.joined++;
+            future = loading_it->second.future;
+            return LoadRole::JOINED;
+        }
+
+        future = promise.get_future().share();
+        loading_it->second = Loading{future, 0};
+        return LoadRole::LEADER;
+    }
+
+    // the loader runs without the shard lock. A loader that throws must not
+    // leave its key behind in loading, or every later request for it would
+    // wait on a result that never comes, so the exception goes to the waiters.
+    // Requests that joined a successful load are served by it: they count
+    // as hits, and as accesses after the first, so the key goes to T2
+    template <typename loader_t>
+    static void load(Shard &shard, const key_t &key, loader_t &loader, std::promise<item_t> &promise)
+    {
+        item_t item{};
+        try
+        {
+            item = loader(key);
+        }
+        catch (...)
+        {
+            {
+                std::lock_guard<lock_t> guard(shard.lock);
+                shard.loading.erase(key);
+            }
+
+            promise.set_exception(std::current_exception());
+            return;
+        }
+
+        {
+            std::lock_guard<lock_t> guard(shard.lock);
+            shard.cache.add_cache(key, item);
+
+            auto loading_it = shard.loading.find(key);
+            if (loading_it != shard.loading.end())
+            {
+                if (loading_it->second.joined != 0)
+                {
+                    shard.cache.promote(key);
+                    shard.coalesced_hits += loading_it->second.joined;
+                }
+
+                shard.loading.erase(loading_it);
+            }
+        }
+
+        promise.set_value(item);
+    }
+
+public:
+    explicit ShardedARCCache(ssize_t capacity, ssize_t shards_amount = STD_SHARDS)
+             : shards_(), shard_mask_(0), capacity_(capacity)
+    {
+        LOG_INFO("Sharded ARC cache", "Cache initialized with capacity: ", capacity,
+                                      "\nshards: ", shards_amount);
+        if (shards_amount <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Shards amount is INVALID, set\n shards = STD_SHARDS = ", STD_SHARDS);
+            shards_amount = STD_SHARDS;
+        }
+
+        std::size_t shards_pow2 = 1;
+        while (shards_pow2 < static_cast<std::size_t>(shards_amount))
+            shards_pow2 *= 2;
+
+        shard_mask_ = shards_pow2 - 1;
+
+        const ssize_t shards = static_cast<ssize_t>(shards_pow2);
+        if (capacity_ > 0 && capacity_ < shards)
+        {
+            LOG_WARNING("BAD INPUT", "Capacity is less than one entry per shard, set\n capacity = ", shards);
+            capacity_ = shards;
+        }
+
+        // the remainder goes one entry each to the first shards, so the
+        // shards add up to the capacity exactly
+        const ssize_t share = capacity_ / shards;
+
+        shards_.reserve(shards_pow2);
+        for (ssize_t i = 0; i < shards; i++)
+            shards_.push_back(std::make_unique<Shard>(share + (i < capacity_ % shards ? 1 : 0)));
+    }
+
+    inline std::size_t shards_amount() const { return shards_.size(); }
+
+    // entries all shards hold together at most
+    ssize_t capacity() const
+    {
+        ssize_t total = 0;
+        for (const auto &shard : shards_)
+            total += shard->cache.capacity();
+
+        return total;
+    }
+
+    // sums the per-shard counters and latencies into total; the counters
+    // are safe to read while the shards run, so no lock is taken
+    void collect_stats(ARCStats &total) const
+    {
+        static_assert(stats_t::ENABLED, "collect_stats needs a cache built with ARCStats");
+
+        for (const auto &shard : shards_)
+            total.merge(shard->cache.stats());
+    }
+
+    bool add_cache(const key_t &key, const item_t &item)
+    {
+        Shard &shard = shard_for(key);
+        std::lock_guard<lock_t> guard(shard.lock);
+
+        return shard.cache.add_cache(key, item);
+    }
+
+    item_t get_item(const key_t &key) const
+    {
+        Shard &shard = shard_for(key);
+        std::lock_guard<lock_t> guard(shard.lock);
+
+        return shard.cache.get_item(key);
+    }
+
+    // read-through access: only the first miss for a key runs loader(key),
+    // in the calling thread; concurrent requests for that key wait for its
+    // result instead of loading it again
+    template <typename loader_t>
+    item_t get_or_load(const key_t &key, loader_t &&loader)
+    {
+        Shard &shard = shard_for(key);
+
+        item_t item{};
+        std::shared_future<item_t> future;
+        std::promise<item_t> promise;
+
+        switch (claim(shard, key, item, future, promise))
+        {
+            case LoadRole::HIT:
+                return item;
+
+            case LoadRole::JOINED:
+                return future.get();
+
+            case LoadRole::LEADER:
+                load(shard, key, loader, promise);
+                return future.get();
+        }
+
+        return item;
+    }
+
+    // same, but the load of a leading miss is queued on pool and the
+    // result comes back as a future; the cache must outlive the queued loads
+    template <typename loader_t>
+    std::shared_future<item_t> get_or_load_async(const key_t &key, loader_t loader, ThreadPool &pool)
+    {
+        Shard &shard = shard_for(key);
+
+        item_t item{};
+        std::shared_future<item_t> future;
+        std::promise<item_t> promise;
+
+        switch (claim(shard, key, item, future, promise))
+        {
+            case LoadRole::HIT:
+                promise.set_value(item);
+                return promise.get_future().share();
+
+            case LoadRole::JOINED:
+                return future;
+
+            case LoadRole::LEADER:
+                pool.submit([&shard, key, loader = std::move(loader), promise = std::move(promise)]() mutable
+                {
+                    load(shard, key, loader, promise);
+                });
+                return future;
+        }
+
+        return future;
+    }
+
+    // requests that waited on another thread's load instead of running one
+    ssize_t get_coalesced_count() const
+    {
+        ssize_t coalesced = 0;
+        for (const auto &shard : shards_)
+        {
+            std::lock_guard<lock_t> guard(shard->lock);
+            coalesced += shard->coalesced;
+        }
+
+        return coalesced;
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        if (capacity_ <= 0)
+        {
+            LOG_ERROR("Sharded ARC cache", "capacity is INVALID. STOP IT");
+            return 0;
+        }
+
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    inline ssize_t finish() override { return get_hit_count(); }
+
+    // read-through requests served by another thread's load are hits
+    ssize_t get_hit_count() const override
+    {
+        ssize_t hits = 0;
+        for (const auto &shard : shards_)
+        {
+            std::lock_guard<lock_t> guard(shard->lock);
+            hits += shard->cache.get_hit_count() + shard->coalesced_hits;
+        }
+
+        return hits;
+    }
+
+    ssize_t get_request_count() const override
+    {
+        ssize_t requests = 0;
+        for (const auto &shard : shards_)
+        {
+            std::lock_guard<lock_t> guard(shard->lock);
+            requests += shard->cache.get_request_count() + shard->coalesced;
+        }
+
+        return requests;
+    }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << get_hit_count() << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("Sharded ARC cache DUMP", "capacity: ", capacity_, "\nshards: ", shards_.size());
+
+        for (const auto &shard : shards_)
+        {
+            std::lock_guard<lock_t> guard(shard->lock);
+            shard->cache.dump();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef TIERED_ARC_CACHE_HPP
+#define TIERED_ARC_CACHE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "utils/log_config/log_config.hpp"
+#include "CacheInterface.hpp"
+#include "ARC/ARC_Cache.hpp"
+#include "ARC/ARC_Stats.hpp"
+#include "ARC/ARC_Snapshot.hpp"
+#include "utils/log_store/log_store.hpp"
+#include "utils/stats/latency_histogram.hpp"
+
+// Two-tier cache: an ARCCache in memory (L1) over a LogStore file (L2).
+// Whatever L1 evicts (see set_eviction_handler) is demoted to L2 instead
+// of being dropped, while ARC keeps its ghosts as usual. A request that misses L1
+// and finds its key in L2 takes the item out of the file and admits it to
+// L1 again; ARC sees that as a miss, or as a ghost hit when the ghost is
+// still around, so p keeps adapting on what L1 alone would have held. The
+// tiers stay exclusive: a key is in L1 or in L2, never in both.
+//
+// Every request lands in one of three classes (L1 hit, L2 hit, miss), each
+// with its own count and latency histogram, so the two tiers can be sized
+// apart. Like the caches it is built from, it is not thread-safe.
+template <typename key_t, typename item_t,
+          template <typename, typename> class map_t = FlatHashIndex,
+          typename codec_t = TrivialItemCodec<item_t>>
+class TieredARCCache : public CacheInterface<key_t, item_t>
+{
+public:
+    enum class Tier
+    {
+        L1,
+        L2,
+        MISS,
+    };
+
+private:
+    using L1Type = ARCCache<key_t, item_t, map_t>;
+    using L2Type = LogStore<key_t, item_t, codec_t>;
+
+    L1Type l1_;
+    L2Type l2_;
+
+    ssize_t requests_counter_;
+    ssize_t l1_hits_;
+    ssize_t l2_hits_;
+
+    LatencyHistogram latency_[3];
+    std::uint32_t    latency_period_;
+    std::uint32_t    latency_countdown_;
+
+    static inline std::size_t index(Tier tier) { return static_cast<std::size_t>(tier); }
+
+    Tier process_request(const key_t &key, const item_t &item)
+    {
+        requests_counter_++;
+
+        if (l1_.lookup(key) != nullptr)
+        {
+            l1_hits_++;
+            return Tier::L1;
+        }
+
+        item_t cached{};
+        if (l2_.take(key, cached))
+        {
+            l2_hits_++;
+            l1_.emplace(key, std::move(cached));
+            return Tier::L2;
+        }
+
+        l1_.add_cache(key, item);
+        return Tier::MISS;
+    }
+
+    inline void print_tier(const char *name, Tier tier, ssize_t hits) const
+    {
+        const LatencyHistogram &latency = latency_[index(tier)];
+        const double            ratio   = requests_counter_ ? static_cast<double>(hits) /
+                                                              static_cast<double>(requests_counter_) : 0.0;
+
+        std::cout << name << ": " << hits << ", ratio: " << ratio
+                  << ", latency ns mean: " << latency.mean()
+                  << " p50: "  << latency.value_at_quantile(0.5)
+                  << " p99: "  << latency.value_at_quantile(0.99)
+                  << " max: "  << latency.max() << std::endl;
+    }
+
+public:
+    // capacity entries in memory and l2_bytes of file at l2_path; one
+    // request in latency_period is timed
+    explicit TieredARCCache(ssize_t capacity, const std::string &l2_path, std::size_t l2_bytes,
+                            bool direct_io = false, std::uint32_t latency_period = ARCStats::STD_LATENCY_PERIOD)
+             : l1_(capacity), l2_(l2_path, l2_bytes, direct_io), requests_counter_(0), l1_hits_(0), l2_hits_(0),
+               latency_(), latency_period_(latency_period ? latency_period : 1), latency_countdown_(1)
+    {
+        l1_.set_eviction_handler([this](const key_t &key, const item_t &item) { l2_.put(key, item); });
+    }
+
+    TieredARCCache(const TieredARCCache &) = delete;
+    TieredARCCache &operator=(const TieredARCCache &) = delete;
+
+    // true on a hit in either tier
+    bool add_cache(const key_t &key, const item_t &item)
+    {
+        if (--latency_countdown_ != 0)
+            return process_request(key, item) != Tier::MISS;
+
+        latency_countdown_ = latency_period_;
+
+        const auto start = std::chrono::steady_clock::now();
+        const Tier tier  = process_request(key, item);
+        const auto end   = std::chrono::steady_clock::now();
+
+        latency_[index(tier)].record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        return tier != Tier::MISS;
+    }
+
+    // read-through access over both tiers: loader(key) runs only when
+    // neither has the key
+    template <typename loader_t>
+    item_t get_or_load(const key_t &key, loader_t &&loader)
+    {
+        requests_counter_++;
+
+        if (const item_t *cached = l1_.lookup(key))
+        {
+            l1_hits_++;
+            return *cached;
+        }
+
+        item_t item{};
+        if (l2_.take(key, item))
+            l2_hits_++;
+        else
+            item = loader(key);
+
+        l1_.emplace(key, item);
+        return item;
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    inline ssize_t finish() override { return get_hit_count(); }
+
+    inline ssize_t get_hit_count()     const override { return l1_hits_ + l2_hits_; }
+    inline ssize_t get_request_count() const override { return requests_counter_; }
+
+    inline ssize_t get_l1_hit_count() const { return l1_hits_; }
+    inline ssize_t get_l2_hit_count() const { return l2_hits_; }
+
+    inline const LatencyHistogram &latency(Tier tier) const { return latency_[index(tier)]; }
+
+    inline const L1Type &l1() const { return l1_; }
+    inline const L2Type &l2() const { return l2_; }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << get_hit_count() << " (l1: " << l1_hits_ << ", l2: " << l2_hits_ << ")" << std::endl;
+    }
+
+    // hit ratios and latencies of each tier, and what the file side did
+    void print_tier_report() const
+    {
+        print_tier("l1 hits", Tier::L1,   l1_hits_);
+        print_tier("l2 hits", Tier::L2,   l2_hits_);
+        print_tier("misses",  Tier::MISS, requests_counter_ - l1_hits_ - l2_hits_);
+
+        std::cout << "l2 keys: " << l2_.size() << ", demoted: " << l2_.puts()
+                  << ", dropped on wrap: " << l2_.dropped()
+                  << ", reads from file: " << l2_.file_reads() << ", from memory: " << l2_.memory_reads()
+                  << ", bytes written: " << l2_.bytes_written() << ", write stalls: " << l2_.write_stalls()
+                  << ", direct io: " << l2_.direct_io() << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("Tiered ARC cache DUMP",
+        "requests: ", requests_counter_,
+        "\nl1 hits: ", l1_hits_,
+        "\nl2 hits: ", l2_hits_,
+        "\nl2 keys: ", l2_.size());
+
+        l1_.dump();
+    }
+};
+
+#endif
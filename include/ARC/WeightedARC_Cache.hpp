@@ -0,0 +1,365 @@
+#ifndef WEIGHTED_ARC_CACHE_HPP
+#define WEIGHTED_ARC_CACHE_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+
+#include "utils/log_config/log_config.hpp"
+#include "utils/cost/item_cost.hpp"
+#include "CacheInterface.hpp"
+#include "ARC/NodeSlab.hpp"
+#include "ARC/ARC_Cache.hpp"
+
+// ARC over a byte capacity. Every entry costs cost(key, item) units, T1+T2
+// hold at most capacity_ of them and B1+B2 remember at most capacity_ more
+// (each ghost keeps the size it was evicted with). REPLACE demotes LRU
+// entries until the incoming one fits, a ghost hit moves adapt_param_ by
+// the requested size scaled like ARC's delta, and an entry larger than the
+// whole cache is never admitted. With UnitCost this is exactly ARCCache.
+template <typename key_t, typename item_t,
+          typename cost_t = UnitCost<key_t, item_t>,
+          template <typename, typename> class map_t = StdHashIndex>
+class WeightedARCCache : public CacheInterface<key_t, item_t>
+{
+private:
+    enum class ListLocation
+    {
+        FIRST_LIST,
+        FREQUENT_LIST,
+        FIRST_LIST_GHOST,
+        FREQUENT_LIST_GHOST
+    };
+
+    struct CacheEntry
+    {
+        key_t key;
+        item_t item;
+        ssize_t size;
+
+        CacheEntry() : key(), item(), size(0) {}
+        CacheEntry(const key_t &k, const item_t &i, ssize_t s) : key(k), item(i), size(s) {}
+    };
+
+    struct GhostEntry
+    {
+        key_t key;
+        ssize_t size;
+
+        GhostEntry() : key(), size(0) {}
+        GhostEntry(const key_t &k, ssize_t s) : key(k), size(s) {}
+    };
+
+    using SlabType      = NodeSlab<CacheEntry>;
+    using GhostSlabType = NodeSlab<GhostEntry>;
+    using ListType      = typename SlabType::IndexList;
+    using GhostListType = typename GhostSlabType::IndexList;
+    using NodeIndex     = typename SlabType::index_t;
+
+    struct LocationInfo
+    {
+        ListLocation location;
+        NodeIndex node;
+
+        LocationInfo() : location(ListLocation::FIRST_LIST), node(SlabType::NIL) {}
+        LocationInfo(ListLocation loc, NodeIndex index) : location(loc), node(index) {}
+    };
+
+    using IndexType = map_t<key_t, LocationInfo>;
+    using IndexIter = typename IndexType::iterator;
+
+    static constexpr ssize_t STD_CAPACITY = 64;
+
+    ssize_t capacity_;
+    ssize_t hits_counter_;
+    ssize_t requests_counter_;
+    ssize_t byte_hits_counter_;
+    ssize_t byte_requests_counter_;
+    double  adapt_param_;
+
+    cost_t cost_;
+
+    // the amount of entries depends on their sizes, so the slabs grow on
+    // demand instead of being sized in the constructor
+    SlabType      entries_;
+    GhostSlabType ghosts_;
+
+    ListType      list_first_,       list_frequent_;
+    GhostListType list_first_ghost_, list_frequent_ghost_;
+
+    ssize_t first_bytes_,       frequent_bytes_;
+    ssize_t first_ghost_bytes_, frequent_ghost_bytes_;
+
+    // resident entries and ghosts share one index, the location tells them apart
+    IndexType index_;
+
+    inline ssize_t directory_bytes() const
+    {
+        return first_bytes_ + frequent_bytes_ + first_ghost_bytes_ + frequent_ghost_bytes_;
+    }
+
+    void adapt_ghost(ListLocation location, ssize_t size)
+    {
+        const bool first = (location == ListLocation::FIRST_LIST_GHOST);
+
+        const double nominator   = static_cast<double>(first ? frequent_ghost_bytes_ : first_ghost_bytes_);
+        const double denominator = static_cast<double>(first ? first_ghost_bytes_ : frequent_ghost_bytes_);
+
+        const double delta = static_cast<double>(size) * std::max(1.0, nominator / denominator);
+
+        adapt_param_ += first ? delta : -delta;
+        adapt_param_ = std::clamp(adapt_param_, 0.0, static_cast<double>(capacity_));
+    }
+
+    // evicts the LRU entry of a resident list, leaving its key and size behind
+    void demote_tail(ListType &src, ssize_t &src_bytes,
+                     GhostListType &dest, ssize_t &dest_bytes, ListLocation dest_location)
+    {
+        NodeIndex tail_node = entries_.pop_back(src);
+        const CacheEntry &entry = entries_[tail_node];
+
+        NodeIndex ghost_node = ghosts_.acquire();
+        ghosts_[ghost_node] = GhostEntry(entry.key, entry.size);
+        ghosts_.push_front(dest, ghost_node);
+
+        src_bytes  -= entry.size;
+        dest_bytes += entry.size;
+
+        index_.find(entry.key)->second = LocationInfo(dest_location, ghost_node);
+        entries_.release(tail_node);
+    }
+
+    void remove_tail(ListType &list, ssize_t &bytes)
+    {
+        NodeIndex tail_node = entries_.pop_back(list);
+
+        bytes -= entries_[tail_node].size;
+        index_.erase(entries_[tail_node].key);
+        entries_.release(tail_node);
+    }
+
+    void remove_ghost_tail(GhostListType &list, ssize_t &bytes)
+    {
+        NodeIndex tail_node = ghosts_.pop_back(list);
+
+        bytes -= ghosts_[tail_node].size;
+        index_.erase(ghosts_[tail_node].key);
+        ghosts_.release(tail_node);
+    }
+
+    // REPLACE, repeated until size more units fit
+    void replace(ssize_t size, bool frequent_ghost_hit)
+    {
+        const ssize_t target = static_cast<ssize_t>(adapt_param_);
+
+        while (first_bytes_ + frequent_bytes_ + size > capacity_ &&
+               !(list_first_.empty() && list_frequent_.empty()))
+        {
+            const bool from_first = !list_first_.empty() &&
+                                    (first_bytes_ > target ||
+                                     (first_bytes_ == target && frequent_ghost_hit) ||
+                                     list_frequent_.empty());
+
+            if (from_first)
+                demote_tail(list_first_, first_bytes_, list_first_ghost_, first_ghost_bytes_,
+                            ListLocation::FIRST_LIST_GHOST);
+            else
+                demote_tail(list_frequent_, frequent_bytes_, list_frequent_ghost_, frequent_ghost_bytes_,
+                            ListLocation::FREQUENT_LIST_GHOST);
+        }
+    }
+
+    // a demotion of a large entry may push a ghost list past its bound
+    void trim_ghosts()
+    {
+        while (first_bytes_ + first_ghost_bytes_ > capacity_ && !list_first_ghost_.empty())
+            remove_ghost_tail(list_first_ghost_, first_ghost_bytes_);
+
+        while (directory_bytes() > 2 * capacity_)
+        {
+            if      (!list_frequent_ghost_.empty()) remove_ghost_tail(list_frequent_ghost_, frequent_ghost_bytes_);
+            else if (!list_first_ghost_.empty())    remove_ghost_tail(list_first_ghost_, first_ghost_bytes_);
+            else break;
+        }
+    }
+
+    void insert(ListType &list, ssize_t &bytes, ListLocation location,
+                const key_t &key, const item_t &item, ssize_t size)
+    {
+        NodeIndex node = entries_.acquire();
+        entries_[node] = CacheEntry(key, item, size);
+        entries_.push_front(list, node);
+        bytes += size;
+
+        index_.emplace(key, LocationInfo(location, node));
+    }
+
+    bool handle_existing_item(const IndexIter &index_it)
+    {
+        LocationInfo &info = index_it->second;
+        const ssize_t size = entries_[info.node].size;
+
+        if (info.location == ListLocation::FIRST_LIST)
+        {
+            entries_.move_to_front(list_first_, list_frequent_, info.node);
+            first_bytes_    -= size;
+            frequent_bytes_ += size;
+            info.location = ListLocation::FREQUENT_LIST;
+        }
+        else
+            entries_.move_to_front(list_frequent_, list_frequent_, info.node);
+
+        hits_counter_++;
+        byte_hits_counter_ += size;
+        return true;
+    }
+
+    void handle_ghost(const IndexIter &index_it, const key_t &key, const item_t &item, ssize_t size)
+    {
+        const ListLocation location  = index_it->second.location;
+        const NodeIndex   ghost_node = index_it->second.node;
+
+        adapt_ghost(location, size);
+
+        if (location == ListLocation::FIRST_LIST_GHOST)
+        {
+            ghosts_.unlink(list_first_ghost_, ghost_node);
+            first_ghost_bytes_ -= ghosts_[ghost_node].size;
+        }
+        else
+        {
+            ghosts_.unlink(list_frequent_ghost_, ghost_node);
+            frequent_ghost_bytes_ -= ghosts_[ghost_node].size;
+        }
+
+        ghosts_.release(ghost_node);
+        index_.erase(index_it);
+
+        replace(size, location == ListLocation::FREQUENT_LIST_GHOST);
+        insert(list_frequent_, frequent_bytes_, ListLocation::FREQUENT_LIST, key, item, size);
+    }
+
+    void add_new_item(const key_t &key, const item_t &item, ssize_t size)
+    {
+        // L1 = T1 + B1 keeps within capacity_: forget B1 first, and when T1
+        // alone leaves no room, drop its LRU without a ghost
+        while (first_bytes_ + first_ghost_bytes_ + size > capacity_ && !list_first_ghost_.empty())
+            remove_ghost_tail(list_first_ghost_, first_ghost_bytes_);
+
+        while (first_bytes_ + size > capacity_)
+            remove_tail(list_first_, first_bytes_);
+
+        while (directory_bytes() + size > 2 * capacity_ && !list_frequent_ghost_.empty())
+            remove_ghost_tail(list_frequent_ghost_, frequent_ghost_bytes_);
+
+        replace(size, false);
+        insert(list_first_, first_bytes_, ListLocation::FIRST_LIST, key, item, size);
+    }
+
+public:
+    explicit WeightedARCCache(ssize_t capacity = STD_CAPACITY, cost_t cost = cost_t())
+             : capacity_(capacity), hits_counter_(0), requests_counter_(0),
+               byte_hits_counter_(0), byte_requests_counter_(0), adapt_param_(0.0), cost_(cost),
+               entries_(), ghosts_(), first_bytes_(0), frequent_bytes_(0),
+               first_ghost_bytes_(0), frequent_ghost_bytes_(0)
+    {
+        LOG_INFO("Weighted ARC cache", "Cache initialized with capacity: ", capacity);
+
+        if (capacity <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Capacity is INVALID, set\n capacity = STD_CAPACITY = ", STD_CAPACITY);
+            capacity_ = STD_CAPACITY;
+        }
+    }
+
+    item_t get_item(const key_t &key) const
+    {
+        auto index_it = index_.find(key);
+        if (index_it == index_.end()) return item_t();
+
+        const LocationInfo &info = index_it->second;
+        if (info.location != ListLocation::FIRST_LIST && info.location != ListLocation::FREQUENT_LIST)
+            return item_t();
+
+        return entries_[info.node].item;
+    }
+
+    bool add_cache(const key_t &key, const item_t &item)
+    {
+        // a zero cost would let an entry in without ever making room
+        const ssize_t size = std::max<ssize_t>(1, cost_(key, item));
+
+        requests_counter_++;
+        byte_requests_counter_ += size;
+
+        IndexIter index_it = index_.find(key);
+        if (index_it != index_.end() &&
+            (index_it->second.location == ListLocation::FIRST_LIST ||
+             index_it->second.location == ListLocation::FREQUENT_LIST))
+            return handle_existing_item(index_it);
+
+        if (size > capacity_)
+            return false;
+
+        if (index_it != index_.end())
+            handle_ghost(index_it, key, item, size);
+        else
+            add_new_item(key, item, size);
+
+        trim_ghosts();
+        return false;
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    inline ssize_t finish() override { return get_hit_count(); }
+
+    inline ssize_t get_hit_count() const override { return hits_counter_; }
+
+    inline ssize_t get_request_count() const override { return requests_counter_; }
+
+    inline ssize_t get_byte_hit_count() const { return byte_hits_counter_; }
+
+    inline ssize_t get_byte_request_count() const { return byte_requests_counter_; }
+
+    inline ssize_t get_used_bytes() const { return first_bytes_ + frequent_bytes_; }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << hits_counter_ << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("Weighted ARC cache DUMP", "capacity: ", capacity_, "\nhit count: ", hits_counter_,
+                                           "\nbyte hit count: ", byte_hits_counter_,
+                                           "\nadaptive parameter: ", adapt_param_,
+                                           "\nT1/T2/B1/B2 bytes: ", first_bytes_, " ", frequent_bytes_,
+                                           " ", first_ghost_bytes_, " ", frequent_ghost_bytes_);
+
+        entries_.for_each(list_first_, [](NodeIndex, const CacheEntry &entry)
+        {
+            LOG_DUMP("T1", "[ key: ", entry.key, " size: ", entry.size, " ]");
+        });
+        entries_.for_each(list_frequent_, [](NodeIndex, const CacheEntry &entry)
+        {
+            LOG_DUMP("T2", "[ key: ", entry.key, " size: ", entry.size, " ]");
+        });
+    }
+};
+
+#endif
@@ -4,14 +4,33 @@
 #include <iostream>
 #include <vector>
 
+#include "RequestSpan.hpp"
+
 template <typename key_t, typename item_t>
 class CacheInterface 
 {
 public:
-    virtual ssize_t run_cache(const std::vector<std::pair<key_t, item_t>>& requests) = 0;
+    using request_t    = std::pair<key_t, item_t>;
+    using request_span = RequestSpan<key_t, item_t>;
+
+    virtual ssize_t run_cache(request_span requests) = 0;
     
+    ssize_t run_cache(const std::vector<request_t> &requests)
+    {
+        return run_cache(request_span(requests));
+    }
     
+    // Incremental replay: batches are fed in trace order and the counters
+    // can be read between them. finish() flushes whatever the cache still
+    // holds back (OPT keeps a look-ahead window) and returns the hits.
+    virtual void    feed(request_span batch) = 0;
+    virtual ssize_t finish() = 0;
+
     virtual ssize_t get_hit_count() const = 0;
+    virtual ssize_t get_request_count() const = 0;
+
+    inline ssize_t get_miss_count() const { return get_request_count() - get_hit_count(); }
+
     virtual void print_hit_count() const = 0;
     virtual void dump() const = 0;
 };
@@ -0,0 +1,242 @@
+#ifndef CLOCK_PRO_CACHE_HPP
+#define CLOCK_PRO_CACHE_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+#include "utils/log_config/log_config.hpp"
+#include "CacheInterface.hpp"
+#include "ARC/NodeSlab.hpp"
+
+// CLOCK-Pro (Jiang, Chen & Zhang) with one clock per page kind, so each
+// hand only ever visits pages it can act on and every step either clears
+// a reference bit set by a hit or moves a page:
+//   HAND_cold evicts unreferenced cold pages (they stay as test pages) and
+//             promotes referenced ones to hot,
+//   HAND_hot  gives referenced hot pages another round and demotes the
+//             others to cold once hot pages exceed their share,
+//   HAND_test retires the oldest test page to keep at most capacity of them.
+// A hit only sets the reference bit. A miss on a test page grows the cold
+// share, an expired test period shrinks it.
+template <typename key_t, typename item_t>
+class ClockProCache : public CacheInterface<key_t, item_t>
+{
+private:
+    static constexpr ssize_t STD_CAPACITY = 16;
+
+    enum class PageType
+    {
+        HOT,
+        COLD,
+        TEST
+    };
+
+    struct Page
+    {
+        key_t key;
+        item_t item;
+        PageType type;
+        bool referenced;
+
+        Page() : key(), item(), type(PageType::COLD), referenced(false) {}
+        Page(const key_t &k, const item_t &i, PageType t) : key(k), item(i), type(t), referenced(false) {}
+    };
+
+    using SlabType  = NodeSlab<Page>;
+    using ListType  = typename SlabType::IndexList;
+    using NodeIndex = typename SlabType::index_t;
+
+    using PageMap  = std::unordered_map<key_t, NodeIndex>;
+    using PageIter = typename PageMap::iterator;
+
+    ssize_t capacity_;
+    ssize_t cold_target_;
+    ssize_t hits_counter_;
+    ssize_t requests_counter_;
+
+    // every clock's hand is its tail, a page that survives the hand goes
+    // back to the head; new pages enter at the head too
+    SlabType pages_;
+    ListType clock_hot_;
+    ListType clock_cold_;
+    ListType clock_test_;
+
+    PageMap page_map_;
+
+    inline ListType &clock_of(PageType type)
+    {
+        switch (type)
+        {
+            case PageType::HOT:  return clock_hot_;
+            case PageType::COLD: return clock_cold_;
+            default:             return clock_test_;
+        }
+    }
+
+    inline ssize_t resident_size() const
+    {
+        return static_cast<ssize_t>(clock_hot_.size + clock_cold_.size);
+    }
+
+    void move_page(NodeIndex node, PageType dest)
+    {
+        pages_.move_to_front(clock_of(pages_[node].type), clock_of(dest), node);
+        pages_[node].type       = dest;
+        pages_[node].referenced = false;
+    }
+
+    void insert_page(const key_t &key, const item_t &item, PageType type)
+    {
+        NodeIndex node = pages_.acquire();
+        pages_[node] = Page(key, item, type);
+        pages_.push_front(clock_of(type), node);
+        page_map_.emplace(key, node);
+    }
+
+    void remove_page(PageIter page_it)
+    {
+        const NodeIndex node = page_it->second;
+
+        pages_.unlink(clock_of(pages_[node].type), node);
+        pages_.release(node);
+        page_map_.erase(page_it);
+    }
+
+    void run_hand_test()
+    {
+        cold_target_ = std::max<ssize_t>(1, cold_target_ - 1);
+        remove_page(page_map_.find(pages_[clock_test_.tail].key));
+    }
+
+    void run_hand_hot()
+    {
+        const NodeIndex node = clock_hot_.tail;
+
+        if (pages_[node].referenced) move_page(node, PageType::HOT);
+        else                         move_page(node, PageType::COLD);
+    }
+
+    // turns exactly one resident cold page into a test page
+    void run_hand_cold()
+    {
+        for (;;)
+        {
+            while (static_cast<ssize_t>(clock_hot_.size) > capacity_ - cold_target_ || clock_cold_.empty())
+                run_hand_hot();
+
+            const NodeIndex node = clock_cold_.tail;
+            if (pages_[node].referenced)
+            {
+                move_page(node, PageType::HOT);
+                continue;
+            }
+
+            pages_[node].item = item_t();
+            move_page(node, PageType::TEST);
+
+            while (static_cast<ssize_t>(clock_test_.size) > capacity_)
+                run_hand_test();
+
+            return;
+        }
+    }
+
+public:
+    explicit ClockProCache(ssize_t capacity = STD_CAPACITY)
+             : capacity_(capacity), cold_target_(0), hits_counter_(0), requests_counter_(0),
+               pages_(), clock_hot_(), clock_cold_(), clock_test_(), page_map_()
+    {
+        LOG_INFO("CLOCK-Pro cache", "Cache initialized with capacity: ", capacity);
+
+        if (capacity <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Capacity is INVALID, set\n capacity = STD_CAPACITY = ", STD_CAPACITY);
+            capacity_ = STD_CAPACITY;
+        }
+
+        // starts as plain CLOCK; expired test periods hand space to hot pages
+        cold_target_ = capacity_;
+
+        pages_.reserve(2 * capacity_ + 1);
+        page_map_.reserve(2 * capacity_ + 1);
+    }
+
+    item_t get_item(const key_t &key) const
+    {
+        auto page_it = page_map_.find(key);
+        if (page_it == page_map_.end() || pages_[page_it->second].type == PageType::TEST)
+            return item_t();
+
+        return pages_[page_it->second].item;
+    }
+
+    bool add_cache(const key_t &key, const item_t &item)
+    {
+        requests_counter_++;
+
+        PageIter page_it = page_map_.find(key);
+        if (page_it != page_map_.end())
+        {
+            Page &page = pages_[page_it->second];
+            if (page.type != PageType::TEST)
+            {
+                page.referenced = true;
+                hits_counter_++;
+                return true;
+            }
+
+            // reused within its test period: cold pages deserve more room
+            cold_target_ = std::min(capacity_, cold_target_ + 1);
+            remove_page(page_it);
+
+            if (resident_size() >= capacity_)
+                run_hand_cold();
+
+            insert_page(key, item, PageType::HOT);
+            return false;
+        }
+
+        if (resident_size() >= capacity_)
+            run_hand_cold();
+
+        insert_page(key, item, PageType::COLD);
+        return false;
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    inline ssize_t finish() override { return hits_counter_; }
+
+    inline ssize_t get_hit_count()     const override { return hits_counter_; }
+    inline ssize_t get_request_count() const override { return requests_counter_; }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << hits_counter_ << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("CLOCK-Pro cache DUMP", "capacity: ", capacity_, "\nhit count: ", hits_counter_,
+                                         "\ncold target: ", cold_target_,
+                                         "\nhot: ", clock_hot_.size, " cold: ", clock_cold_.size,
+                                         " test: ", clock_test_.size);
+    }
+};
+
+#endif
@@ -0,0 +1,319 @@
+#ifndef LIRS_CACHE_HPP
+#define LIRS_CACHE_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+#include "utils/log_config/log_config.hpp"
+#include "CacheInterface.hpp"
+#include "ARC/NodeSlab.hpp"
+
+// LIRS (Jiang & Zhang). Keys with a small inter-reference recency are LIR
+// and stay resident; the rest are HIR and only a small share of the cache
+// (the Q list) holds them. The stack S orders keys by recency and also
+// keeps recently evicted HIR keys: a miss on one of those proves a short
+// reuse distance and makes it LIR, pushing the LIR key at the bottom of S
+// out to Q. S is pruned so its bottom is always LIR.
+template <typename key_t, typename item_t>
+class LIRSCache : public CacheInterface<key_t, item_t>
+{
+private:
+    static constexpr ssize_t STD_CAPACITY = 16;
+
+    static constexpr double HIR_RATIO         = 0.01;
+    static constexpr double NONRESIDENT_RATIO = 2.0;
+
+    enum class Status
+    {
+        LIR,
+        HIR_RESIDENT,
+        HIR_NONRESIDENT
+    };
+
+    using SlabType  = NodeSlab<key_t>;
+    using ListType  = typename SlabType::IndexList;
+    using NodeIndex = typename SlabType::index_t;
+
+    static constexpr NodeIndex NIL_NODE = SlabType::NIL;
+
+    // queue_node links a resident HIR key into Q, or a non-resident one into
+    // the list that bounds how many of them S keeps
+    struct Meta
+    {
+        Status status;
+        NodeIndex stack_node;
+        NodeIndex queue_node;
+        item_t item;
+    };
+
+    using MetaMap  = std::unordered_map<key_t, Meta>;
+    using MetaIter = typename MetaMap::iterator;
+
+    ssize_t capacity_;
+    ssize_t lir_capacity_;
+    ssize_t nonresident_capacity_;
+    ssize_t lir_size_;
+    ssize_t resident_size_;
+    ssize_t hits_counter_;
+    ssize_t requests_counter_;
+
+    SlabType stack_nodes_;
+    SlabType queue_nodes_;
+
+    ListType stack_;
+    ListType queue_;
+    ListType nonresident_;
+
+    MetaMap meta_map_;
+
+    void stack_to_top(const key_t &key, Meta &meta)
+    {
+        if (meta.stack_node != NIL_NODE)
+        {
+            stack_nodes_.move_to_front(stack_, stack_, meta.stack_node);
+            return;
+        }
+
+        meta.stack_node = stack_nodes_.acquire();
+        stack_nodes_[meta.stack_node] = key;
+        stack_nodes_.push_front(stack_, meta.stack_node);
+    }
+
+    void stack_remove(Meta &meta)
+    {
+        stack_nodes_.unlink(stack_, meta.stack_node);
+        stack_nodes_.release(meta.stack_node);
+        meta.stack_node = NIL_NODE;
+    }
+
+    void queue_push(ListType &list, const key_t &key, Meta &meta)
+    {
+        meta.queue_node = queue_nodes_.acquire();
+        queue_nodes_[meta.queue_node] = key;
+        queue_nodes_.push_front(list, meta.queue_node);
+    }
+
+    void queue_remove(ListType &list, Meta &meta)
+    {
+        queue_nodes_.unlink(list, meta.queue_node);
+        queue_nodes_.release(meta.queue_node);
+        meta.queue_node = NIL_NODE;
+    }
+
+    // drops HIR keys from the bottom of S until an LIR key is there;
+    // non-resident keys leaving S are forgotten
+    void prune()
+    {
+        while (!stack_.empty())
+        {
+            MetaIter meta_it = meta_map_.find(stack_nodes_[stack_.tail]);
+            Meta &meta = meta_it->second;
+
+            if (meta.status == Status::LIR) return;
+
+            stack_remove(meta);
+            if (meta.status == Status::HIR_NONRESIDENT)
+            {
+                queue_remove(nonresident_, meta);
+                meta_map_.erase(meta_it);
+            }
+        }
+    }
+
+    void demote_bottom_lir()
+    {
+        const key_t key = stack_nodes_[stack_.tail];
+        Meta &meta = meta_map_.find(key)->second;
+
+        meta.status = Status::HIR_RESIDENT;
+        lir_size_--;
+
+        stack_remove(meta);
+        queue_push(queue_, key, meta);
+        prune();
+    }
+
+    // evicts the front of Q; a key still in S stays as a non-resident HIR
+    void evict()
+    {
+        if (queue_.empty())
+            demote_bottom_lir();
+
+        const key_t key = queue_nodes_[queue_.tail];
+        MetaIter meta_it = meta_map_.find(key);
+        Meta &meta = meta_it->second;
+
+        queue_remove(queue_, meta);
+        resident_size_--;
+
+        if (meta.stack_node == NIL_NODE)
+        {
+            meta_map_.erase(meta_it);
+            return;
+        }
+
+        meta.status = Status::HIR_NONRESIDENT;
+        meta.item   = item_t();
+        queue_push(nonresident_, key, meta);
+
+        if (static_cast<ssize_t>(nonresident_.size) > nonresident_capacity_)
+        {
+            MetaIter oldest_it = meta_map_.find(queue_nodes_[nonresident_.tail]);
+
+            stack_remove(oldest_it->second);
+            queue_remove(nonresident_, oldest_it->second);
+            meta_map_.erase(oldest_it);
+        }
+    }
+
+public:
+    explicit LIRSCache(ssize_t capacity = STD_CAPACITY)
+             : capacity_(capacity), lir_capacity_(0), nonresident_capacity_(0), lir_size_(0), resident_size_(0),
+               hits_counter_(0), requests_counter_(0), stack_nodes_(), queue_nodes_(),
+               stack_(), queue_(), nonresident_(), meta_map_()
+    {
+        LOG_INFO("LIRS cache", "Cache initialized with capacity: ", capacity);
+
+        if (capacity <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Capacity is INVALID, set\n capacity = STD_CAPACITY = ", STD_CAPACITY);
+            capacity_ = STD_CAPACITY;
+        }
+
+        const ssize_t hir_capacity = std::max<ssize_t>(1, static_cast<ssize_t>(capacity_ * HIR_RATIO));
+
+        lir_capacity_         = std::max<ssize_t>(1, capacity_ - hir_capacity);
+        nonresident_capacity_ = std::max<ssize_t>(1, static_cast<ssize_t>(capacity_ * NONRESIDENT_RATIO));
+
+        stack_nodes_.reserve(capacity_ + nonresident_capacity_);
+        queue_nodes_.reserve(hir_capacity + nonresident_capacity_);
+        meta_map_.reserve(capacity_ + nonresident_capacity_);
+    }
+
+    item_t get_item(const key_t &key) const
+    {
+        auto meta_it = meta_map_.find(key);
+        if (meta_it == meta_map_.end() || meta_it->second.status == Status::HIR_NONRESIDENT)
+            return item_t();
+
+        return meta_it->second.item;
+    }
+
+    bool add_cache(const key_t &key, const item_t &item)
+    {
+        requests_counter_++;
+
+        MetaIter meta_it = meta_map_.find(key);
+        if (meta_it != meta_map_.end() && meta_it->second.status == Status::LIR)
+        {
+            Meta &meta = meta_it->second;
+            const bool was_bottom = stack_.tail == meta.stack_node;
+
+            stack_to_top(key, meta);
+            if (was_bottom) prune();
+
+            hits_counter_++;
+            return true;
+        }
+
+        if (meta_it != meta_map_.end() && meta_it->second.status == Status::HIR_RESIDENT)
+        {
+            Meta &meta = meta_it->second;
+
+            queue_remove(queue_, meta);
+            if (meta.stack_node != NIL_NODE)
+            {
+                meta.status = Status::LIR;
+                lir_size_++;
+
+                stack_to_top(key, meta);
+                if (lir_size_ > lir_capacity_)
+                    demote_bottom_lir();
+            }
+            else
+            {
+                stack_to_top(key, meta);
+                queue_push(queue_, key, meta);
+            }
+
+            hits_counter_++;
+            return true;
+        }
+
+        // eviction may forget this very key if it is the oldest non-resident
+        if (resident_size_ >= capacity_)
+        {
+            evict();
+            meta_it = meta_map_.find(key);
+        }
+
+        resident_size_++;
+
+        if (meta_it == meta_map_.end())
+        {
+            Meta &meta = meta_map_.emplace(key, Meta{Status::LIR, NIL_NODE, NIL_NODE, item}).first->second;
+            stack_to_top(key, meta);
+
+            if (lir_size_ < lir_capacity_)
+                lir_size_++;
+            else
+            {
+                meta.status = Status::HIR_RESIDENT;
+                queue_push(queue_, key, meta);
+            }
+
+            return false;
+        }
+
+        Meta &meta = meta_it->second;
+
+        queue_remove(nonresident_, meta);
+        meta.status = Status::LIR;
+        meta.item   = item;
+        lir_size_++;
+
+        stack_to_top(key, meta);
+        if (lir_size_ > lir_capacity_)
+            demote_bottom_lir();
+
+        return false;
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    inline ssize_t finish() override { return hits_counter_; }
+
+    inline ssize_t get_hit_count()     const override { return hits_counter_; }
+    inline ssize_t get_request_count() const override { return requests_counter_; }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << hits_counter_ << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("LIRS cache DUMP", "capacity: ", capacity_, "\nhit count: ", hits_counter_,
+                                    "\nLIR: ", lir_size_, " of ", lir_capacity_,
+                                    "\nresident HIR: ", queue_.size,
+                                    "\nnon-resident HIR: ", nonresident_.size,
+                                    "\nstack S: ", stack_.size);
+    }
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef LRU_CACHE_HPP
+#define LRU_CACHE_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "utils/log_config/log_config.hpp"
+#include "CacheInterface.hpp"
+#include "LRU/LRU_StackDistance.hpp"
+
+// LRU baseline driven by stack distances: one pass answers the hit count of
+// every capacity at once, capacity_ only picks the one reported through
+// CacheInterface. Like OPT it simulates decisions and does not keep items.
+template <typename key_t, typename item_t>
+class LRUCache : public CacheInterface<key_t, item_t>
+{
+private:
+    static constexpr ssize_t STD_CAPACITY = 16;
+
+    ssize_t capacity_;
+    ssize_t hits_counter_;
+
+    LRUStackDistance<key_t> distances_;
+
+public:
+    explicit LRUCache() : capacity_(STD_CAPACITY), hits_counter_(0), distances_() {}
+
+    explicit LRUCache(ssize_t capacity) : capacity_(capacity), hits_counter_(0), distances_()
+    {
+        LOG_INFO("LRU cache", "Cache initialized with capacity: ", capacity);
+
+        if (capacity <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Capacity is INVALID, set\n capacity = STD_CAPACITY = ", STD_CAPACITY);
+            capacity_ = STD_CAPACITY;
+        }
+    }
+
+    bool add_cache(const key_t &key, const item_t &)
+    {
+        const std::size_t depth = distances_.access(key);
+
+        if (depth == LRUStackDistance<key_t>::COLD || depth > static_cast<std::size_t>(capacity_))
+            return false;
+
+        hits_counter_++;
+        return true;
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    inline ssize_t finish() override { return hits_counter_; }
+
+    inline ssize_t get_hit_count() const override { return hits_counter_; }
+
+    inline ssize_t get_request_count() const override
+    {
+        return static_cast<ssize_t>(distances_.requests());
+    }
+
+    // hits an LRU cache of any capacity would have had on the same requests
+    inline ssize_t get_hit_count(ssize_t capacity) const
+    {
+        return capacity > 0 ? static_cast<ssize_t>(distances_.hits(static_cast<std::size_t>(capacity))) : 0;
+    }
+
+    // histogram()[d] is the amount of requests at stack depth d (d >= 1);
+    // first accesses are counted by cold_misses() only
+    inline const std::vector<std::uint64_t> &histogram() const { return distances_.histogram(); }
+
+    inline std::uint64_t cold_misses() const { return distances_.cold_misses(); }
+
+    inline std::size_t memory_usage() const { return distances_.memory_usage(); }
+
+    // hit ratio for capacities 1..max_capacity as CSV, one cumulative pass
+    void print_curve(std::ostream &out, std::size_t max_capacity) const
+    {
+        const std::vector<std::uint64_t> &depths = distances_.histogram();
+        const double total = static_cast<double>(distances_.requests());
+
+        out << "capacity,LRU\n";
+
+        std::uint64_t hits = 0;
+        for (std::size_t capacity = 1; capacity <= max_capacity; capacity++)
+        {
+            if (capacity < depths.size())
+                hits += depths[capacity];
+
+            out << capacity << ',' << (total > 0 ? static_cast<double>(hits) / total : 0.0) << '\n';
+        }
+    }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << hits_counter_ << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("LRU cache DUMP", "capacity: ", capacity_,
+                                   "\nhit count: ", hits_counter_,
+                                   "\nrequests: ", distances_.requests(),
+                                   "\ndistinct keys: ", distances_.distinct(),
+                                   "\nmax stack depth: ", distances_.histogram().size() - 1);
+    }
+};
+
+#endif
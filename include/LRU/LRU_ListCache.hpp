@@ -0,0 +1,132 @@
+#ifndef LRU_LIST_CACHE_HPP
+#define LRU_LIST_CACHE_HPP
+
+#include <iostream>
+#include <unordered_map>
+
+#include "utils/log_config/log_config.hpp"
+#include "CacheInterface.hpp"
+#include "ARC/NodeSlab.hpp"
+
+// Plain LRU holding items: a recency list in a NodeSlab plus a key index.
+// LRUCache answers the same hit counts from stack distances; this one is
+// the cache itself, for timing it against the other policies.
+template <typename key_t, typename item_t>
+class LRUListCache : public CacheInterface<key_t, item_t>
+{
+private:
+    static constexpr ssize_t STD_CAPACITY = 16;
+
+    struct CacheEntry
+    {
+        key_t key;
+        item_t item;
+
+        CacheEntry() : key(), item() {}
+        CacheEntry(const key_t &k, const item_t &i) : key(k), item(i) {}
+    };
+
+    using SlabType  = NodeSlab<CacheEntry>;
+    using ListType  = typename SlabType::IndexList;
+    using NodeIndex = typename SlabType::index_t;
+
+    ssize_t capacity_;
+    ssize_t hits_counter_;
+    ssize_t requests_counter_;
+
+    SlabType entries_;
+    ListType list_;
+
+    std::unordered_map<key_t, NodeIndex> cache_map_;
+
+public:
+    explicit LRUListCache(ssize_t capacity = STD_CAPACITY)
+             : capacity_(capacity), hits_counter_(0), requests_counter_(0), entries_(), list_(), cache_map_()
+    {
+        LOG_INFO("LRU list cache", "Cache initialized with capacity: ", capacity);
+
+        if (capacity <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Capacity is INVALID, set\n capacity = STD_CAPACITY = ", STD_CAPACITY);
+            capacity_ = STD_CAPACITY;
+        }
+
+        entries_.reserve(capacity_);
+        cache_map_.reserve(capacity_);
+    }
+
+    item_t get_item(const key_t &key) const
+    {
+        auto cache_map_it = cache_map_.find(key);
+        if (cache_map_it == cache_map_.end()) return item_t();
+
+        return entries_[cache_map_it->second].item;
+    }
+
+    bool add_cache(const key_t &key, const item_t &item)
+    {
+        requests_counter_++;
+
+        auto cache_map_it = cache_map_.find(key);
+        if (cache_map_it != cache_map_.end())
+        {
+            hits_counter_++;
+            entries_.move_to_front(list_, list_, cache_map_it->second);
+            return true;
+        }
+
+        if (static_cast<ssize_t>(list_.size) >= capacity_)
+        {
+            NodeIndex tail = entries_.pop_back(list_);
+            cache_map_.erase(entries_[tail].key);
+            entries_.release(tail);
+        }
+
+        NodeIndex node = entries_.acquire();
+        entries_[node] = CacheEntry(key, item);
+        entries_.push_front(list_, node);
+        cache_map_.emplace(key, node);
+
+        return false;
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    inline ssize_t finish() override { return hits_counter_; }
+
+    inline ssize_t get_hit_count()     const override { return hits_counter_; }
+    inline ssize_t get_request_count() const override { return requests_counter_; }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << hits_counter_ << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("LRU list cache DUMP", "capacity: ", capacity_, "\nhit count: ", hits_counter_,
+                                        "\nsize: ", list_.size);
+
+        int i = 0;
+        entries_.for_each(list_, [&](NodeIndex, const CacheEntry &entry)
+        {
+            LOG_DUMP("LRU", "[ node", i++, " key: ", entry.key, " item: ", entry.item, " ]");
+        });
+    }
+};
+
+#endif
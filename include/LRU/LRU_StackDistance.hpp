@@ -0,0 +1,161 @@
+#ifndef LRU_STACK_DISTANCE_HPP
+#define LRU_STACK_DISTANCE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+// LRU stack depth of every request in O(log N) each. Every key is marked
+// at the time of its last access in a Fenwick tree, so the amount of marks
+// after a key's previous access is the amount of distinct keys touched
+// since, and the request hits an LRU cache of capacity c iff its depth <= c.
+// Times of keys that were accessed again are dead; when the tree runs out of
+// times and at least half of them are dead, live times are renumbered 1..K,
+// so memory follows the amount of distinct keys rather than the trace length.
+template <typename key_t>
+class LRUStackDistance
+{
+public:
+    static constexpr std::size_t COLD = SIZE_MAX;
+
+private:
+    using time_t = std::size_t;
+
+    static constexpr std::size_t MIN_TREE_SIZE = 64;
+
+    std::vector<std::uint32_t> tree_;       // 1-based Fenwick tree over access times
+    time_t now_;
+
+    std::unordered_map<key_t, time_t> last_access_;
+
+    // histogram_[d] counts requests at stack depth d, index 0 is unused
+    std::vector<std::uint64_t> histogram_;
+    std::uint64_t cold_misses_;
+    std::uint64_t requests_;
+
+    void tree_add(time_t time, std::int32_t delta)
+    {
+        for (; time < tree_.size(); time += time & (~time + 1))
+            tree_[time] += delta;
+    }
+
+    std::uint64_t tree_prefix(time_t time) const
+    {
+        std::uint64_t sum = 0;
+        for (; time > 0; time -= time & (~time + 1))
+            sum += tree_[time];
+
+        return sum;
+    }
+
+    void rebuild(std::size_t size)
+    {
+        tree_.assign(size, 0);
+
+        // O(K) build: each node pushes its sum to its parent once
+        for (const auto &last : last_access_)
+            tree_[last.second] = 1;
+
+        for (time_t time = 1; time < tree_.size(); time++)
+        {
+            const time_t parent = time + (time & (~time + 1));
+            if (parent < tree_.size())
+                tree_[parent] += tree_[time];
+        }
+    }
+
+    // renumbers live times keeping their order; depths do not change
+    void compact()
+    {
+        std::vector<time_t> live;
+        live.reserve(last_access_.size());
+
+        for (const auto &last : last_access_)
+            live.push_back(last.second);
+
+        std::sort(live.begin(), live.end());
+
+        for (auto &last : last_access_)
+            last.second = static_cast<time_t>(std::lower_bound(live.begin(), live.end(), last.second) -
+                                              live.begin()) + 1;
+
+        now_ = live.size();
+    }
+
+    // out of times: compact when at least half of them are dead, grow otherwise
+    void make_room()
+    {
+        if (2 * last_access_.size() <= tree_.size())
+        {
+            compact();
+            rebuild(std::max<std::size_t>(2 * last_access_.size() + 2, MIN_TREE_SIZE));
+        }
+        else
+            rebuild(2 * tree_.size());
+    }
+
+public:
+    explicit LRUStackDistance(std::size_t expected_requests = 0)
+             : tree_(std::max<std::size_t>(expected_requests + 2, MIN_TREE_SIZE), 0), now_(0), last_access_(), histogram_(1, 0),
+               cold_misses_(0), requests_(0) {}
+
+    // returns the stack depth of the request, or COLD on the first access
+    std::size_t access(const key_t &key)
+    {
+        if (now_ + 1 >= tree_.size())
+            make_room();
+
+        ++now_;
+
+        requests_++;
+
+        auto [last_it, inserted] = last_access_.try_emplace(key, now_);
+        if (inserted)
+        {
+            tree_add(now_, 1);
+            cold_misses_++;
+            return COLD;
+        }
+
+        const time_t previous = last_it->second;
+        const std::size_t depth = static_cast<std::size_t>(tree_prefix(now_ - 1) - tree_prefix(previous)) + 1;
+
+        tree_add(previous, -1);
+        tree_add(now_, 1);
+        last_it->second = now_;
+
+        if (depth >= histogram_.size())
+            histogram_.resize(depth + 1, 0);
+        histogram_[depth]++;
+
+        return depth;
+    }
+
+    inline const std::vector<std::uint64_t> &histogram() const { return histogram_; }
+
+    // Fenwick and last-access bytes, the histogram aside
+    inline std::size_t memory_usage() const
+    {
+        return tree_.capacity() * sizeof(std::uint32_t) +
+               last_access_.size() * (sizeof(key_t) + sizeof(time_t) + 2 * sizeof(void *)) +
+               last_access_.bucket_count() * sizeof(void *);
+    }
+
+    inline std::uint64_t cold_misses() const { return cold_misses_; }
+    inline std::uint64_t requests()    const { return requests_; }
+    inline std::size_t   distinct()    const { return last_access_.size(); }
+
+    // hits of an LRU cache with the given capacity over everything seen so far
+    std::uint64_t hits(std::size_t capacity) const
+    {
+        std::uint64_t hits = 0;
+        for (std::size_t depth = 1; depth <= capacity && depth < histogram_.size(); depth++)
+            hits += histogram_[depth];
+
+        return hits;
+    }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef REQUEST_SPAN_HPP
+#define REQUEST_SPAN_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Non-owning view of a request stream. Keys and items are read through byte
+// strides, so the same view covers a vector of pairs and the separate key
+// and item columns of a mapped trace file without copying either. A view
+// without an item column hands out the key as the item, like the text
+// input does.
+template <typename key_t, typename item_t>
+class RequestSpan
+{
+public:
+    using request_t = std::pair<key_t, item_t>;
+
+private:
+    const unsigned char *keys_;
+    const unsigned char *items_;
+    std::size_t key_stride_;
+    std::size_t item_stride_;
+    std::size_t size_;
+
+    static inline item_t item_from_key(const key_t &key)
+    {
+        if constexpr (std::is_constructible<item_t, const key_t &>::value)
+            return item_t(key);
+        else
+            return item_t();
+    }
+
+public:
+    class Iterator
+    {
+    private:
+        const RequestSpan *span_;
+        std::size_t index_;
+
+    public:
+        Iterator(const RequestSpan *span, std::size_t index) : span_(span), index_(index) {}
+
+        inline request_t  operator*() const { return (*span_)[index_]; }
+        inline Iterator  &operator++()      { index_++; return *this; }
+
+        inline bool operator==(const Iterator &other) const { return index_ == other.index_; }
+        inline bool operator!=(const Iterator &other) const { return index_ != other.index_; }
+    };
+
+    RequestSpan() : keys_(nullptr), items_(nullptr), key_stride_(0), item_stride_(0), size_(0) {}
+
+    RequestSpan(const std::vector<request_t> &requests) : RequestSpan()
+    {
+        if (requests.empty()) return;
+
+        keys_        = reinterpret_cast<const unsigned char *>(&requests.front().first);
+        items_       = reinterpret_cast<const unsigned char *>(&requests.front().second);
+        key_stride_  = sizeof(request_t);
+        item_stride_ = sizeof(request_t);
+        size_        = requests.size();
+    }
+
+    RequestSpan(const key_t *keys, const item_t *items, std::size_t size)
+        : keys_(reinterpret_cast<const unsigned char *>(keys)),
+          items_(reinterpret_cast<const unsigned char *>(items)),
+          key_stride_(sizeof(key_t)), item_stride_(sizeof(item_t)), size_(size) {}
+
+    inline std::size_t size()  const { return size_; }
+    inline bool        empty() const { return size_ == 0; }
+
+    inline const key_t &key(std::size_t index) const
+    {
+        return *reinterpret_cast<const key_t *>(keys_ + index * key_stride_);
+    }
+
+    inline item_t item(std::size_t index) const
+    {
+        if (items_ == nullptr) return item_from_key(key(index));
+
+        return *reinterpret_cast<const item_t *>(items_ + index * item_stride_);
+    }
+
+    inline request_t operator[](std::size_t index) const { return {key(index), item(index)}; }
+
+    RequestSpan subspan(std::size_t offset, std::size_t count) const
+    {
+        RequestSpan sub(*this);
+        if (offset > size_) offset = size_;
+        if (count > size_ - offset) count = size_ - offset;
+
+        sub.keys_  = keys_ + offset * key_stride_;
+        sub.items_ = (items_ == nullptr) ? nullptr : items_ + offset * item_stride_;
+        sub.size_  = count;
+        return sub;
+    }
+
+    inline Iterator begin() const { return Iterator(this, 0); }
+    inline Iterator end()   const { return Iterator(this, size_); }
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef COUNT_MIN_SKETCH_HPP
+#define COUNT_MIN_SKETCH_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Frequency estimate with 4-bit saturating counters, sixteen to a word. Each
+// key has one counter in each of DEPTH rows and its estimate is the
+// smallest of them. After sample_size increments every counter is halved,
+// so old popularity fades (the TinyLFU reset).
+template <typename key_t>
+class CountMinSketch
+{
+private:
+    static constexpr std::size_t   DEPTH            = 4;
+    static constexpr std::size_t   COUNTERS_IN_WORD = 16;
+    static constexpr std::uint64_t COUNTER_MAX      = 15;
+    static constexpr std::uint64_t RESET_MASK       = 0x7777777777777777ULL;
+
+    std::vector<std::uint64_t> table_;
+    std::size_t   row_mask_;        // counters in a row - 1, a power of two
+    std::size_t   row_words_;
+    std::size_t   sample_size_;
+    std::size_t   additions_;
+
+    static inline std::uint64_t mix(const key_t &key)
+    {
+        std::uint64_t h = static_cast<std::uint64_t>(std::hash<key_t>()(key));
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ULL;
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ULL;
+        h ^= h >> 32;
+        return h;
+    }
+
+    // double hashing picks the counter of every row
+    inline std::size_t counter_index(std::uint64_t hash, std::size_t row) const
+    {
+        const std::uint64_t step = (hash >> 32) | 1;
+        return row * (row_mask_ + 1) + static_cast<std::size_t>((hash + row * step) & row_mask_);
+    }
+
+    inline std::uint64_t counter(std::size_t index) const
+    {
+        return (table_[index / COUNTERS_IN_WORD] >> (4 * (index % COUNTERS_IN_WORD))) & COUNTER_MAX;
+    }
+
+    void reset()
+    {
+        for (std::uint64_t &word : table_)
+            word = (word >> 1) & RESET_MASK;
+
+        additions_ /= 2;
+    }
+
+public:
+    // counters_per_row is rounded up to a power of two, at least one word
+    explicit CountMinSketch(std::size_t counters_per_row, std::size_t sample_size)
+             : table_(), row_mask_(0), row_words_(0), sample_size_(sample_size), additions_(0)
+    {
+        std::size_t counters = COUNTERS_IN_WORD;
+        while (counters < counters_per_row)
+            counters *= 2;
+
+        row_mask_  = counters - 1;
+        row_words_ = counters / COUNTERS_IN_WORD;
+        table_.assign(DEPTH * row_words_, 0);
+    }
+
+    void increment(const key_t &key)
+    {
+        const std::uint64_t hash = mix(key);
+        bool added = false;
+
+        for (std::size_t row = 0; row < DEPTH; row++)
+        {
+            const std::size_t index = counter_index(hash, row);
+            if (counter(index) < COUNTER_MAX)
+            {
+                table_[index / COUNTERS_IN_WORD] += 1ULL << (4 * (index % COUNTERS_IN_WORD));
+                added = true;
+            }
+        }
+
+        if (added && ++additions_ >= sample_size_)
+            reset();
+    }
+
+    std::uint64_t frequency(const key_t &key) const
+    {
+        const std::uint64_t hash = mix(key);
+        std::uint64_t estimate = COUNTER_MAX;
+
+        for (std::size_t row = 0; row < DEPTH; row++)
+        {
+            const std::uint64_t value = counter(counter_index(hash, row));
+            if (value < estimate) estimate = value;
+        }
+
+        return estimate;
+    }
+
+    inline std::size_t memory_usage() const { return table_.capacity() * sizeof(std::uint64_t); }
+};
+
+#endif
@@ -0,0 +1,232 @@
+#ifndef TINY_LFU_CACHE_HPP
+#define TINY_LFU_CACHE_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+#include "utils/log_config/log_config.hpp"
+#include "CacheInterface.hpp"
+#include "ARC/NodeSlab.hpp"
+#include "TinyLFU/CountMinSketch.hpp"
+
+// W-TinyLFU (Einziger, Friedman & Manes). New keys land in a small LRU
+// window; the key the window pushes out must beat the main cache's victim
+// on the count-min frequency estimate to be admitted. The main cache is a
+// segmented LRU: probation takes admitted keys, a second hit moves them to
+// protected, and protected overflow goes back to probation.
+template <typename key_t, typename item_t>
+class TinyLFUCache : public CacheInterface<key_t, item_t>
+{
+private:
+    static constexpr ssize_t STD_CAPACITY = 16;
+
+    static constexpr double WINDOW_RATIO    = 0.01;
+    static constexpr double PROTECTED_RATIO = 0.8;
+    static constexpr ssize_t SAMPLE_FACTOR  = 10;
+
+    enum class ListLocation
+    {
+        WINDOW,
+        PROBATION,
+        PROTECTED
+    };
+
+    struct CacheEntry
+    {
+        key_t key;
+        item_t item;
+        ListLocation location;
+
+        CacheEntry() : key(), item(), location(ListLocation::WINDOW) {}
+        CacheEntry(const key_t &k, const item_t &i, ListLocation l) : key(k), item(i), location(l) {}
+    };
+
+    using SlabType  = NodeSlab<CacheEntry>;
+    using ListType  = typename SlabType::IndexList;
+    using NodeIndex = typename SlabType::index_t;
+
+    ssize_t capacity_;
+    ssize_t window_capacity_;
+    ssize_t protected_capacity_;
+    ssize_t hits_counter_;
+    ssize_t requests_counter_;
+
+    SlabType entries_;
+
+    ListType list_window_;
+    ListType list_probation_;
+    ListType list_protected_;
+
+    std::unordered_map<key_t, NodeIndex> cache_map_;
+
+    CountMinSketch<key_t> sketch_;
+
+    inline ssize_t resident_size() const
+    {
+        return static_cast<ssize_t>(list_window_.size + list_probation_.size + list_protected_.size);
+    }
+
+    inline ListType &list_of(ListLocation location)
+    {
+        switch (location)
+        {
+            case ListLocation::WINDOW:    return list_window_;
+            case ListLocation::PROBATION: return list_probation_;
+            default:                      return list_protected_;
+        }
+    }
+
+    void move_entry(NodeIndex node, ListLocation dest)
+    {
+        entries_.move_to_front(list_of(entries_[node].location), list_of(dest), node);
+        entries_[node].location = dest;
+    }
+
+    void remove_entry(ListType &list, NodeIndex node)
+    {
+        entries_.unlink(list, node);
+        cache_map_.erase(entries_[node].key);
+        entries_.release(node);
+    }
+
+    void on_hit(NodeIndex node)
+    {
+        switch (entries_[node].location)
+        {
+            case ListLocation::WINDOW:
+                move_entry(node, ListLocation::WINDOW);
+                break;
+
+            case ListLocation::PROBATION:
+                move_entry(node, ListLocation::PROTECTED);
+                if (static_cast<ssize_t>(list_protected_.size) > protected_capacity_)
+                    move_entry(list_protected_.tail, ListLocation::PROBATION);
+                break;
+
+            case ListLocation::PROTECTED:
+                move_entry(node, ListLocation::PROTECTED);
+                break;
+        }
+    }
+
+    // the window went over its share: its LRU key either enters probation
+    // or is the one that leaves, whichever is estimated less popular
+    void evict_from_window()
+    {
+        const NodeIndex candidate = list_window_.tail;
+
+        if (resident_size() <= capacity_)
+        {
+            move_entry(candidate, ListLocation::PROBATION);
+            return;
+        }
+
+        ListType &victim_list = !list_probation_.empty() ? list_probation_ : list_protected_;
+        if (victim_list.empty())
+        {
+            remove_entry(list_window_, candidate);
+            return;
+        }
+
+        const NodeIndex victim = victim_list.tail;
+        if (sketch_.frequency(entries_[candidate].key) > sketch_.frequency(entries_[victim].key))
+        {
+            remove_entry(victim_list, victim);
+            move_entry(candidate, ListLocation::PROBATION);
+        }
+        else
+            remove_entry(list_window_, candidate);
+    }
+
+public:
+    explicit TinyLFUCache(ssize_t capacity = STD_CAPACITY)
+             : capacity_(capacity), window_capacity_(0), protected_capacity_(0), hits_counter_(0),
+               requests_counter_(0), entries_(), list_window_(), list_probation_(), list_protected_(),
+               cache_map_(),
+               sketch_(static_cast<std::size_t>(capacity > 0 ? capacity : STD_CAPACITY),
+                       static_cast<std::size_t>(SAMPLE_FACTOR * (capacity > 0 ? capacity : STD_CAPACITY)))
+    {
+        LOG_INFO("W-TinyLFU cache", "Cache initialized with capacity: ", capacity);
+
+        if (capacity <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Capacity is INVALID, set\n capacity = STD_CAPACITY = ", STD_CAPACITY);
+            capacity_ = STD_CAPACITY;
+        }
+
+        window_capacity_    = std::max<ssize_t>(1, static_cast<ssize_t>(capacity_ * WINDOW_RATIO));
+        protected_capacity_ = static_cast<ssize_t>((capacity_ - window_capacity_) * PROTECTED_RATIO);
+
+        entries_.reserve(capacity_ + 1);
+        cache_map_.reserve(capacity_ + 1);
+    }
+
+    item_t get_item(const key_t &key) const
+    {
+        auto cache_map_it = cache_map_.find(key);
+        if (cache_map_it == cache_map_.end()) return item_t();
+
+        return entries_[cache_map_it->second].item;
+    }
+
+    bool add_cache(const key_t &key, const item_t &item)
+    {
+        requests_counter_++;
+        sketch_.increment(key);
+
+        auto cache_map_it = cache_map_.find(key);
+        if (cache_map_it != cache_map_.end())
+        {
+            on_hit(cache_map_it->second);
+            hits_counter_++;
+            return true;
+        }
+
+        NodeIndex node = entries_.acquire();
+        entries_[node] = CacheEntry(key, item, ListLocation::WINDOW);
+        entries_.push_front(list_window_, node);
+        cache_map_.emplace(key, node);
+
+        if (static_cast<ssize_t>(list_window_.size) > window_capacity_)
+            evict_from_window();
+
+        return false;
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    inline ssize_t finish() override { return hits_counter_; }
+
+    inline ssize_t get_hit_count()     const override { return hits_counter_; }
+    inline ssize_t get_request_count() const override { return requests_counter_; }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << hits_counter_ << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("W-TinyLFU cache DUMP", "capacity: ", capacity_, "\nhit count: ", hits_counter_,
+                                         "\nwindow: ", list_window_.size, " of ", window_capacity_,
+                                         "\nprobation: ", list_probation_.size,
+                                         "\nprotected: ", list_protected_.size, " of ", protected_capacity_);
+    }
+};
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef TWO_Q_CACHE_HPP
+#define TWO_Q_CACHE_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+#include "utils/log_config/log_config.hpp"
+#include "CacheInterface.hpp"
+#include "ARC/NodeSlab.hpp"
+
+// Full 2Q (Johnson & Shasha): first-time keys enter the A1in FIFO, keys
+// evicted from it are remembered in the A1out ghost FIFO, and only a miss
+// on a remembered key gets into the Am LRU. A hit in A1in changes nothing,
+// so a burst of correlated references does not look like frequency.
+template <typename key_t, typename item_t>
+class TwoQCache : public CacheInterface<key_t, item_t>
+{
+private:
+    static constexpr ssize_t STD_CAPACITY = 16;
+
+    // sizes from the paper: A1in holds a quarter of the cache, A1out
+    // remembers half of its capacity worth of keys
+    static constexpr double IN_RATIO  = 0.25;
+    static constexpr double OUT_RATIO = 0.5;
+
+    enum class ListLocation
+    {
+        IN_LIST,
+        OUT_LIST,
+        MAIN_LIST
+    };
+
+    struct CacheEntry
+    {
+        key_t key;
+        item_t item;
+
+        CacheEntry() : key(), item() {}
+        CacheEntry(const key_t &k, const item_t &i) : key(k), item(i) {}
+    };
+
+    using SlabType      = NodeSlab<CacheEntry>;
+    using GhostSlabType = NodeSlab<key_t>;
+    using ListType      = typename SlabType::IndexList;
+    using GhostListType = typename GhostSlabType::IndexList;
+    using NodeIndex     = typename SlabType::index_t;
+
+    struct LocationInfo
+    {
+        ListLocation location;
+        NodeIndex node;
+    };
+
+    ssize_t capacity_;
+    ssize_t in_capacity_;
+    ssize_t out_capacity_;
+    ssize_t hits_counter_;
+    ssize_t requests_counter_;
+
+    SlabType      entries_;
+    GhostSlabType ghosts_;
+
+    ListType      list_in_;
+    ListType      list_main_;
+    GhostListType list_out_;
+
+    std::unordered_map<key_t, LocationInfo> cache_map_;
+
+    inline ssize_t resident_size() const
+    {
+        return static_cast<ssize_t>(list_in_.size + list_main_.size);
+    }
+
+    // frees one resident slot: A1in gives up its oldest key to A1out while
+    // it is over its share, otherwise Am drops its LRU key for good
+    void reclaim()
+    {
+        if (resident_size() < capacity_) return;
+
+        if (static_cast<ssize_t>(list_in_.size) > in_capacity_ || list_main_.empty())
+        {
+            NodeIndex tail = entries_.pop_back(list_in_);
+            const key_t key = entries_[tail].key;
+            entries_.release(tail);
+
+            if (static_cast<ssize_t>(list_out_.size) >= out_capacity_)
+            {
+                NodeIndex out_tail = ghosts_.pop_back(list_out_);
+                cache_map_.erase(ghosts_[out_tail]);
+                ghosts_.release(out_tail);
+            }
+
+            NodeIndex ghost = ghosts_.acquire();
+            ghosts_[ghost] = key;
+            ghosts_.push_front(list_out_, ghost);
+            cache_map_[key] = {ListLocation::OUT_LIST, ghost};
+        }
+        else
+        {
+            NodeIndex tail = entries_.pop_back(list_main_);
+            cache_map_.erase(entries_[tail].key);
+            entries_.release(tail);
+        }
+    }
+
+    NodeIndex push_entry(ListType &list, const key_t &key, const item_t &item)
+    {
+        NodeIndex node = entries_.acquire();
+        entries_[node] = CacheEntry(key, item);
+        entries_.push_front(list, node);
+        return node;
+    }
+
+public:
+    explicit TwoQCache(ssize_t capacity = STD_CAPACITY)
+             : capacity_(capacity), in_capacity_(0), out_capacity_(0), hits_counter_(0), requests_counter_(0),
+               entries_(), ghosts_(), list_in_(), list_main_(), list_out_(), cache_map_()
+    {
+        LOG_INFO("2Q cache", "Cache initialized with capacity: ", capacity);
+
+        if (capacity <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Capacity is INVALID, set\n capacity = STD_CAPACITY = ", STD_CAPACITY);
+            capacity_ = STD_CAPACITY;
+        }
+
+        in_capacity_  = std::max<ssize_t>(1, static_cast<ssize_t>(capacity_ * IN_RATIO));
+        out_capacity_ = std::max<ssize_t>(1, static_cast<ssize_t>(capacity_ * OUT_RATIO));
+
+        entries_.reserve(capacity_);
+        ghosts_.reserve(out_capacity_);
+        cache_map_.reserve(capacity_ + out_capacity_);
+    }
+
+    item_t get_item(const key_t &key) const
+    {
+        auto cache_map_it = cache_map_.find(key);
+        if (cache_map_it == cache_map_.end() || cache_map_it->second.location == ListLocation::OUT_LIST)
+            return item_t();
+
+        return entries_[cache_map_it->second.node].item;
+    }
+
+    bool add_cache(const key_t &key, const item_t &item)
+    {
+        requests_counter_++;
+
+        auto cache_map_it = cache_map_.find(key);
+        if (cache_map_it == cache_map_.end())
+        {
+            reclaim();
+            cache_map_.emplace(key, LocationInfo{ListLocation::IN_LIST, push_entry(list_in_, key, item)});
+            return false;
+        }
+
+        LocationInfo &info = cache_map_it->second;
+        switch (info.location)
+        {
+            case ListLocation::MAIN_LIST:
+                entries_.move_to_front(list_main_, list_main_, info.node);
+                hits_counter_++;
+                return true;
+
+            case ListLocation::IN_LIST:
+                hits_counter_++;
+                return true;
+
+            case ListLocation::OUT_LIST:
+            {
+                ghosts_.unlink(list_out_, info.node);
+                ghosts_.release(info.node);
+                cache_map_.erase(cache_map_it);
+
+                reclaim();
+                cache_map_[key] = {ListLocation::MAIN_LIST, push_entry(list_main_, key, item)};
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(RequestSpan<key_t, item_t> input_key_item) override
+    {
+        feed(input_key_item);
+        return finish();
+    }
+
+    void feed(RequestSpan<key_t, item_t> batch) override
+    {
+        for (std::size_t i = 0; i < batch.size(); i++)
+            add_cache(batch.key(i), batch.item(i));
+    }
+
+    inline ssize_t finish() override { return hits_counter_; }
+
+    inline ssize_t get_hit_count()     const override { return hits_counter_; }
+    inline ssize_t get_request_count() const override { return requests_counter_; }
+
+    inline void print_hit_count() const override
+    {
+        std::cout << "hits: " << hits_counter_ << std::endl;
+    }
+
+    void dump() const override
+    {
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        LOG_DUMP("2Q cache DUMP", "capacity: ", capacity_, "\nhit count: ", hits_counter_,
+                                  "\nA1in: ", list_in_.size, " of ", in_capacity_,
+                                  "\nAm: ", list_main_.size,
+                                  "\nA1out: ", list_out_.size, " of ", out_capacity_);
+    }
+};
+
+#endif
@@ -2,13 +2,16 @@
 #define OPTIMAL_CACHE_HPP
 
 #include <unordered_map>
+#include <algorithm>
 #include <deque>
+#include <list>
 #include <vector>
 #include <iostream>
 #include <cstdint>
+#include <limits>
 
 #include "../CacheInterface.hpp"
-#include "../utils/logger/logger.hpp"
+#include "../utils/log_config/log_config.hpp"
 
 template <typename key_t, typename item_t>
 struct OPT_cache : CacheInterface<key_t, item_t>
@@ -16,61 +19,239 @@ struct OPT_cache : CacheInterface<key_t, item_t>
 private:
     using index_t   = ssize_t;
     using request_t = typename std::pair<key_t, item_t>;
-    using IndexMapType = typename std::unordered_map<key_t, std::deque<index_t>>;
-    using CacheMapType = typename std::unordered_map<key_t, item_t>;
-    using input_vector = typename std::vector<request_t>;
-
-    static constexpr key_t POISON_KEY = static_cast<ssize_t>(0XEDAA);
-    static constexpr index_t INF_INDEX = UINT64_MAX;
+    using input_span = RequestSpan<key_t, item_t>;
 
+    static constexpr index_t INF_INDEX     = std::numeric_limits<index_t>::max();
+    static constexpr ssize_t STD_LOOKAHEAD = 1 << 20;
 
     ssize_t capacity_;
     ssize_t hits_counter_;
+    ssize_t requests_counter_;
+    ssize_t byte_hits_counter_;
+    ssize_t byte_requests_counter_;
+
+    // next_use_[i] is the position of the next request for the key of
+    // request i, or INF_INDEX
+    std::vector<index_t> next_use_;
+
+    // A cached key is represented by the position of its next request: that
+    // position is marked in pending_hit_ and pushed into a max-heap. Keys
+    // that are never requested again are not worth a slot and are dropped.
+    // A hit consumes its mark, so its old heap entry goes stale and is
+    // skipped lazily. pending_hit_ is a ring over positions, only the ones
+    // from position_ on can be pending.
+    std::vector<bool>    pending_hit_;
+    std::size_t          ring_mask_;
+    std::vector<index_t> heap_;
+    ssize_t              cached_amount_;
+    index_t              position_;
+
+    // size-aware replay only: the size a pending position was cached with
+    std::vector<ssize_t> pending_size_;
+
+    // Streaming mode sees at most lookahead_ requests ahead. A cached key
+    // whose next request is beyond the window is kept in unknown_order_
+    // (most recent first): it is evicted before any key with a known next
+    // request, and gets its pending position once that request arrives.
+    // With a window covering the whole trace this is exactly Belady.
+    struct WindowEntry
+    {
+        key_t   key;
+        index_t next;
+    };
+
+    ssize_t                 lookahead_;
+    bool                    streaming_;
+    std::deque<WindowEntry> window_;
+    index_t                 stream_end_;
 
-    IndexMapType map_future_;
-    CacheMapType cache_map_;
+    std::unordered_map<key_t, index_t> last_position_;
 
+    std::list<key_t> unknown_order_;
+    std::unordered_map<key_t, typename std::list<key_t>::iterator> unknown_map_;
 
 public:
-    explicit OPT_cache() : capacity_(0), hits_counter_(0) {}
-    explicit OPT_cache(ssize_t input_capacity) 
-             : capacity_(input_capacity), hits_counter_(0)
+    explicit OPT_cache() : capacity_(0), hits_counter_(0), requests_counter_(0),
+                           byte_hits_counter_(0), byte_requests_counter_(0), ring_mask_(0),
+                           cached_amount_(0), position_(0), lookahead_(STD_LOOKAHEAD),
+                           streaming_(false), stream_end_(0) {}
+
+    explicit OPT_cache(ssize_t input_capacity, ssize_t lookahead = STD_LOOKAHEAD) 
+             : capacity_(input_capacity), hits_counter_(0), requests_counter_(0),
+               byte_hits_counter_(0), byte_requests_counter_(0), ring_mask_(0),
+               cached_amount_(0), position_(0), lookahead_(lookahead),
+               streaming_(false), stream_end_(0)
     {
-        LOG_INFO("OPT_Cache", "Cache initialized with capacity: ", input_capacity);
+        LOG_INFO("OPT_Cache", "Cache initialized with capacity: ", input_capacity,
+                              "\nlook-ahead: ", lookahead);
+        if (lookahead <= 0)
+        {
+            LOG_WARNING("BAD INPUT", "Look-ahead is INVALID, set\n lookahead = STD_LOOKAHEAD = ", STD_LOOKAHEAD);
+            lookahead_ = STD_LOOKAHEAD;
+        }
     }
 
     ~OPT_cache()
     {}
 
-    ssize_t run_cache(const input_vector &key_items) override
+    using CacheInterface<key_t, item_t>::run_cache;
+
+    ssize_t run_cache(input_span key_items) override
+    {
+        if (capacity_ <= 0LL) 
+        {
+            LOG_ERROR("OPT cache", "capacity is INVALID. WE STOP IT");
+            return 0;
+        }
+        build_next_use(key_items, next_use_, static_cast<std::size_t>(capacity_));
+        return simulate(next_use_);
+    }
+
+    // replay over a next-use table made by build_next_use(); the table
+    // depends on the trace only, so runs at many capacities can share one
+    ssize_t run_cache(const std::vector<ssize_t> &next_use)
+    {
+        if (capacity_ <= 0LL) 
+        {
+            LOG_ERROR("OPT cache", "capacity is INVALID. WE STOP IT");
+            return 0;
+        }
+
+        return simulate(next_use);
+    }
+
+    // Size-aware baseline: capacity_ is in cost units and every request
+    // costs cost(key, item). On a miss the cached keys requested farther
+    // in the future than the incoming one are evicted, farthest first, but
+    // only when together they free enough room; otherwise the incoming key
+    // is not admitted. This is Belady's rule with sizes, the usual offline
+    // reference for byte hit ratios (not the NP-hard true optimum).
+    template <typename cost_t>
+    ssize_t run_cache_weighted(input_span key_items, cost_t cost)
     {
         if (capacity_ <= 0LL) 
         {
             LOG_ERROR("OPT cache", "capacity is INVALID. WE STOP IT");
             return 0;
         }
-        load_map_of_future(key_items);
 
-        //todo: impl add_cache() and add to cache interface
-        for (ssize_t i = 0; i < key_items.size(); i++)
+        build_next_use(key_items, next_use_);
+        reset_pending(next_use_.size());
+        pending_size_.assign(pending_hit_.size(), 0);
+
+        ssize_t used_bytes = 0;
+        std::vector<index_t> victims;
+
+        for (index_t i = 0; i < static_cast<index_t>(next_use_.size()); i++)
         {
-            const auto &[curr_key, curr_item] = key_items[i];
+            const index_t next = next_use_[i];
+            const ssize_t size = std::max<ssize_t>(1, cost(key_items.key(i), key_items.item(i)));
+            position_ = i;
 
-            if (!map_future_[curr_key].empty())
-                map_future_[curr_key].pop_front();
+            byte_requests_counter_ += size;
 
-            if (cache_map_.find(curr_key) != cache_map_.end())
+            if (pending_hit_[i])
+            {
                 hits_counter_++;
+                byte_hits_counter_ += pending_size_[i];
+                pending_hit_[i] = false;
+                used_bytes -= pending_size_[i];
+                cached_amount_--;
+            }
 
-            else if (cache_map_.size() < capacity_)
-                cache_map_[curr_key] = curr_item;
+            if (next == INF_INDEX || size > capacity_)
+                continue;
 
-            else
+            victims.clear();
+            ssize_t freed_bytes = 0;
+
+            while (used_bytes - freed_bytes + size > capacity_)
+            {
+                while (!heap_.empty() && is_stale(heap_.front()))
+                {
+                    std::pop_heap(heap_.begin(), heap_.end());
+                    heap_.pop_back();
+                }
+
+                if (heap_.empty() || heap_.front() <= next)
+                    break;
+
+                victims.push_back(heap_.front());
+                freed_bytes += pending_size_[slot(heap_.front())];
+
+                std::pop_heap(heap_.begin(), heap_.end());
+                heap_.pop_back();
+            }
+
+            if (used_bytes - freed_bytes + size > capacity_)
+            {
+                for (index_t victim : victims)
+                {
+                    heap_.push_back(victim);
+                    std::push_heap(heap_.begin(), heap_.end());
+                }
+                continue;
+            }
+
+            for (index_t victim : victims)
+                pending_hit_[slot(victim)] = false;
+
+            used_bytes += size - freed_bytes;
+            cached_amount_ += 1 - static_cast<ssize_t>(victims.size());
+            pending_size_[slot(next)] = size;
+            push_pending(next);
+        }
+
+        requests_counter_ += static_cast<ssize_t>(next_use_.size());
+        return hits_counter_;
+    }
+
+    // one backward pass; the hash map of last positions lives only here
+    static void build_next_use(const input_span &key_items, std::vector<ssize_t> &next_use,
+                               std::size_t distinct_hint = 0)
+    {
+        std::unordered_map<key_t, index_t> next_position;
+        next_position.reserve(distinct_hint);
+
+        next_use.assign(key_items.size(), INF_INDEX);
+
+        for (index_t i = static_cast<index_t>(key_items.size()) - 1; i >= 0; i--)
+        {
+            auto [position_it, inserted] = next_position.try_emplace(key_items.key(i), i);
+            if (!inserted)
             {
-                bool should_be_replace = remove_farest(curr_key);
-                if (should_be_replace) cache_map_[curr_key] = curr_item;
+                next_use[i] = position_it->second;
+                position_it->second = i;
             }
         }
+    }
+
+    // decisions lag the input by up to lookahead_ requests: get_request_count()
+    // tells how many of the fed ones are already decided
+    void feed(input_span batch) override
+    {
+        if (capacity_ <= 0LL) 
+        {
+            LOG_ERROR("OPT cache", "capacity is INVALID. WE STOP IT");
+            return;
+        }
+
+        if (!streaming_)
+            begin_stream();
+
+        for (std::size_t i = 0; i < batch.size(); i++)
+            push_window(batch.key(i));
+    }
+
+    ssize_t finish() override
+    {
+        while (!window_.empty())
+            process_window_front();
+
+        last_position_.clear();
+        unknown_order_.clear();
+        unknown_map_.clear();
+        streaming_ = false;
 
         return hits_counter_;
     }
@@ -85,60 +266,225 @@ public:
         return hits_counter_;
     }
 
+    inline ssize_t get_request_count() const override
+    {
+        return requests_counter_;
+    }
+
+    inline ssize_t get_byte_hit_count() const
+    {
+        return byte_hits_counter_;
+    }
+
+    inline ssize_t get_byte_request_count() const
+    {
+        return byte_requests_counter_;
+    }
+
     inline void print_hit_count() const override
     {
         std::cout << "hits: " << hits_counter_ << std::endl;
     }
 
 private:
-    bool remove_farest(const key_t &insert_key)
-    {
-        index_t farthest_next_index = 0;
-        key_t   farthest_key  = POISON_KEY;
-        const index_t next_insert_index = (map_future_[insert_key].empty()) ?  
-                                           INF_INDEX : map_future_[insert_key].front();
-        
-        for (const auto &[key_in_cache, item] : cache_map_)
+    inline std::size_t slot(index_t position) const
+    {
+        return static_cast<std::size_t>(position) & ring_mask_;
+    }
+
+    inline bool is_stale(index_t pending) const
+    {
+        return pending < position_ || !pending_hit_[slot(pending)];
+    }
+
+    void reset_pending(std::size_t positions)
+    {
+        std::size_t ring_size = 1;
+        while (ring_size < positions)
+            ring_size *= 2;
+
+        pending_hit_.assign(ring_size, false);
+        ring_mask_ = ring_size - 1;
+
+        // no more entries than positions can be pending, whatever the
+        // capacity is counted in (bytes, for run_cache_weighted)
+        heap_.clear();
+        heap_.reserve(std::min<std::size_t>(positions, 2 * static_cast<std::size_t>(capacity_) + 1));
+        cached_amount_ = 0;
+        position_      = 0;
+    }
+
+    void push_pending(index_t next_use)
+    {
+        pending_hit_[slot(next_use)] = true;
+
+        heap_.push_back(next_use);
+        std::push_heap(heap_.begin(), heap_.end());
+
+        // hits leave stale entries behind; rebuild once they outnumber the
+        // cached keys so the heap stays O(cached keys)
+        if (static_cast<ssize_t>(heap_.size()) > 2 * cached_amount_ + 1)
         {
-            if (map_future_[key_in_cache].empty())
-            {
-                farthest_key = key_in_cache;
-                break;
-            }
-            else 
-            {
-                index_t next_index = map_future_[key_in_cache].front();
-                if (next_index > farthest_next_index)
-                {
-                        farthest_next_index = next_index;
-                        farthest_key        = key_in_cache;
-                }
-            }
+            heap_.erase(std::remove_if(heap_.begin(), heap_.end(),
+                        [this](index_t pending) { return is_stale(pending); }), heap_.end());
+            std::make_heap(heap_.begin(), heap_.end());
         }
-        if (farthest_next_index > next_insert_index && farthest_key != POISON_KEY)
+    }
+
+    bool remove_farest(index_t next_insert_index)
+    {
+        while (!heap_.empty() && is_stale(heap_.front()))
         {
-            cache_map_.erase(farthest_key);
-            return true;
+            std::pop_heap(heap_.begin(), heap_.end());
+            heap_.pop_back();
         }
-        else 
+
+        if (heap_.empty() || heap_.front() <= next_insert_index)
             return false;
+
+        pending_hit_[slot(heap_.front())] = false;
+        std::pop_heap(heap_.begin(), heap_.end());
+        heap_.pop_back();
+
+        push_pending(next_insert_index);
+        return true;
     }
 
     inline void cache_map_dump() const
     {
-        for (const auto &pair : cache_map_)
+        if constexpr (!LOG_ENABLED<LogLevel::DUMP>) return;
+
+        for (index_t pending : heap_)
+            if (!is_stale(pending))
+                std::cout << "cached until request: " << pending << std::endl;
+    }
+
+    void begin_stream()
+    {
+        // pending positions never run more than lookahead_ + 1 past position_
+        reset_pending(static_cast<std::size_t>(lookahead_) + 2);
+
+        window_.clear();
+        stream_end_ = 0;
+        streaming_  = true;
+    }
+
+    void push_window(const key_t &key)
+    {
+        const index_t position = stream_end_++;
+
+        auto [last_it, inserted] = last_position_.try_emplace(key, position);
+        if (!inserted)
+        {
+            window_[last_it->second - position_].next = position;
+            last_it->second = position;
+        }
+        else
+        {
+            // a cached key waiting beyond the window: its next request is here
+            auto unknown_it = unknown_map_.find(key);
+            if (unknown_it != unknown_map_.end())
+            {
+                unknown_order_.erase(unknown_it->second);
+                unknown_map_.erase(unknown_it);
+                push_pending(position);
+            }
+        }
+
+        window_.push_back({key, INF_INDEX});
+
+        if (static_cast<ssize_t>(window_.size()) > lookahead_)
+            process_window_front();
+    }
+
+    void process_window_front()
+    {
+        const WindowEntry entry = window_.front();
+        window_.pop_front();
+
+        auto last_it = last_position_.find(entry.key);
+        if (last_it != last_position_.end() && last_it->second == position_)
+            last_position_.erase(last_it);
+
+        const bool known = entry.next != INF_INDEX;
+
+        if (pending_hit_[slot(position_)])
+        {
+            hits_counter_++;
+            pending_hit_[slot(position_)] = false;
+
+            if (known) push_pending(entry.next);
+            else       push_unknown(entry.key);
+        }
+
+        else if (cached_amount_ < capacity_)
+        {
+            cached_amount_++;
+
+            if (known) push_pending(entry.next);
+            else       push_unknown(entry.key);
+        }
+
+        else if (!unknown_order_.empty())
         {
-            key_t key_in_cache = pair.first;
-            item_t item_in_cache = pair.second;
+            evict_unknown();
 
-            std::cout << "key: " << key_in_cache << " item: " << item_in_cache << std::endl;
+            if (known) push_pending(entry.next);
+            else       push_unknown(entry.key);
         }
+
+        else if (known)
+            remove_farest(entry.next);
+
+        position_++;
+        requests_counter_++;
+    }
+
+    void push_unknown(const key_t &key)
+    {
+        unknown_order_.push_front(key);
+        unknown_map_[key] = unknown_order_.begin();
     }
 
-    void load_map_of_future(const input_vector &key_items)
+    void evict_unknown()
     {
-        for (index_t i = 0; i < key_items.size(); i++)
-            map_future_[key_items[i].first].push_back(i + 1);        
+        unknown_map_.erase(unknown_order_.back());
+        unknown_order_.pop_back();
+    }
+
+    ssize_t simulate(const std::vector<index_t> &next_use)
+    {
+        reset_pending(next_use.size());
+
+        for (index_t i = 0; i < static_cast<index_t>(next_use.size()); i++)
+        {
+            const index_t next = next_use[i];
+            position_ = i;
+
+            if (pending_hit_[i])
+            {
+                hits_counter_++;
+                pending_hit_[i] = false;
+
+                if (next == INF_INDEX) cached_amount_--;
+                else                   push_pending(next);
+            }
+
+            else if (next == INF_INDEX)
+                continue;
+
+            else if (cached_amount_ < capacity_)
+            {
+                cached_amount_++;
+                push_pending(next);
+            }
+
+            else
+                remove_farest(next);
+        }
+
+        requests_counter_ += static_cast<ssize_t>(next_use.size());
+        return hits_counter_;
     }
 };
 
@@ -0,0 +1,64 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// Blocking FIFO with a fixed depth: push() waits while the queue is full,
+// pop() waits while it is empty. After close() pushes are refused and pop()
+// drains what is left, then returns false.
+template <typename value_t>
+class BoundedQueue
+{
+private:
+    std::deque<value_t>     queue_;
+    std::size_t             depth_;
+    bool                    closed_;
+    std::mutex              mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+
+public:
+    explicit BoundedQueue(std::size_t depth) : queue_(), depth_(depth ? depth : 1), closed_(false) {}
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    bool push(value_t value)
+    {
+        std::unique_lock<std::mutex> guard(mutex_);
+        not_full_.wait(guard, [this]() { return closed_ || queue_.size() < depth_; });
+
+        if (closed_) return false;
+
+        queue_.push_back(std::move(value));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    bool pop(value_t &value)
+    {
+        std::unique_lock<std::mutex> guard(mutex_);
+        not_empty_.wait(guard, [this]() { return closed_ || !queue_.empty(); });
+
+        if (queue_.empty()) return false;
+
+        value = std::move(queue_.front());
+        queue_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        closed_ = true;
+
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+};
+
+#endif
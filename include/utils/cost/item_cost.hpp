@@ -0,0 +1,26 @@
+#ifndef ITEM_COST_HPP
+#define ITEM_COST_HPP
+
+#include <sys/types.h>
+
+// Cost functors for the size-aware caches: cost(key, item) is the amount of
+// capacity an entry takes. UnitCost turns a byte capacity back into an
+// entry count; ItemSizeCost reads the size from the item, which is how
+// traces with a size column (--bytes input, binary traces with items) are
+// replayed.
+template <typename key_t, typename item_t>
+struct UnitCost
+{
+    inline ssize_t operator()(const key_t &, const item_t &) const { return 1; }
+};
+
+template <typename key_t, typename item_t>
+struct ItemSizeCost
+{
+    inline ssize_t operator()(const key_t &, const item_t &item) const
+    {
+        return static_cast<ssize_t>(item);
+    }
+};
+
+#endif
@@ -1,47 +1,472 @@
 #ifndef DRIVER_HPP
 #define DRIVER_HPP
 
+#include <atomic>
 #include <iostream>
 #include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <string>
 
-#include "../logger/logger.hpp"
+#include "../log_config/log_config.hpp"
 #include "../../CacheInterface.hpp"
+#include "../../RequestSpan.hpp"
+#include "../trace/binary_trace.hpp"
+#include "../bounded_queue/bounded_queue.hpp"
+#include "../thread_pool/thread_pool.hpp"
+#include "../sampling/spatial_sampler.hpp"
+#include "../../LRU/LRU_StackDistance.hpp"
+#include "../../ARC/ARC_Stats.hpp"
 
 template <typename key_t, typename item_t>
 class CacheDriver
 {
 private:
-    static constexpr ssize_t STD_VECTOR_CAPACITY = 16;
+    static constexpr ssize_t     STD_VECTOR_CAPACITY = 16;
+    static constexpr ssize_t     STD_BATCH_SIZE      = 1 << 16;
+    static constexpr std::size_t STREAM_QUEUE_DEPTH  = 4;
+    static constexpr double      STD_SAMPLING_RATE   = 0.01;
 
-    using request_t = typename std::pair<key_t, item_t>;
+    using request_t    = typename std::pair<key_t, item_t>;
+    using request_span = RequestSpan<key_t, item_t>;
     std::vector<request_t> requests;
+    MappedTrace<key_t, item_t> trace;
 
 public:
+    // a named policy for capacity sweeps: builds its cache with the given
+    // capacity, replays the trace and returns the hits
+    using sweep_policy_t = std::pair<std::string, std::function<ssize_t(request_span, ssize_t)>>;
+
     CacheDriver() { }
     ~CacheDriver() { }
 
     const std::vector<request_t> &generate_requests(ssize_t amount_numbers)
     {
         handle_vector_size(requests, amount_numbers);
+
+        // the async log writer is a second thread, see run_cache_streaming()
+        flockfile(stdin);
          for (ssize_t i = 0; i < requests.size(); i++)
          {
             ssize_t key = 0;
             std::cin >> key;
             requests[i] = {key, key};
          }
+        funlockfile(stdin);
+
+        return requests;
+    }
+
+    // "key size" pairs: the size becomes the item, for ItemSizeCost
+    const std::vector<request_t> &generate_sized_requests(ssize_t amount_numbers)
+    {
+        handle_vector_size(requests, amount_numbers);
+
+        flockfile(stdin);
+        for (std::size_t i = 0; i < requests.size(); i++)
+        {
+            key_t  key  = 0;
+            item_t size = 0;
+            std::cin >> key >> size;
+            requests[i] = {key, size};
+        }
+        funlockfile(stdin);
 
         return requests;
     }
 
-    void run_cache(CacheInterface<key_t, item_t> &cache, std::vector<request_t> requests)
+    // maps a binary trace instead of parsing text; the returned view stays
+    // valid for the lifetime of the driver
+    request_span map_trace(const std::string &path)
+    {
+        if (!trace.open(path))
+            return request_span();
+
+        return trace.requests();
+    }
+
+    inline ssize_t trace_capacity() const { return static_cast<ssize_t>(trace.capacity()); }
+
+    void run_cache(CacheInterface<key_t, item_t> &cache, request_span requests)
     {
         cache.run_cache(requests);
         cache.print_hit_count();
     }
 
+    // parses the text trace on a reader thread while this thread feeds the
+    // parsed batches to the cache, so the trace is never held in memory whole
+    void run_cache_streaming(CacheInterface<key_t, item_t> &cache, ssize_t amount_numbers,
+                             ssize_t batch_size = STD_BATCH_SIZE)
+    {
+        if (amount_numbers <= 0)
+        {
+            LOG_WARNING("Cache driver", "INVALID INPUT SIZE(or zero): ", amount_numbers, " NOTHING TO STREAM");
+            return;
+        }
+
+        if (batch_size <= 0)
+        {
+            LOG_WARNING("Cache driver", "INVALID BATCH SIZE: ", batch_size, " SET ", STD_BATCH_SIZE);
+            batch_size = STD_BATCH_SIZE;
+        }
+
+        BoundedQueue<std::vector<request_t>> batches(STREAM_QUEUE_DEPTH);
+
+        std::thread reader([&batches, amount_numbers, batch_size]()
+        {
+            // cin goes through stdio, which locks on every character once a
+            // second thread exists; holding the lock for the whole read makes
+            // each of those a cheap recursive acquire
+            flockfile(stdin);
+
+            for (ssize_t read = 0; read < amount_numbers; )
+            {
+                std::vector<request_t> batch;
+                batch.reserve(static_cast<std::size_t>(std::min(batch_size, amount_numbers - read)));
+
+                ssize_t key = 0;
+                while (static_cast<ssize_t>(batch.size()) < batch_size && read < amount_numbers && std::cin >> key)
+                {
+                    batch.emplace_back(key, key);
+                    read++;
+                }
+
+                if (batch.empty())
+                {
+                    LOG_WARNING("Cache driver", "INPUT ENDED AFTER ", read, " OF ", amount_numbers, " REQUESTS");
+                    break;
+                }
+
+                if (!batches.push(std::move(batch)))
+                    break;
+            }
+
+            funlockfile(stdin);
+            batches.close();
+        });
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<request_t> batch;
+        while (batches.pop(batch))
+            cache.feed(request_span(batch));
+
+        cache.finish();
+        reader.join();
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        cache.print_hit_count();
+        std::cout << "requests: " << cache.get_request_count() << ", misses: " << cache.get_miss_count()
+                  << ", time: " << elapsed.count() * 1e3 << " ms" << std::endl;
+    }
+
+    // replays one loaded trace at every capacity for every policy, each pair
+    // as its own task on a thread pool, and writes hit ratio vs capacity as CSV
+    void run_capacity_sweep(request_span requests, const std::vector<ssize_t> &capacities,
+                            const std::vector<sweep_policy_t> &policies, ssize_t threads_amount,
+                            std::ostream &csv = std::cout)
+    {
+        if (requests.empty() || capacities.empty() || policies.empty())
+        {
+            LOG_WARNING("Cache driver", "NOTHING TO SWEEP, requests: ", requests.size(),
+                                        " capacities: ", capacities.size(), " policies: ", policies.size());
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::future<ssize_t>> results;
+        results.reserve(capacities.size() * policies.size());
+        {
+            ThreadPool pool(threads_amount > 0 ? static_cast<std::size_t>(threads_amount) : 0);
+
+            for (ssize_t capacity : capacities)
+                for (const auto &policy : policies)
+                    results.push_back(pool.submit([&policy, requests, capacity]()
+                    {
+                        return policy.second(requests, capacity);
+                    }));
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        LOG_INFO("Cache driver", "sweep of ", results.size(), " runs took ", elapsed.count() * 1e3, " ms");
+
+        const double total = static_cast<double>(requests.size());
+
+        csv << "capacity";
+        for (const auto &policy : policies)
+            csv << ',' << policy.first;
+        csv << '\n' << std::fixed << std::setprecision(6);
+
+        for (std::size_t row = 0; row < capacities.size(); row++)
+        {
+            csv << capacities[row];
+            for (std::size_t column = 0; column < policies.size(); column++)
+                csv << ',' << static_cast<double>(results[row * policies.size() + column].get()) / total;
+            csv << '\n';
+        }
+
+        csv << std::defaultfloat << std::flush;
+    }
+
+    // SHARDS approximation of the same sweep: every policy replays only the
+    // keys picked by a SpatialSampler, with capacities scaled by the sampling
+    // rate, and an LRU stack-distance pass over the sample gives the LRU
+    // curve. With exact set the full replays run as well and every
+    // approximate column gets its absolute error next to it.
+    void run_sampled_sweep(request_span requests, const std::vector<ssize_t> &capacities,
+                           const std::vector<sweep_policy_t> &policies, double rate, bool exact,
+                           ssize_t threads_amount, std::ostream &csv = std::cout)
+    {
+        if (requests.empty() || capacities.empty())
+        {
+            LOG_WARNING("Cache driver", "NOTHING TO SWEEP, requests: ", requests.size(),
+                                        " capacities: ", capacities.size());
+            return;
+        }
+
+        if (rate <= 0.0 || rate > 1.0)
+        {
+            LOG_WARNING("Cache driver", "INVALID SAMPLING RATE: ", rate, " SET ", STD_SAMPLING_RATE);
+            rate = STD_SAMPLING_RATE;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        const SpatialSampler<key_t> sampler(rate);
+        const std::vector<request_t> sampled_requests = sampler.sample(requests);
+        const request_span sample(sampled_requests);
+
+        // SHARDS-adj: the sample rarely holds exactly rate * N requests; the
+        // surplus or shortfall is credited to the hits, which is where
+        // the sampling noise of the hottest keys ends up
+        const double expected   = static_cast<double>(requests.size()) * sampler.rate();
+        const double adjustment = expected - static_cast<double>(sampled_requests.size());
+
+        auto sampled_ratio = [expected, adjustment](double hits)
+        {
+            return std::min(1.0, std::max(0.0, (hits + adjustment) / expected));
+        };
+
+        std::vector<std::future<ssize_t>> sampled_hits;
+        std::vector<std::future<ssize_t>> exact_hits;
+
+        std::future<LRUStackDistance<key_t>> sampled_lru;
+        std::future<LRUStackDistance<key_t>> exact_lru;
+
+        auto stack_distance = [](request_span trace)
+        {
+            LRUStackDistance<key_t> distances(trace.size());
+            for (std::size_t i = 0; i < trace.size(); i++)
+                distances.access(trace.key(i));
+
+            return distances;
+        };
+
+        {
+            ThreadPool pool(threads_amount > 0 ? static_cast<std::size_t>(threads_amount) : 0);
+
+            sampled_lru = pool.submit([&stack_distance, sample]() { return stack_distance(sample); });
+            if (exact)
+                exact_lru = pool.submit([&stack_distance, requests]() { return stack_distance(requests); });
+
+            for (ssize_t capacity : capacities)
+                for (const auto &policy : policies)
+                {
+                    const ssize_t scaled = sampler.scale_capacity(capacity);
+                    sampled_hits.push_back(pool.submit([&policy, sample, scaled]()
+                    {
+                        return policy.second(sample, scaled);
+                    }));
+
+                    if (exact)
+                        exact_hits.push_back(pool.submit([&policy, requests, capacity]()
+                        {
+                            return policy.second(requests, capacity);
+                        }));
+                }
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        LOG_INFO("Cache driver", "sampled sweep, rate ", sampler.rate(), ", sampled requests ",
+                                 sampled_requests.size(), " of ", requests.size(),
+                                 ", took ", elapsed.count() * 1e3, " ms");
+
+        const double total = static_cast<double>(requests.size());
+
+        const LRUStackDistance<key_t> lru_sample = sampled_lru.get();
+        LRUStackDistance<key_t> lru_full;
+        if (exact) lru_full = exact_lru.get();
+
+        std::vector<std::string> names;
+        for (const auto &policy : policies)
+            names.push_back(policy.first);
+        names.push_back("LRU");
+
+        csv << "capacity";
+        for (const auto &name : names)
+        {
+            csv << ',' << name << "_sampled";
+            if (exact) csv << ',' << name << "_exact," << name << "_error";
+        }
+        csv << '\n' << std::fixed << std::setprecision(6);
+
+        std::vector<double> error_sum(names.size(), 0.0);
+        std::vector<double> error_max(names.size(), 0.0);
+
+        for (std::size_t row = 0; row < capacities.size(); row++)
+        {
+            csv << capacities[row];
+            for (std::size_t column = 0; column < names.size(); column++)
+            {
+                double approximate = 0.0;
+                double precise     = 0.0;
+
+                if (column < policies.size())
+                {
+                    const std::size_t run = row * policies.size() + column;
+                    approximate = sampled_ratio(static_cast<double>(sampled_hits[run].get()));
+                    if (exact) precise = static_cast<double>(exact_hits[run].get()) / total;
+                }
+                else
+                {
+                    const std::size_t scaled = static_cast<std::size_t>(sampler.scale_capacity(capacities[row]));
+                    approximate = sampled_ratio(static_cast<double>(lru_sample.hits(scaled)));
+                    if (exact) precise = static_cast<double>(lru_full.hits(capacities[row])) / total;
+                }
+
+                csv << ',' << approximate;
+                if (exact)
+                {
+                    const double error = std::fabs(approximate - precise);
+                    error_sum[column] += error;
+                    error_max[column]  = std::max(error_max[column], error);
+
+                    csv << ',' << precise << ',' << error;
+                }
+            }
+            csv << '\n';
+        }
+
+        if (exact)
+            for (std::size_t column = 0; column < names.size(); column++)
+                csv << "# " << names[column] << " mean absolute error: "
+                    << error_sum[column] / static_cast<double>(capacities.size())
+                    << ", max absolute error: " << error_max[column] << '\n';
+
+        csv << std::defaultfloat << std::flush;
+    }
+
+    // replays the trace from several threads at once; thread t takes every
+    // threads_amount-th request starting at t, so all of them move through
+    // the trace at roughly the same pace
+    template <typename concurrent_cache_t>
+    void run_cache_parallel(concurrent_cache_t &cache, request_span requests, ssize_t threads_amount)
+    {
+        if (threads_amount <= 0)
+        {
+            LOG_WARNING("Cache driver", "INVALID THREADS AMOUNT: ", threads_amount, " RUN ON ONE THREAD");
+            threads_amount = 1;
+        }
+
+        const std::size_t stride = static_cast<std::size_t>(threads_amount);
+        std::vector<std::thread> workers;
+        workers.reserve(stride);
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (std::size_t t = 0; t < stride; t++)
+            workers.emplace_back([&cache, &requests, stride, t]()
+            {
+                for (std::size_t i = t; i < requests.size(); i += stride)
+                    cache.add_cache(requests.key(i), requests.item(i));
+            });
+
+        for (auto &worker : workers)
+            worker.join();
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        cache.print_hit_count();
+        std::cout << "threads: " << threads_amount << ", time: " << elapsed.count() * 1e3 << " ms, "
+                  << static_cast<double>(requests.size()) / elapsed.count() / 1e6 << " Mops/s" << std::endl;
+    }
+
+    // read-through replay with the same striding as run_cache_parallel:
+    // every request goes through get_or_load, and a load stands for a trip
+    // to the backing store that takes load_time. Reports how many loads ran
+    // and how many requests joined one already in flight
+    template <typename concurrent_cache_t>
+    void run_read_through(concurrent_cache_t &cache, request_span requests, ssize_t threads_amount,
+                          std::chrono::microseconds load_time)
+    {
+        if (threads_amount <= 0)
+        {
+            LOG_WARNING("Cache driver", "INVALID THREADS AMOUNT: ", threads_amount, " RUN ON ONE THREAD");
+            threads_amount = 1;
+        }
+
+        const std::size_t stride = static_cast<std::size_t>(threads_amount);
+        std::atomic<ssize_t> loads(0);
+
+        auto loader = [&loads, load_time](const key_t &key)
+        {
+            loads.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::sleep_for(load_time);
+            return item_t(key);
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(stride);
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (std::size_t t = 0; t < stride; t++)
+            workers.emplace_back([&cache, &requests, &loader, stride, t]()
+            {
+                for (std::size_t i = t; i < requests.size(); i += stride)
+                    cache.get_or_load(requests.key(i), loader);
+            });
+
+        for (auto &worker : workers)
+            worker.join();
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        cache.print_hit_count();
+        std::cout << "loads: " << loads.load() << ", coalesced: " << cache.get_coalesced_count()
+                  << ", threads: " << threads_amount << ", time: " << elapsed.count() * 1e3 << " ms" << std::endl;
+    }
+
+    // replays the trace on the reference cache and reports how far the hit
+    // ratio already collected by the other cache is from it
+    void compare_hit_ratio(CacheInterface<key_t, item_t> &reference,
+                           const CacheInterface<key_t, item_t> &cache,
+                           request_span requests)
+    {
+        if (requests.empty()) return;
+
+        reference.run_cache(requests);
+
+        const double total          = static_cast<double>(requests.size());
+        const double reference_rate = static_cast<double>(reference.get_hit_count()) / total;
+        const double cache_rate     = static_cast<double>(cache.get_hit_count()) / total;
+
+        std::cout << "reference hit ratio: " << reference_rate
+                  << ", hit ratio: " << cache_rate
+                  << ", difference: " << cache_rate - reference_rate << std::endl;
+    }
+
     void compare_caches(CacheInterface<key_t, item_t> &cache1, 
                         CacheInterface<key_t, item_t> &cache2,
-                        std::vector<request_t> requests       )
+                        request_span requests                 )
     {
         std::cout << "=== Comparing Caches ===\n";
         
@@ -52,7 +477,137 @@ public:
         run_cache(cache2, requests);
     }
 
+    // every cache replays the same trace in turn; reports hit ratio and the
+    // mean time per request
+    void compare_caches(const std::vector<std::pair<std::string, CacheInterface<key_t, item_t> *>> &caches,
+                        request_span requests)
+    {
+        if (requests.empty()) return;
+
+        std::cout << "=== Comparing Caches ===\n";
+        std::cout << std::left << std::setw(12) << "policy" << std::right
+                  << std::setw(12) << "hit ratio" << std::setw(12) << "ns/op" << '\n';
+
+        const double          total     = static_cast<double>(requests.size());
+        const std::streamsize precision = std::cout.precision();
+
+        for (const auto &cache : caches)
+        {
+            auto start = std::chrono::steady_clock::now();
+            cache.second->run_cache(requests);
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+            std::cout << std::left << std::setw(12) << cache.first << std::right << std::fixed
+                      << std::setw(12) << std::setprecision(6) << static_cast<double>(cache.second->get_hit_count()) / total
+                      << std::setw(12) << std::setprecision(1) << elapsed.count() / total
+                      << std::defaultfloat << '\n';
+        }
+
+        std::cout << std::setprecision(precision) << std::flush;
+    }
+
+    // object and byte hit ratios of a size-aware run
+    void print_weighted_ratio(const std::string &name, ssize_t hits, ssize_t requests_amount,
+                              ssize_t byte_hits, ssize_t bytes) const
+    {
+        const double hit_ratio      = requests_amount ? static_cast<double>(hits) / static_cast<double>(requests_amount) : 0.0;
+        const double byte_hit_ratio = bytes ? static_cast<double>(byte_hits) / static_cast<double>(bytes) : 0.0;
+
+        std::cout << name << " hits: " << hits << ", hit ratio: " << hit_ratio
+                  << ", byte hit ratio: " << byte_hit_ratio << std::endl;
+    }
+
+    // format is "json" or "prometheus"
+    bool export_stats(const ARCStats &stats, const std::string &format, std::ostream &out = std::cout)
+    {
+        if      (format == "json")       write_stats_json(stats, out);
+        else if (format == "prometheus") write_stats_prometheus(stats, out);
+        else
+        {
+            LOG_ERROR("Cache driver", "UNKNOWN STATS FORMAT: ", format);
+            return false;
+        }
+
+        out << std::flush;
+        return true;
+    }
+
 private:
+    static constexpr double STATS_QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+    static void write_stats_json(const ARCStats &stats, std::ostream &out)
+    {
+        const LatencyHistogram &latency = stats.latency();
+
+        out << "{\n"
+            << "  \"requests\": " << stats.requests() << ",\n"
+            << "  \"misses\": "   << stats.misses()   << ",\n"
+            << "  \"expirations\": " << stats.expirations() << ",\n"
+            << "  \"adapt_param_now\": " << stats.adapt_param() << ",\n"
+            << "  \"hits\": {\"t1\": " << stats.hits(ARCList::T1) << ", \"t2\": " << stats.hits(ARCList::T2) << "},\n"
+            << "  \"ghost_hits\": {\"b1\": " << stats.hits(ARCList::B1) << ", \"b2\": " << stats.hits(ARCList::B2) << "},\n"
+            << "  \"evictions\": {";
+
+        for (std::size_t i = 0; i < ARC_LISTS; i++)
+            out << (i ? ", " : "") << '"' << arc_list_name(static_cast<ARCList>(i)) << "\": "
+                << stats.evictions(static_cast<ARCList>(i));
+
+        out << "},\n"
+            << "  \"add_cache_ns\": {\"sample_period\": " << stats.latency_period()
+            << ", \"samples\": " << latency.count()
+            << ", \"mean\": "    << latency.mean();
+
+        for (double quantile : STATS_QUANTILES)
+            out << ", \"p" << quantile * 100 << "\": " << latency.value_at_quantile(quantile);
+
+        out << ", \"max\": " << latency.max() << "},\n"
+            << "  \"adapt_param\": [";
+
+        const auto &trajectory = stats.trajectory();
+        for (std::size_t i = 0; i < trajectory.size(); i++)
+            out << (i ? ", " : "") << '[' << trajectory[i].request << ", " << trajectory[i].adapt_param << ']';
+
+        out << "]\n}\n";
+    }
+
+    static void write_stats_prometheus(const ARCStats &stats, std::ostream &out)
+    {
+        const LatencyHistogram &latency = stats.latency();
+
+        out << "# HELP arc_hits_total Hits by list, t1/t2 resident, b1/b2 ghost.\n"
+            << "# TYPE arc_hits_total counter\n";
+        for (std::size_t i = 0; i < ARC_LISTS; i++)
+            out << "arc_hits_total{list=\"" << arc_list_name(static_cast<ARCList>(i)) << "\"} "
+                << stats.hits(static_cast<ARCList>(i)) << '\n';
+
+        out << "# HELP arc_misses_total Requests for keys in neither the cache nor a ghost list.\n"
+            << "# TYPE arc_misses_total counter\n"
+            << "arc_misses_total " << stats.misses() << '\n';
+
+        out << "# HELP arc_expirations_total Entries dropped from t1/t2 because their TTL ran out.\n"
+            << "# TYPE arc_expirations_total counter\n"
+            << "arc_expirations_total " << stats.expirations() << '\n';
+
+        out << "# HELP arc_evictions_total Entries evicted from each list.\n"
+            << "# TYPE arc_evictions_total counter\n";
+        for (std::size_t i = 0; i < ARC_LISTS; i++)
+            out << "arc_evictions_total{list=\"" << arc_list_name(static_cast<ARCList>(i)) << "\"} "
+                << stats.evictions(static_cast<ARCList>(i)) << '\n';
+
+        out << "# HELP arc_adapt_param Target size of T1.\n"
+            << "# TYPE arc_adapt_param gauge\n"
+            << "arc_adapt_param " << stats.adapt_param() << '\n';
+
+        out << "# HELP arc_add_cache_latency_ns Sampled add_cache latency in nanoseconds.\n"
+            << "# TYPE arc_add_cache_latency_ns summary\n";
+        for (double quantile : STATS_QUANTILES)
+            out << "arc_add_cache_latency_ns{quantile=\"" << quantile << "\"} "
+                << latency.value_at_quantile(quantile) << '\n';
+
+        out << "arc_add_cache_latency_ns_sum "   << latency.sum()   << '\n'
+            << "arc_add_cache_latency_ns_count " << latency.count() << '\n';
+    }
+
     bool handle_vector_size(std::vector<request_t> &vec, const ssize_t &size)
     {
         if (size > vec.max_size())
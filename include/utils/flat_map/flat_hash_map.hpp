@@ -0,0 +1,593 @@
+#ifndef FLAT_HASH_MAP_HPP
+#define FLAT_HASH_MAP_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cassert>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// hash_t and key_equal_t that both declare is_transparent take any type
+// comparable with the key, so find() skips building a key_t (C++20 rule)
+template <typename hash_t, typename key_equal_t, typename = void>
+struct TransparentLookup : std::false_type {};
+
+template <typename hash_t, typename key_equal_t>
+struct TransparentLookup<hash_t, key_equal_t,
+                         std::void_t<typename hash_t::is_transparent, typename key_equal_t::is_transparent>>
+    : std::true_type {};
+
+// SwissTable-style open addressing: one control byte per slot (7 bits of the
+// hash for full slots), probed a group of GROUP_WIDTH bytes at a time.
+// The table is sized once from the expected maximum number of keys and only
+// drops tombstones in place when they run out the free slots.
+template <typename key_t, typename value_t,
+          typename hash_t      = std::hash<key_t>,
+          typename key_equal_t = std::equal_to<key_t>>
+class FlatHashMap
+{
+public:
+    using key_type    = key_t;
+    using mapped_type = value_t;
+    using value_type  = std::pair<const key_t, value_t>;
+    using size_type   = std::size_t;
+
+private:
+    using ctrl_t = std::int8_t;
+
+    static constexpr ctrl_t CTRL_EMPTY   = -128;
+    static constexpr ctrl_t CTRL_DELETED = -2;
+
+    static constexpr size_type GROUP_WIDTH = 16;
+    static constexpr size_type NPOS        = SIZE_MAX;
+
+    // max load is 7/8 of the slots; reserve() keeps the expected keys under
+    // 25/32 so that dropping tombstones always frees a useful share of slots
+    static constexpr size_type LOAD_NUMERATOR    = 7;
+    static constexpr size_type LOAD_DENOMINATOR  = 8;
+    static constexpr size_type RESERVE_NUMERATOR = 25;
+    static constexpr size_type RESERVE_DENOMINATOR = 32;
+
+    using mask_t = std::uint32_t;
+
+    struct Group
+    {
+#if defined(__SSE2__)
+        __m128i ctrl;
+
+        explicit Group(const ctrl_t *pos)
+            : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
+
+        inline mask_t match(ctrl_t h2) const
+        {
+            return static_cast<mask_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2))));
+        }
+
+        inline mask_t match_empty() const { return match(CTRL_EMPTY); }
+
+        // EMPTY and DELETED are the only control bytes with the sign bit set
+        inline mask_t match_empty_or_deleted() const
+        {
+            return static_cast<mask_t>(_mm_movemask_epi8(ctrl));
+        }
+#else
+        const ctrl_t *ctrl;
+
+        explicit Group(const ctrl_t *pos) : ctrl(pos) {}
+
+        inline mask_t match(ctrl_t h2) const
+        {
+            mask_t mask = 0;
+            for (size_type i = 0; i < GROUP_WIDTH; i++)
+                mask |= static_cast<mask_t>(ctrl[i] == h2) << i;
+
+            return mask;
+        }
+
+        inline mask_t match_empty() const { return match(CTRL_EMPTY); }
+
+        inline mask_t match_empty_or_deleted() const
+        {
+            mask_t mask = 0;
+            for (size_type i = 0; i < GROUP_WIDTH; i++)
+                mask |= static_cast<mask_t>(ctrl[i] < 0) << i;
+
+            return mask;
+        }
+#endif
+    };
+
+    template <typename lookup_t>
+    using if_heterogeneous_t = std::enable_if_t<TransparentLookup<hash_t, key_equal_t>::value &&
+                                                !std::is_same<lookup_t, key_t>::value, int>;
+
+    using AllocType   = std::allocator<value_type>;
+    using AllocTraits = std::allocator_traits<AllocType>;
+
+    std::vector<ctrl_t> ctrl_;
+    value_type *slots_;
+    size_type   groups_mask_;
+    size_type   size_;
+    size_type   growth_left_;
+
+    AllocType   alloc_;
+    hash_t      hasher_;
+    key_equal_t key_equal_;
+
+    static inline size_type mix(size_type hash)
+    {
+        // std::hash is the identity for integers on libstdc++, and both H1
+        // and H2 need well-spread bits
+        std::uint64_t h = static_cast<std::uint64_t>(hash);
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        return static_cast<size_type>(h);
+    }
+
+    static inline size_type h1(size_type hash) { return hash >> 7; }
+    static inline ctrl_t    h2(size_type hash) { return static_cast<ctrl_t>(hash & 0x7F); }
+
+    static inline unsigned lowest_bit(mask_t mask) { return static_cast<unsigned>(__builtin_ctz(mask)); }
+
+    inline size_type slot_count() const { return ctrl_.size(); }
+
+    static inline size_type max_load(size_type slots)
+    {
+        return slots / LOAD_DENOMINATOR * LOAD_NUMERATOR;
+    }
+
+    static inline bool fits_reserve(size_type elements, size_type slots)
+    {
+        return elements * RESERVE_DENOMINATOR <= slots * RESERVE_NUMERATOR;
+    }
+
+    static size_type slots_for(size_type max_elements)
+    {
+        size_type slots = GROUP_WIDTH;
+        while (!fits_reserve(max_elements, slots))
+            slots *= 2;
+
+        return slots;
+    }
+
+    template <typename lookup_t>
+    size_type find_index(const lookup_t &key, size_type hash) const
+    {
+        if (slots_ == nullptr) return NPOS;
+
+        size_type group = h1(hash) & groups_mask_;
+        ctrl_t    tag   = h2(hash);
+
+        for (size_type step = 1; ; step++)
+        {
+            const size_type base = group * GROUP_WIDTH;
+            Group probe(ctrl_.data() + base);
+
+            for (mask_t mask = probe.match(tag); mask != 0; mask &= mask - 1)
+            {
+                size_type index = base + lowest_bit(mask);
+                if (key_equal_(slots_[index].first, key))
+                    return index;
+            }
+
+            if (probe.match_empty() != 0) return NPOS;
+
+            group = (group + step) & groups_mask_;
+        }
+    }
+
+    // find_index() that gives up after visiting every group once, which the
+    // triangular probe does in groups_mask_ + 1 steps. It ends even when a
+    // torn read of a table being written never shows an empty group
+    template <typename lookup_t>
+    size_type find_index_bounded(const lookup_t &key, size_type hash) const
+    {
+        if (slots_ == nullptr) return NPOS;
+
+        size_type group = h1(hash) & groups_mask_;
+        ctrl_t    tag   = h2(hash);
+
+        for (size_type step = 1; step <= groups_mask_ + 1; step++)
+        {
+            const size_type base = group * GROUP_WIDTH;
+            Group probe(ctrl_.data() + base);
+
+            for (mask_t mask = probe.match(tag); mask != 0; mask &= mask - 1)
+            {
+                size_type index = base + lowest_bit(mask);
+                if (key_equal_(slots_[index].first, key))
+                    return index;
+            }
+
+            if (probe.match_empty() != 0) return NPOS;
+
+            group = (group + step) & groups_mask_;
+        }
+
+        return NPOS;
+    }
+
+    size_type find_insert_slot(size_type hash) const
+    {
+        size_type group = h1(hash) & groups_mask_;
+
+        for (size_type step = 1; ; step++)
+        {
+            const size_type base = group * GROUP_WIDTH;
+            mask_t mask = Group(ctrl_.data() + base).match_empty_or_deleted();
+
+            if (mask != 0) return base + lowest_bit(mask);
+
+            group = (group + step) & groups_mask_;
+        }
+    }
+
+    void allocate(size_type slots)
+    {
+        ctrl_.assign(slots, CTRL_EMPTY);
+        slots_       = AllocTraits::allocate(alloc_, slots);
+        groups_mask_ = slots / GROUP_WIDTH - 1;
+        size_        = 0;
+        growth_left_ = max_load(slots);
+    }
+
+    void destroy_slots()
+    {
+        if (slots_ == nullptr) return;
+
+        for (size_type i = 0; i < slot_count(); i++)
+            if (ctrl_[i] >= 0)
+                AllocTraits::destroy(alloc_, slots_ + i);
+
+        AllocTraits::deallocate(alloc_, slots_, slot_count());
+        slots_ = nullptr;
+    }
+
+    void place(size_type hash, value_type &&entry)
+    {
+        size_type index = find_insert_slot(hash);
+
+        ctrl_[index] = h2(hash);
+        AllocTraits::construct(alloc_, slots_ + index, std::move(entry));
+
+        size_++;
+        growth_left_--;
+    }
+
+    // drops tombstones without touching the slot array, so its address
+    // stays the same for the lifetime of the table, and without a buffer.
+    // Live slots are marked DELETED and tombstones EMPTY; then every
+    // DELETED slot is reinserted, swapping with the pending entry that
+    // sits where it lands
+    void rehash_in_place()
+    {
+        for (ctrl_t &ctrl : ctrl_)
+            ctrl = ctrl >= 0 ? CTRL_DELETED : CTRL_EMPTY;
+
+        alignas(value_type) unsigned char buffer[sizeof(value_type)];
+        value_type *tmp = reinterpret_cast<value_type *>(buffer);
+
+        for (size_type i = 0; i < slot_count(); i++)
+        {
+            if (ctrl_[i] != CTRL_DELETED) continue;
+
+            const size_type hash   = mix(hasher_(slots_[i].first));
+            const size_type target = find_insert_slot(hash);
+
+            // every group the probe passes before this one is full, so the
+            // entry is already where a lookup stops
+            if (target / GROUP_WIDTH == i / GROUP_WIDTH)
+            {
+                ctrl_[i] = h2(hash);
+                continue;
+            }
+
+            if (ctrl_[target] == CTRL_EMPTY)
+            {
+                AllocTraits::construct(alloc_, slots_ + target, std::move(slots_[i]));
+                AllocTraits::destroy(alloc_, slots_ + i);
+
+                ctrl_[target] = h2(hash);
+                ctrl_[i]      = CTRL_EMPTY;
+                continue;
+            }
+
+            // the target holds another entry waiting to be placed: swap
+            // them and look at slot i again
+            AllocTraits::construct(alloc_, tmp, std::move(slots_[target]));
+            AllocTraits::destroy(alloc_, slots_ + target);
+            AllocTraits::construct(alloc_, slots_ + target, std::move(slots_[i]));
+            AllocTraits::destroy(alloc_, slots_ + i);
+            AllocTraits::construct(alloc_, slots_ + i, std::move(*tmp));
+            AllocTraits::destroy(alloc_, tmp);
+
+            ctrl_[target] = h2(hash);
+            i--;
+        }
+
+        growth_left_ = max_load(slot_count()) - size_;
+    }
+
+    // reinserts every live entry into a table of the given size, which also
+    // clears all tombstones
+    void rehash(size_type slots)
+    {
+        if (slots_ != nullptr && slots == slot_count())
+        {
+            rehash_in_place();
+            return;
+        }
+
+        std::vector<ctrl_t> old_ctrl  = std::move(ctrl_);
+        value_type         *old_slots = slots_;
+
+        allocate(slots);
+
+        for (size_type i = 0; i < old_ctrl.size(); i++)
+        {
+            if (old_ctrl[i] < 0) continue;
+
+            place(mix(hasher_(old_slots[i].first)), std::move(old_slots[i]));
+            AllocTraits::destroy(alloc_, old_slots + i);
+        }
+
+        if (old_slots != nullptr)
+            AllocTraits::deallocate(alloc_, old_slots, old_ctrl.size());
+    }
+
+    template <typename key_arg_t, typename... args_t>
+    std::pair<size_type, bool> insert_unique(key_arg_t &&key, args_t &&... args)
+    {
+        size_type hash  = mix(hasher_(key));
+        size_type index = find_index(key, hash);
+
+        if (index != NPOS) return {index, false};
+
+        if (slots_ == nullptr) allocate(slots_for(1));
+
+        index = find_insert_slot(hash);
+        if (growth_left_ == 0 && ctrl_[index] == CTRL_EMPTY)
+        {
+            // tombstones ate the free slots: clean them up at the same size
+            // unless the table holds more keys than it was reserved for
+            rehash(fits_reserve(size_ + 1, slot_count()) ? slot_count() : 2 * slot_count());
+            index = find_insert_slot(hash);
+        }
+
+        if (ctrl_[index] == CTRL_EMPTY) growth_left_--;
+
+        ctrl_[index] = h2(hash);
+        AllocTraits::construct(alloc_, slots_ + index,
+                               std::piecewise_construct,
+                               std::forward_as_tuple(std::forward<key_arg_t>(key)),
+                               std::forward_as_tuple(std::forward<args_t>(args)...));
+        size_++;
+
+        return {index, true};
+    }
+
+    void erase_index(size_type index)
+    {
+        assert(ctrl_[index] >= 0);
+
+        AllocTraits::destroy(alloc_, slots_ + index);
+        size_--;
+
+        // a group that still has an EMPTY byte was never full, so no probe
+        // sequence runs through it and the slot can become EMPTY again
+        const size_type base = index / GROUP_WIDTH * GROUP_WIDTH;
+        if (Group(ctrl_.data() + base).match_empty() != 0)
+        {
+            ctrl_[index] = CTRL_EMPTY;
+            growth_left_++;
+        }
+        else
+            ctrl_[index] = CTRL_DELETED;
+    }
+
+public:
+    template <bool is_const>
+    class Iterator
+    {
+    private:
+        using map_ptr_t = typename std::conditional<is_const, const FlatHashMap *, FlatHashMap *>::type;
+
+        map_ptr_t map_;
+        size_type index_;
+
+        void skip_free()
+        {
+            while (index_ < map_->slot_count() && map_->ctrl_[index_] < 0)
+                index_++;
+        }
+
+        friend class FlatHashMap;
+        template <bool> friend class Iterator;
+
+    public:
+        using reference = typename std::conditional<is_const, const value_type &, value_type &>::type;
+        using pointer   = typename std::conditional<is_const, const value_type *, value_type *>::type;
+
+        Iterator() : map_(nullptr), index_(0) {}
+        Iterator(map_ptr_t map, size_type index) : map_(map), index_(index) {}
+
+        Iterator(const Iterator<false> &other) : map_(other.map_), index_(other.index_) {}
+
+        inline reference operator*()  const { return map_->slots_[index_]; }
+        inline pointer   operator->() const { return map_->slots_ + index_; }
+
+        inline Iterator &operator++()
+        {
+            index_++;
+            skip_free();
+            return *this;
+        }
+
+        inline bool operator==(const Iterator &other) const { return index_ == other.index_; }
+        inline bool operator!=(const Iterator &other) const { return index_ != other.index_; }
+    };
+
+    using iterator       = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit FlatHashMap() : ctrl_(), slots_(nullptr), groups_mask_(0), size_(0), growth_left_(0) {}
+
+    explicit FlatHashMap(size_type max_elements) : FlatHashMap()
+    {
+        reserve(max_elements);
+    }
+
+    FlatHashMap(const FlatHashMap &) = delete;
+    FlatHashMap &operator=(const FlatHashMap &) = delete;
+
+    ~FlatHashMap() { destroy_slots(); }
+
+    void reserve(size_type max_elements)
+    {
+        if (slots_ == nullptr || slots_for(max_elements) > slot_count())
+            rehash(slots_for(max_elements));
+    }
+
+    inline size_type size()  const { return size_; }
+    inline bool      empty() const { return size_ == 0; }
+
+    inline size_type bucket_count() const { return slot_count(); }
+
+    inline size_type memory_usage() const
+    {
+        return slot_count() * (sizeof(ctrl_t) + sizeof(value_type));
+    }
+
+    iterator begin()
+    {
+        iterator it(this, 0);
+        it.skip_free();
+        return it;
+    }
+
+    const_iterator begin() const
+    {
+        const_iterator it(this, 0);
+        it.skip_free();
+        return it;
+    }
+
+    inline iterator       end()       { return iterator(this, slot_count()); }
+    inline const_iterator end() const { return const_iterator(this, slot_count()); }
+
+    iterator find(const key_t &key)
+    {
+        size_type index = find_index(key, mix(hasher_(key)));
+        return (index == NPOS) ? end() : iterator(this, index);
+    }
+
+    const_iterator find(const key_t &key) const
+    {
+        size_type index = find_index(key, mix(hasher_(key)));
+        return (index == NPOS) ? end() : const_iterator(this, index);
+    }
+
+    template <typename lookup_t, if_heterogeneous_t<lookup_t> = 0>
+    iterator find(const lookup_t &key)
+    {
+        size_type index = find_index(key, mix(hasher_(key)));
+        return (index == NPOS) ? end() : iterator(this, index);
+    }
+
+    template <typename lookup_t, if_heterogeneous_t<lookup_t> = 0>
+    const_iterator find(const lookup_t &key) const
+    {
+        size_type index = find_index(key, mix(hasher_(key)));
+        return (index == NPOS) ? end() : const_iterator(this, index);
+    }
+
+    // find() for a reader racing a writer under a seqlock: the probe is
+    // bounded, and the caller must throw the result away if the writer ran
+    const_iterator find_bounded(const key_t &key) const
+    {
+        size_type index = find_index_bounded(key, mix(hasher_(key)));
+        return (index == NPOS) ? end() : const_iterator(this, index);
+    }
+
+    template <typename lookup_t, if_heterogeneous_t<lookup_t> = 0>
+    const_iterator find_bounded(const lookup_t &key) const
+    {
+        size_type index = find_index_bounded(key, mix(hasher_(key)));
+        return (index == NPOS) ? end() : const_iterator(this, index);
+    }
+
+    // for callers looking up a batch of keys: hash() every key, prefetch()
+    // its control group, prefetch_slot() the slot its tag matches, and only
+    // then find() them, so the cache misses of the batch overlap instead of
+    // queueing one behind another
+    inline size_type hash(const key_t &key) const { return mix(hasher_(key)); }
+
+    inline void prefetch(size_type hash) const
+    {
+        if (slots_ == nullptr) return;
+
+        __builtin_prefetch(ctrl_.data() + (h1(hash) & groups_mask_) * GROUP_WIDTH);
+    }
+
+    // reads the control group, so it pays off once prefetch() has landed;
+    // only the home group is looked at, a longer probe is left to find()
+    inline void prefetch_slot(size_type hash) const
+    {
+        if (slots_ == nullptr) return;
+
+        const size_type base = (h1(hash) & groups_mask_) * GROUP_WIDTH;
+        const mask_t    mask = Group(ctrl_.data() + base).match(h2(hash));
+
+        if (mask != 0)
+            __builtin_prefetch(slots_ + base + lowest_bit(mask));
+    }
+
+    template <typename... args_t>
+    std::pair<iterator, bool> emplace(const key_t &key, args_t &&... args)
+    {
+        auto [index, inserted] = insert_unique(key, std::forward<args_t>(args)...);
+        return {iterator(this, index), inserted};
+    }
+
+    value_t &operator[](const key_t &key)
+    {
+        size_type index = insert_unique(key).first;
+        return slots_[index].second;
+    }
+
+    size_type erase(const key_t &key)
+    {
+        size_type index = find_index(key, mix(hasher_(key)));
+        if (index == NPOS) return 0;
+
+        erase_index(index);
+        return 1;
+    }
+
+    inline void erase(iterator it) { erase_index(it.index_); }
+
+    void clear()
+    {
+        for (size_type i = 0; i < slot_count(); i++)
+        {
+            if (ctrl_[i] >= 0)
+                AllocTraits::destroy(alloc_, slots_ + i);
+
+            ctrl_[i] = CTRL_EMPTY;
+        }
+
+        size_        = 0;
+        growth_left_ = max_load(slot_count());
+    }
+};
+
+#endif
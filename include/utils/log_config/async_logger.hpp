@@ -0,0 +1,255 @@
+#ifndef ASYNC_LOGGER_HPP
+#define ASYNC_LOGGER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#include "log_level.hpp"
+
+// Logging backend that keeps I/O off the calling thread. A record is
+// formatted into a fixed buffer on the caller's stack and copied into a
+// bounded MPSC ring; one writer thread drains the ring into the log file.
+// A producer never locks, allocates (for numbers and strings) or waits:
+// when the ring is full the record is dropped and counted.
+class AsyncLogger
+{
+private:
+    static constexpr std::size_t RECORD_SIZE = 248;
+    static constexpr std::uint32_t RING_SIZE = 4096;
+
+    static constexpr auto MIN_BACKOFF = std::chrono::microseconds(50);
+    static constexpr auto MAX_BACKOFF = std::chrono::milliseconds(4);
+
+    struct Slot
+    {
+        std::atomic<std::uint32_t> sequence;
+        std::uint32_t length;
+        char text[RECORD_SIZE];
+    };
+
+    struct LineBuffer
+    {
+        char        text[RECORD_SIZE];
+        std::size_t length = 0;
+
+        void append(const char *data, std::size_t size)
+        {
+            size = std::min(size, RECORD_SIZE - 1 - length);
+            std::memcpy(text + length, data, size);
+            length += size;
+        }
+
+        inline void append(std::string_view view) { append(view.data(), view.size()); }
+    };
+
+    alignas(64) std::atomic<std::uint32_t> tail_;
+    alignas(64) std::atomic<std::uint32_t> head_;
+    alignas(64) std::atomic<std::uint64_t> dropped_;
+
+    Slot *ring_;
+
+    std::FILE         *file_;
+    std::thread        writer_;
+    std::atomic<bool>  running_;
+
+    AsyncLogger() : tail_(0), head_(0), dropped_(0), ring_(new Slot[RING_SIZE]),
+                    file_(nullptr), writer_(), running_(false)
+    {
+        for (std::uint32_t i = 0; i < RING_SIZE; i++)
+            ring_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    static const char *level_name(LogLevel level)
+    {
+        switch (level)
+        {
+            case LogLevel::ERROR:   return "ERROR   ";
+            case LogLevel::WARNING: return "WARNING ";
+            case LogLevel::INFO:    return "INFO    ";
+            case LogLevel::DUMP:    return "DUMP    ";
+            case LogLevel::OFF:     break;
+        }
+
+        return "        ";
+    }
+
+    template <typename value_t>
+    static void format(LineBuffer &line, const value_t &value)
+    {
+        using plain_t = std::decay_t<value_t>;
+
+        if constexpr (std::is_same_v<plain_t, bool>)
+            line.append(value ? "true" : "false");
+
+        else if constexpr (std::is_same_v<plain_t, char>)
+            line.append(&value, 1);
+
+        else if constexpr (std::is_integral_v<plain_t> || std::is_floating_point_v<plain_t>)
+        {
+            char digits[32];
+            auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            line.append(digits, static_cast<std::size_t>(result.ptr - digits));
+        }
+
+        else if constexpr (std::is_convertible_v<const value_t &, std::string_view>)
+            line.append(std::string_view(value));
+
+        // anything else goes through its operator<<; that allocates, but no
+        // hot-path message logs such types
+        else
+        {
+            std::ostringstream stream;
+            stream << value;
+            line.append(stream.str());
+        }
+    }
+
+    bool push(const LineBuffer &line)
+    {
+        std::uint32_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot &slot = ring_[pos % RING_SIZE];
+            std::uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+            std::int32_t  diff     = static_cast<std::int32_t>(sequence - pos);
+
+            if (diff == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    std::memcpy(slot.text, line.text, line.length);
+                    slot.length = static_cast<std::uint32_t>(line.length);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // single consumer: the writer thread, or close() after it is joined
+    std::size_t drain()
+    {
+        std::size_t written = 0;
+        for (;;)
+        {
+            std::uint32_t pos = head_.load(std::memory_order_relaxed);
+            Slot &slot = ring_[pos % RING_SIZE];
+
+            if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+                return written;
+
+            if (file_ != nullptr)
+            {
+                std::fwrite(slot.text, 1, slot.length, file_);
+                std::fputc('\n', file_);
+            }
+
+            slot.sequence.store(pos + RING_SIZE, std::memory_order_release);
+            head_.store(pos + 1, std::memory_order_relaxed);
+            written++;
+        }
+    }
+
+    void writer_loop()
+    {
+        auto backoff = MIN_BACKOFF;
+        while (running_.load(std::memory_order_acquire))
+        {
+            if (drain() != 0)
+            {
+                std::fflush(file_);
+                backoff = MIN_BACKOFF;
+                continue;
+            }
+
+            std::this_thread::sleep_for(backoff);
+            backoff = std::min<std::chrono::microseconds>(backoff * 2, MAX_BACKOFF);
+        }
+    }
+
+public:
+    AsyncLogger(const AsyncLogger &) = delete;
+    AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+    ~AsyncLogger()
+    {
+        close();
+        delete[] ring_;
+    }
+
+    static AsyncLogger &instance()
+    {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    // records logged before open() wait in the ring (up to its size)
+    bool open(const std::string &path)
+    {
+        close();
+
+        file_ = std::fopen(path.c_str(), "w");
+        if (file_ == nullptr)
+        {
+            std::fprintf(stderr, "async logger: can not open %s\n", path.c_str());
+            return false;
+        }
+
+        running_.store(true, std::memory_order_release);
+        writer_ = std::thread(&AsyncLogger::writer_loop, this);
+        return true;
+    }
+
+    void close()
+    {
+        if (!running_.exchange(false, std::memory_order_acq_rel))
+            return;
+
+        writer_.join();
+        drain();
+
+        const std::uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+        if (dropped != 0)
+            std::fprintf(file_, "%s| async logger | %llu records dropped, ring was full\n",
+                         level_name(LogLevel::WARNING), static_cast<unsigned long long>(dropped));
+
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+
+    inline std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // the first argument is the title, as with the HTML logger macros
+    template <typename title_t, typename... args_t>
+    void log(LogLevel level, const title_t &title, const args_t &...args)
+    {
+        LineBuffer line;
+        line.append(level_name(level));
+        line.append("| ");
+        format(line, title);
+        line.append(" | ");
+        (format(line, args), ...);
+
+        for (std::size_t i = 0; i < line.length; i++)
+            if (line.text[i] == '\n') line.text[i] = ' ';
+
+        if (!push(line))
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+#endif
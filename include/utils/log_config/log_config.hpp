@@ -0,0 +1,109 @@
+#ifndef LOG_CONFIG_HPP
+#define LOG_CONFIG_HPP
+
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "../logger/logger.hpp"
+#include "log_level.hpp"
+#include "async_logger.hpp"
+
+// Every cache includes the logger through this header. LOG_* calls above
+// CACHE_LOG_LEVEL become discarded statements: the arguments are still
+// type-checked, so nothing goes unused, but they are never evaluated and
+// no code is emitted. With CACHE_ASYNC_LOG the enabled calls go to
+// AsyncLogger instead of HtmlLogger, so no cache operation waits on I/O.
+
+template <typename... args_t>
+inline void log_discard(const args_t &...) {}
+
+// dumps are instantiated with the cache even when the level drops them, so
+// keys and items without an operator<< are printed as a placeholder
+template <typename value_t, typename = void>
+struct is_streamable : std::false_type {};
+
+template <typename value_t>
+struct is_streamable<value_t, std::void_t<decltype(std::declval<std::ostream &>() << std::declval<const value_t &>())>>
+    : std::true_type {};
+
+template <typename value_t>
+inline decltype(auto) log_value(const value_t &value)
+{
+    if constexpr (is_streamable<value_t>::value)
+        return (value);
+    else
+        return "<unprintable>";
+}
+
+#define CACHE_LOG_DISCARD(...) \
+    do { if constexpr (false) log_discard(__VA_ARGS__); } while (0)
+
+#ifdef CACHE_ASYNC_LOG
+
+#define CACHE_LOG_ASYNC(level, ...) \
+    do { if constexpr (LOG_ENABLED<level>) AsyncLogger::instance().log(level, __VA_ARGS__); } while (0)
+
+#undef LOG_ERROR
+#undef LOG_WARNING
+#undef LOG_INFO
+#undef LOG_DUMP
+
+#define LOG_ERROR(...)   CACHE_LOG_ASYNC(LogLevel::ERROR,   __VA_ARGS__)
+#define LOG_WARNING(...) CACHE_LOG_ASYNC(LogLevel::WARNING, __VA_ARGS__)
+#define LOG_INFO(...)    CACHE_LOG_ASYNC(LogLevel::INFO,    __VA_ARGS__)
+#define LOG_DUMP(...)    CACHE_LOG_ASYNC(LogLevel::DUMP,    __VA_ARGS__)
+
+#else
+
+// the HTML logger keeps its own macros for the levels that stay on
+#if CACHE_LOG_LEVEL < 1
+#undef  LOG_ERROR
+#define LOG_ERROR(...) CACHE_LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if CACHE_LOG_LEVEL < 2
+#undef  LOG_WARNING
+#define LOG_WARNING(...) CACHE_LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if CACHE_LOG_LEVEL < 3
+#undef  LOG_INFO
+#define LOG_INFO(...) CACHE_LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if CACHE_LOG_LEVEL < 4
+#undef  LOG_DUMP
+#define LOG_DUMP(...) CACHE_LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#endif
+
+// mains open and close the log through these, so a build with logging off
+// does not create a log file at all
+inline void log_open(const std::string &name)
+{
+    if constexpr (LOG_ENABLED<LogLevel::ERROR>)
+    {
+#ifdef CACHE_ASYNC_LOG
+        AsyncLogger::instance().open(name + ".log");
+#else
+        HtmlLogger::init(name);
+#endif
+    }
+}
+
+inline void log_close()
+{
+    if constexpr (LOG_ENABLED<LogLevel::ERROR>)
+    {
+#ifdef CACHE_ASYNC_LOG
+        AsyncLogger::instance().close();
+#else
+        HtmlLogger::close();
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef LOG_LEVEL_HPP
+#define LOG_LEVEL_HPP
+
+// CACHE_LOG_LEVEL comes from CMake (the CACHE_LOG_LEVEL option):
+// 0 off, 1 errors, 2 warnings, 3 info, 4 dumps
+#ifndef CACHE_LOG_LEVEL
+#define CACHE_LOG_LEVEL 4
+#endif
+
+enum class LogLevel : int
+{
+    OFF     = 0,
+    ERROR   = 1,
+    WARNING = 2,
+    INFO    = 3,
+    DUMP    = 4,
+};
+
+// compile-time switch for a level; code under if constexpr on a disabled
+// level is type-checked but never emitted
+template <LogLevel level>
+inline constexpr bool LOG_ENABLED = static_cast<int>(level) <= CACHE_LOG_LEVEL;
+
+#endif
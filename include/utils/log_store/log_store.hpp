@@ -0,0 +1,446 @@
+#ifndef LOG_STORE_HPP
+#define LOG_STORE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "utils/log_config/log_config.hpp"
+#include "utils/flat_map/flat_hash_map.hpp"
+#include "ARC/ARC_Snapshot.hpp"
+
+// Log-structured key-value store in one file, used as a second cache tier.
+// The file is a ring of SEGMENT_SIZE segments. put() encodes the item into
+// the in-memory buffer of the segment being filled; a full segment goes to
+// a writer thread that stores it with a single pwrite while the next one
+// fills, so the caller never waits on the device unless WRITE_BUFFERS
+// segments are queued. get() reads the item back with one pread, or from
+// memory while its segment is not written yet.
+//
+// The only thing kept in memory per item is its index entry: key, segment,
+// offset and length. Each record in the file carries its key in front of
+// the item (and the item length, for variable-size codecs). When the log
+// wraps around, the oldest segment is read back once before it is
+// overwritten, and every key still pointing into it is dropped, so the
+// store forgets in FIFO order and never compacts. Rewritten and taken keys
+// just leave dead bytes behind until their segment comes around.
+//
+// Like ARCCache it is not thread-safe; the writer thread is internal. The
+// file is unlinked once open: the index lives in memory only, so the data
+// is of no use after the process exits.
+template <typename key_t, typename item_t, typename codec_t = TrivialItemCodec<item_t>>
+class LogStore
+{
+    static_assert(std::is_trivially_copyable<key_t>::value, "LogStore writes raw keys into its records");
+
+public:
+    static constexpr std::size_t SEGMENT_SIZE  = std::size_t(1) << 20;
+    static constexpr std::size_t WRITE_BUFFERS = 4;
+
+    // O_DIRECT wants buffers, offsets and lengths on the device block size
+    static constexpr std::size_t DIRECT_ALIGNMENT = 4096;
+
+private:
+    static constexpr std::size_t MIN_SEGMENTS = 2;
+
+    // record: key, then the item length unless the codec has a fixed one,
+    // then the item
+    static constexpr std::size_t LENGTH_SIZE = codec_t::FIXED_SIZE ? 0 : sizeof(std::uint32_t);
+    static constexpr std::size_t HEADER_SIZE = sizeof(key_t) + LENGTH_SIZE;
+
+    struct Location
+    {
+        std::uint32_t segment;
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    struct AlignedFree
+    {
+        inline void operator()(unsigned char *memory) const { std::free(memory); }
+    };
+
+    using Buffer = std::unique_ptr<unsigned char[], AlignedFree>;
+
+    int         fd_;
+    bool        direct_;
+    std::size_t segments_;
+    codec_t     codec_;
+
+    FlatHashMap<key_t, Location> index_;
+
+    // bytes of records in each physical segment, for walking them on wrap
+    std::vector<std::uint32_t> segment_fill_;
+
+    // segment n fills buffers_ + (n % WRITE_BUFFERS) * SEGMENT_SIZE
+    Buffer        buffers_;
+    Buffer        scratch_;
+    std::uint32_t current_;
+    std::size_t   fill_;
+
+    // segments below flushed_ are on the device; the writer stores them in
+    // order, so that is the whole handshake for reads
+    std::atomic<std::uint32_t> flushed_;
+    std::atomic<bool>          failed_;
+
+    std::mutex                mutex_;
+    std::condition_variable   queued_;
+    std::condition_variable   written_;
+    std::deque<std::uint32_t> queue_;
+    bool                      stop_;
+    std::thread               writer_;
+
+    std::uint64_t puts_;
+    std::uint64_t rejected_;
+    std::uint64_t dropped_;
+    std::uint64_t memory_reads_;
+    std::uint64_t file_reads_;
+    std::uint64_t stalls_;
+
+    static Buffer allocate(std::size_t size)
+    {
+        return Buffer(static_cast<unsigned char *>(std::aligned_alloc(DIRECT_ALIGNMENT, size)));
+    }
+
+    inline unsigned char *buffer(std::uint32_t segment) const
+    {
+        return buffers_.get() + (segment % WRITE_BUFFERS) * SEGMENT_SIZE;
+    }
+
+    inline off_t file_offset(std::uint32_t segment) const
+    {
+        return static_cast<off_t>((segment % segments_) * SEGMENT_SIZE);
+    }
+
+    void write_loop()
+    {
+        for (;;)
+        {
+            std::uint32_t segment = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                queued_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+
+                if (stop_) return;
+
+                segment = queue_.front();
+            }
+
+            if (!write_all(buffer(segment), SEGMENT_SIZE, file_offset(segment)) && !failed_.exchange(true))
+                LOG_ERROR("Log store", "WRITE FAILED, segment: ", segment, " the store stops caching");
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queue_.pop_front();
+                flushed_.store(segment + 1, std::memory_order_release);
+            }
+            written_.notify_all();
+        }
+    }
+
+    bool write_all(const unsigned char *data, std::size_t size, off_t offset) const
+    {
+        while (size != 0)
+        {
+            const ssize_t written = ::pwrite(fd_, data, size, offset);
+            if (written <= 0) return false;
+
+            data   += written;
+            size   -= static_cast<std::size_t>(written);
+            offset += written;
+        }
+
+        return true;
+    }
+
+    bool read_all(unsigned char *data, std::size_t size, off_t offset) const
+    {
+        while (size != 0)
+        {
+            const ssize_t read = ::pread(fd_, data, size, offset);
+            if (read <= 0) return false;
+
+            data   += read;
+            size   -= static_cast<std::size_t>(read);
+            offset += read;
+        }
+
+        return true;
+    }
+
+    // hands the full segment to the writer and starts the next one, once
+    // its buffer has been written out; whatever the next one overwrites in
+    // the file is forgotten first
+    void next_segment()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queue_.push_back(current_);
+            queued_.notify_one();
+
+            const std::uint32_t next = current_ + 1;
+            if (next >= WRITE_BUFFERS && flushed_.load(std::memory_order_acquire) <= next - WRITE_BUFFERS)
+            {
+                stalls_++;
+                written_.wait(lock, [this, next]()
+                {
+                    return flushed_.load(std::memory_order_acquire) > next - WRITE_BUFFERS;
+                });
+            }
+        }
+
+        segment_fill_[current_ % segments_] = static_cast<std::uint32_t>(fill_);
+
+        current_++;
+        fill_ = 0;
+
+        if (current_ < segments_) return;
+
+        drop_segment(static_cast<std::uint32_t>(current_ - segments_));
+    }
+
+    // reads back the segment about to be overwritten, whose file slot still
+    // holds it, and forgets every key whose latest record is in there. If
+    // the read fails the entries stay, and read() refuses them by segment
+    void drop_segment(std::uint32_t overwritten)
+    {
+        const std::size_t fill = segment_fill_[overwritten % segments_];
+        if (fill == 0) return;
+
+        const unsigned char *records = buffer(overwritten);
+        if (overwritten < flushed_.load(std::memory_order_acquire))
+        {
+            if (!is_open() || !read_all(scratch_.get(), direct_ ? SEGMENT_SIZE : fill, file_offset(overwritten)))
+            {
+                LOG_ERROR("Log store", "READ FAILED, segment: ", overwritten, " its keys expire on lookup");
+                return;
+            }
+
+            records = scratch_.get();
+        }
+
+        for (std::size_t offset = 0; offset < fill; )
+        {
+            key_t key;
+            std::memcpy(&key, records + offset, sizeof(key_t));
+
+            std::uint32_t length = static_cast<std::uint32_t>(codec_t::FIXED_SIZE);
+            if constexpr (LENGTH_SIZE != 0)
+                std::memcpy(&length, records + offset + sizeof(key_t), LENGTH_SIZE);
+
+            offset += HEADER_SIZE;
+
+            auto it = index_.find(key);
+            if (it != index_.end() && it->second.segment == overwritten && it->second.offset == offset)
+            {
+                index_.erase(it);
+                dropped_++;
+            }
+
+            offset += length;
+        }
+    }
+
+    // the item bytes of an index entry: straight from the segment buffer
+    // if the writer has not stored it yet, else read into scratch_
+    const unsigned char *read(const Location &location)
+    {
+        // its segment was overwritten without being walked
+        if (location.segment + segments_ <= current_) return nullptr;
+
+        if (location.segment >= flushed_.load(std::memory_order_acquire))
+        {
+            memory_reads_++;
+            return buffer(location.segment) + location.offset;
+        }
+
+        // a segment the writer failed on holds garbage
+        if (!is_open()) return nullptr;
+
+        std::size_t begin = location.offset;
+        std::size_t end   = location.offset + location.length;
+
+        if (direct_)
+        {
+            begin = begin / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+            end   = (end + DIRECT_ALIGNMENT - 1) / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+        }
+
+        if (!read_all(scratch_.get(), end - begin, file_offset(location.segment) + static_cast<off_t>(begin)))
+        {
+            LOG_ERROR("Log store", "READ FAILED, segment: ", location.segment, " offset: ", location.offset);
+            return nullptr;
+        }
+
+        file_reads_++;
+        return scratch_.get() + (location.offset - begin);
+    }
+
+public:
+    // capacity_bytes is the size of the file, rounded down to whole
+    // segments. direct_io bypasses the page cache, so reads measure the
+    // device; where the file system refuses O_DIRECT the store falls back
+    // to buffered I/O
+    explicit LogStore(const std::string &path, std::size_t capacity_bytes, bool direct_io = false,
+                      const codec_t &codec = codec_t())
+             : fd_(-1), direct_(false), segments_(std::max(MIN_SEGMENTS, capacity_bytes / SEGMENT_SIZE)),
+               codec_(codec), index_(), segment_fill_(segments_, 0),
+               buffers_(allocate(WRITE_BUFFERS * SEGMENT_SIZE)), scratch_(allocate(SEGMENT_SIZE)),
+               current_(0), fill_(0), flushed_(0), failed_(false), mutex_(), queued_(), written_(),
+               queue_(), stop_(false), writer_(), puts_(0), rejected_(0), dropped_(0),
+               memory_reads_(0), file_reads_(0), stalls_(0)
+    {
+        if (capacity_bytes < MIN_SEGMENTS * SEGMENT_SIZE)
+            LOG_WARNING("Log store", "capacity ", capacity_bytes, " is below ", MIN_SEGMENTS,
+                        " segments, set ", MIN_SEGMENTS * SEGMENT_SIZE);
+
+        if (direct_io)
+        {
+            fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_DIRECT, 0600);
+            if (fd_ >= 0)
+                direct_ = true;
+            else
+                LOG_WARNING("Log store", "O_DIRECT is not supported for ", path, ", using the page cache");
+        }
+
+        if (fd_ < 0)
+            fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+        if (fd_ < 0 || buffers_ == nullptr || scratch_ == nullptr)
+        {
+            LOG_ERROR("Log store", "CAN NOT OPEN: ", path);
+            failed_.store(true);
+            return;
+        }
+
+        ::unlink(path.c_str());
+        writer_ = std::thread(&LogStore::write_loop, this);
+
+        LOG_INFO("Log store", "opened ", path, " segments: ", segments_, " direct: ", direct_);
+    }
+
+    LogStore(const LogStore &) = delete;
+    LogStore &operator=(const LogStore &) = delete;
+
+    ~LogStore()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        queued_.notify_one();
+
+        if (writer_.joinable()) writer_.join();
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    inline bool is_open() const { return !failed_.load(std::memory_order_relaxed); }
+
+    // false when the record is larger than a segment or the store failed;
+    // an older copy of the key is replaced either way
+    bool put(const key_t &key, const item_t &item)
+    {
+        const std::size_t size = codec_.encoded_size(item);
+        if (HEADER_SIZE + size > SEGMENT_SIZE || !is_open())
+        {
+            index_.erase(key);
+            rejected_++;
+            return false;
+        }
+
+        if (fill_ + HEADER_SIZE + size > SEGMENT_SIZE)
+            next_segment();
+
+        unsigned char *record = buffer(current_) + fill_;
+        std::memcpy(record, &key, sizeof(key_t));
+
+        if constexpr (LENGTH_SIZE != 0)
+        {
+            const std::uint32_t length = static_cast<std::uint32_t>(size);
+            std::memcpy(record + sizeof(key_t), &length, LENGTH_SIZE);
+        }
+
+        fill_ += HEADER_SIZE;
+
+        if (size != 0)
+            codec_.encode(item, buffer(current_) + fill_);
+
+        index_[key] = Location{current_, static_cast<std::uint32_t>(fill_), static_cast<std::uint32_t>(size)};
+
+        fill_ += size;
+        puts_++;
+        return true;
+    }
+
+    bool get(const key_t &key, item_t &item)
+    {
+        auto it = index_.find(key);
+        if (it == index_.end()) return false;
+
+        const unsigned char *data = read(it->second);
+        if (data == nullptr)
+        {
+            index_.erase(it);
+            return false;
+        }
+
+        item = codec_.decode(data, it->second.length);
+        return true;
+    }
+
+    // get that also forgets the key, for an item moving up a tier
+    bool take(const key_t &key, item_t &item)
+    {
+        auto it = index_.find(key);
+        if (it == index_.end()) return false;
+
+        const unsigned char *data = read(it->second);
+        if (data != nullptr)
+            item = codec_.decode(data, it->second.length);
+
+        index_.erase(it);
+        return data != nullptr;
+    }
+
+    inline bool erase(const key_t &key) { return index_.erase(key) != 0; }
+
+    inline bool contains(const key_t &key) const { return index_.find(key) != index_.end(); }
+
+    inline std::size_t size()           const { return index_.size(); }
+    inline std::size_t capacity_bytes() const { return segments_ * SEGMENT_SIZE; }
+    inline bool        direct_io()      const { return direct_; }
+
+    inline std::uint64_t puts()          const { return puts_; }
+    inline std::uint64_t rejected()      const { return rejected_; }
+    inline std::uint64_t dropped()       const { return dropped_; }
+    inline std::uint64_t memory_reads()  const { return memory_reads_; }
+    inline std::uint64_t file_reads()    const { return file_reads_; }
+    inline std::uint64_t write_stalls()  const { return stalls_; }
+    inline std::uint64_t bytes_written() const
+    {
+        return std::uint64_t(flushed_.load(std::memory_order_relaxed)) * SEGMENT_SIZE;
+    }
+
+    // the in-memory side: the index, the buffers and a fill per segment
+    std::size_t memory_usage() const
+    {
+        return index_.memory_usage() + (WRITE_BUFFERS + 1) * SEGMENT_SIZE +
+               segment_fill_.capacity() * sizeof(std::uint32_t);
+    }
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef SPATIAL_SAMPLER_HPP
+#define SPATIAL_SAMPLER_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "../../RequestSpan.hpp"
+
+// SHARDS-style spatial sampling: a key is kept iff its hash lands below a
+// threshold, so either every request of a key is in the sample or none is.
+// The sample behaves like the full trace seen by a cache rate times smaller.
+template <typename key_t>
+class SpatialSampler
+{
+private:
+    static constexpr std::uint64_t MODULUS = 1ULL << 24;
+
+    std::uint64_t threshold_;
+
+    static inline std::uint64_t mix(const key_t &key)
+    {
+        // seeded apart from the shard and index hashes, so the sample does
+        // not line up with how the caches partition keys
+        std::uint64_t h = static_cast<std::uint64_t>(std::hash<key_t>()(key)) + 0x5851F42D4C957F2DULL;
+        h ^= h >> 30;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27;
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+public:
+    explicit SpatialSampler(double rate)
+             : threshold_(static_cast<std::uint64_t>(std::llround(rate * static_cast<double>(MODULUS))))
+    {
+        if (threshold_ == 0)       threshold_ = 1;
+        if (threshold_ > MODULUS)  threshold_ = MODULUS;
+    }
+
+    // the rate actually applied after rounding to the threshold grid
+    inline double rate() const { return static_cast<double>(threshold_) / static_cast<double>(MODULUS); }
+
+    inline bool sampled(const key_t &key) const { return (mix(key) & (MODULUS - 1)) < threshold_; }
+
+    // capacity of the cache that sees the sample, at least one entry
+    inline ssize_t scale_capacity(ssize_t capacity) const
+    {
+        ssize_t scaled = static_cast<ssize_t>(std::llround(static_cast<double>(capacity) * rate()));
+        return scaled > 0 ? scaled : 1;
+    }
+
+    template <typename item_t>
+    std::vector<std::pair<key_t, item_t>> sample(const RequestSpan<key_t, item_t> &requests) const
+    {
+        std::vector<std::pair<key_t, item_t>> sampled_requests;
+        sampled_requests.reserve(static_cast<std::size_t>(static_cast<double>(requests.size()) * rate() * 1.25) + 16);
+
+        for (std::size_t i = 0; i < requests.size(); i++)
+            if (sampled(requests.key(i)))
+                sampled_requests.emplace_back(requests.key(i), requests.item(i));
+
+        return sampled_requests;
+    }
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SPIN_LOCK_HPP
+#define SPIN_LOCK_HPP
+
+#include <atomic>
+#include <thread>
+
+// test-and-test-and-set lock for short critical sections; it yields after
+// a while so an oversubscribed box does not burn the holder's time slice
+class SpinLock
+{
+private:
+    static constexpr int SPINS_BEFORE_YIELD = 64;
+
+    std::atomic<bool> locked_;
+
+    static inline void cpu_relax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+public:
+    SpinLock() : locked_(false) {}
+
+    SpinLock(const SpinLock &) = delete;
+    SpinLock &operator=(const SpinLock &) = delete;
+
+    void lock()
+    {
+        for (;;)
+        {
+            if (!locked_.exchange(true, std::memory_order_acquire))
+                return;
+
+            for (int spins = 0; locked_.load(std::memory_order_relaxed); spins++)
+            {
+                if (spins < SPINS_BEFORE_YIELD) cpu_relax();
+                else                            std::this_thread::yield();
+            }
+        }
+    }
+
+    inline bool try_lock()
+    {
+        return !locked_.load(std::memory_order_relaxed) &&
+               !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    inline void unlock() { locked_.store(false, std::memory_order_release); }
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Counter with a single writer and any number of readers. The writer adds
+// with a relaxed load and store instead of a locked read-modify-write, so
+// counting costs the same as a plain increment; readers never see a torn
+// value. Writers must be serialized by the caller (the cache or shard lock).
+class RelaxedCounter
+{
+private:
+    std::atomic<std::uint64_t> value_;
+
+public:
+    RelaxedCounter() : value_(0) {}
+
+    RelaxedCounter(const RelaxedCounter &) = delete;
+    RelaxedCounter &operator=(const RelaxedCounter &) = delete;
+
+    inline void add(std::uint64_t amount = 1)
+    {
+        value_.store(value_.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    inline void raise_to(std::uint64_t value)
+    {
+        if (value > value_.load(std::memory_order_relaxed))
+            value_.store(value, std::memory_order_relaxed);
+    }
+
+    inline std::uint64_t get() const { return value_.load(std::memory_order_relaxed); }
+};
+
+// Log-linear histogram in the spirit of HdrHistogram: values below
+// 2 * SUB_BUCKETS get a bucket each, above that every power of two is split
+// into SUB_BUCKETS equal buckets, so any recorded value is known within
+// 1 / SUB_BUCKETS of itself over the whole 64-bit range.
+class LatencyHistogram
+{
+private:
+    static constexpr unsigned    SUB_BITS    = 4;
+    static constexpr std::size_t SUB_BUCKETS = std::size_t(1) << SUB_BITS;
+    static constexpr std::size_t BUCKETS     = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    RelaxedCounter buckets_[BUCKETS];
+    RelaxedCounter count_;
+    RelaxedCounter sum_;
+    RelaxedCounter max_;
+
+    static inline std::size_t bucket_of(std::uint64_t value)
+    {
+        if (value < 2 * SUB_BUCKETS)
+            return static_cast<std::size_t>(value);
+
+        const unsigned msb   = 63u - static_cast<unsigned>(__builtin_clzll(value));
+        const unsigned shift = msb - SUB_BITS;
+
+        return shift * SUB_BUCKETS + static_cast<std::size_t>(value >> shift);
+    }
+
+    // largest value that lands in the bucket
+    static inline std::uint64_t bucket_top(std::size_t bucket)
+    {
+        if (bucket < 2 * SUB_BUCKETS)
+            return bucket;
+
+        const unsigned      shift = static_cast<unsigned>(bucket / SUB_BUCKETS) - 1;
+        const std::uint64_t sub   = bucket % SUB_BUCKETS + SUB_BUCKETS;
+
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    inline void record(std::uint64_t value)
+    {
+        buckets_[bucket_of(value)].add();
+        count_.add();
+        sum_.add(value);
+        max_.raise_to(value);
+    }
+
+    void merge(const LatencyHistogram &other)
+    {
+        for (std::size_t i = 0; i < BUCKETS; i++)
+            if (other.buckets_[i].get() != 0)
+                buckets_[i].add(other.buckets_[i].get());
+
+        count_.add(other.count_.get());
+        sum_.add(other.sum_.get());
+        max_.raise_to(other.max_.get());
+    }
+
+    inline std::uint64_t count() const { return count_.get(); }
+    inline std::uint64_t sum()   const { return sum_.get(); }
+    inline std::uint64_t max()   const { return max_.get(); }
+
+    inline double mean() const
+    {
+        return count() ? static_cast<double>(sum()) / static_cast<double>(count()) : 0.0;
+    }
+
+    // smallest bucket top with at least quantile of the values at or below it
+    std::uint64_t value_at_quantile(double quantile) const
+    {
+        const std::uint64_t total = count();
+        if (total == 0) return 0;
+
+        std::uint64_t rank = static_cast<std::uint64_t>(quantile * static_cast<double>(total) + 0.5);
+        if (rank < 1)     rank = 1;
+        if (rank > total) rank = total;
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKETS; i++)
+        {
+            seen += buckets_[i].get();
+            if (seen >= rank)
+                return bucket_top(i) < max() ? bucket_top(i) : max();
+        }
+
+        return max();
+    }
+};
+
+#endif
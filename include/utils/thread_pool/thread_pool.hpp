@@ -0,0 +1,93 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of workers over one FIFO of tasks. submit() hands back a future
+// for the task result; the destructor finishes every queued task first.
+class ThreadPool
+{
+private:
+    std::vector<std::thread>          workers_;
+    std::deque<std::function<void()>> tasks_;
+    bool                              stopping_;
+    std::mutex                        mutex_;
+    std::condition_variable           has_task_;
+
+    void work()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> guard(mutex_);
+                has_task_.wait(guard, [this]() { return stopping_ || !tasks_.empty(); });
+
+                if (tasks_.empty()) return;
+
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+
+            task();
+        }
+    }
+
+public:
+    explicit ThreadPool(std::size_t threads_amount) : workers_(), tasks_(), stopping_(false)
+    {
+        if (threads_amount == 0)
+            threads_amount = std::max(1u, std::thread::hardware_concurrency());
+
+        workers_.reserve(threads_amount);
+        for (std::size_t i = 0; i < threads_amount; i++)
+            workers_.emplace_back([this]() { work(); });
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stopping_ = true;
+        }
+
+        has_task_.notify_all();
+        for (auto &worker : workers_)
+            worker.join();
+    }
+
+    inline std::size_t size() const { return workers_.size(); }
+
+    template <typename func_t>
+    auto submit(func_t &&func) -> std::future<typename std::invoke_result<func_t>::type>
+    {
+        using result_t = typename std::invoke_result<func_t>::type;
+
+        // std::function needs a copyable target, the packaged task is not
+        auto task = std::make_shared<std::packaged_task<result_t()>>(std::forward<func_t>(func));
+        std::future<result_t> result = task->get_future();
+
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            tasks_.emplace_back([task]() { (*task)(); });
+        }
+
+        has_task_.notify_one();
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef TIMING_WHEEL_HPP
+#define TIMING_WHEEL_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "ARC/NodeSlab.hpp"
+
+// Hierarchical timing wheel over a fixed range of timer ids, laid out after
+// William Ahern's timeout.c: LEVELS wheels of SLOTS slots, each level SLOTS
+// times coarser than the one below. schedule() and cancel() are O(1).
+// advance() takes every slot the clock passed over and schedules its timers
+// again against the new time, so a timer moves down at most LEVELS times
+// before it is due; due timers wait on the expired list for pop_expired().
+//
+// Ids are not allocated here: the owner passes its own indices (the node
+// indices of a cache), and the timers live in a NodeSlab that is only ever
+// linked and unlinked, never acquired from.
+class TimingWheel
+{
+public:
+    using id_t   = std::uint32_t;
+    using tick_t = std::uint64_t;
+
+    static constexpr id_t NIL = UINT32_MAX;
+
+private:
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr unsigned SLOTS     = 1u << SLOT_BITS;
+    static constexpr unsigned LEVELS    = 4;
+
+    static constexpr tick_t SLOT_MASK   = SLOTS - 1;
+    static constexpr tick_t MAX_TIMEOUT = (tick_t(1) << (SLOT_BITS * LEVELS)) - 1;
+
+    static constexpr std::uint16_t NOT_SCHEDULED = UINT16_MAX;
+    static constexpr std::uint16_t EXPIRED       = UINT16_MAX - 1;
+
+    struct Timer
+    {
+        tick_t        deadline = 0;
+        std::uint16_t bucket   = NOT_SCHEDULED;
+    };
+
+    using SlabType = NodeSlab<Timer>;
+    using ListType = typename SlabType::IndexList;
+
+    SlabType      timers_;
+    ListType      wheel_[LEVELS][SLOTS];
+    std::uint64_t occupied_[LEVELS];
+    ListType      expired_;
+    std::size_t   pending_;
+    tick_t        now_;
+
+    static inline std::uint64_t rotl(std::uint64_t value, unsigned shift)
+    {
+        shift &= 63;
+        return shift ? (value << shift) | (value >> (64 - shift)) : value;
+    }
+
+    static inline std::uint64_t rotr(std::uint64_t value, unsigned shift)
+    {
+        shift &= 63;
+        return shift ? (value >> shift) | (value << (64 - shift)) : value;
+    }
+
+    // the level is picked by how far away the deadline is; timers above
+    // level 0 go one slot early, so they move down before they are due
+    void place(id_t id)
+    {
+        Timer &timer = timers_[id];
+
+        if (timer.deadline <= now_)
+        {
+            timer.bucket = EXPIRED;
+            timers_.push_front(expired_, id);
+            return;
+        }
+
+        const tick_t   remaining = std::min(timer.deadline - now_, MAX_TIMEOUT);
+        const unsigned level     = static_cast<unsigned>(63 - __builtin_clzll(remaining)) / SLOT_BITS;
+        const unsigned slot      = static_cast<unsigned>(
+            ((timer.deadline >> (level * SLOT_BITS)) - (level != 0)) & SLOT_MASK);
+
+        timer.bucket = static_cast<std::uint16_t>(level * SLOTS + slot);
+        timers_.push_front(wheel_[level][slot], id);
+        occupied_[level] |= std::uint64_t(1) << slot;
+        pending_++;
+    }
+
+    void unlink(id_t id)
+    {
+        Timer &timer = timers_[id];
+
+        if (timer.bucket == EXPIRED)
+            timers_.unlink(expired_, id);
+        else
+        {
+            const unsigned level = timer.bucket / SLOTS;
+            const unsigned slot  = timer.bucket % SLOTS;
+
+            timers_.unlink(wheel_[level][slot], id);
+            if (wheel_[level][slot].empty())
+                occupied_[level] &= ~(std::uint64_t(1) << slot);
+
+            pending_--;
+        }
+
+        timer.bucket = NOT_SCHEDULED;
+    }
+
+public:
+    explicit TimingWheel() : timers_(), wheel_(), occupied_(), expired_(), pending_(0), now_(0) {}
+
+    explicit TimingWheel(std::size_t max_timers) : TimingWheel()
+    {
+        reserve(max_timers);
+    }
+
+    // ids run from 0 to max_timers - 1
+    inline void reserve(std::size_t max_timers) { timers_.reserve(max_timers); }
+
+    inline tick_t now() const { return now_; }
+
+    // timers still in the wheel, not counting the expired list
+    inline std::size_t pending() const { return pending_; }
+
+    inline bool scheduled(id_t id) const { return timers_[id].bucket != NOT_SCHEDULED; }
+    inline bool expired(id_t id)   const { return timers_[id].bucket == EXPIRED; }
+
+    inline tick_t deadline(id_t id) const { return timers_[id].deadline; }
+
+    // a deadline at or before now() goes straight to the expired list
+    void schedule(id_t id, tick_t deadline)
+    {
+        if (scheduled(id)) unlink(id);
+
+        timers_[id].deadline = deadline;
+        place(id);
+    }
+
+    inline void cancel(id_t id)
+    {
+        if (scheduled(id)) unlink(id);
+    }
+
+    // moves the clock to now and every timer due by then to the expired
+    // list. The cost is O(LEVELS) plus the timers of the slots passed over,
+    // however far the clock jumps
+    void advance(tick_t now)
+    {
+        if (now <= now_) return;
+
+        tick_t   elapsed = now - now_;
+        ListType todo;
+
+        for (unsigned level = 0; level < LEVELS; level++)
+        {
+            const unsigned shift = level * SLOT_BITS;
+            std::uint64_t  passed;
+
+            if ((elapsed >> shift) > SLOT_MASK)
+                passed = ~std::uint64_t(0);
+            else
+            {
+                const unsigned steps    = static_cast<unsigned>((elapsed >> shift) & SLOT_MASK);
+                const unsigned old_slot = static_cast<unsigned>((now_ >> shift) & SLOT_MASK);
+                const unsigned new_slot = static_cast<unsigned>((now  >> shift) & SLOT_MASK);
+
+                const std::uint64_t run = (std::uint64_t(1) << steps) - 1;
+
+                passed  = rotl(run, old_slot);
+                passed |= rotr(rotl(run, new_slot), steps);
+                passed |= std::uint64_t(1) << new_slot;
+            }
+
+            for (std::uint64_t due = passed & occupied_[level]; due != 0; due &= due - 1)
+            {
+                ListType &slot = wheel_[level][__builtin_ctzll(due)];
+                while (!slot.empty())
+                {
+                    const id_t id = timers_.pop_back(slot);
+                    timers_.push_front(todo, id);
+                    pending_--;
+                }
+            }
+
+            occupied_[level] &= ~passed;
+
+            // slot 0 was not passed, so this level did not wrap around and
+            // the levels above did not move
+            if ((passed & 1) == 0) break;
+
+            elapsed = std::max<tick_t>(elapsed, tick_t(SLOTS) << shift);
+        }
+
+        now_ = now;
+
+        while (!todo.empty())
+            place(timers_.pop_back(todo));
+    }
+
+    // oldest due timer first, NIL when none is due
+    inline id_t pop_expired()
+    {
+        if (expired_.empty()) return NIL;
+
+        const id_t id = timers_.pop_back(expired_);
+        timers_[id].bucket = NOT_SCHEDULED;
+        return id;
+    }
+};
+
+#endif
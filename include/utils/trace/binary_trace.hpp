@@ -0,0 +1,232 @@
+#ifndef BINARY_TRACE_HPP
+#define BINARY_TRACE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../log_config/log_config.hpp"
+#include "../../RequestSpan.hpp"
+
+// Binary trace layout (native byte order):
+//
+//   TraceHeader, padded to TRACE_ALIGNMENT bytes
+//   key column:  count * key_width bytes, padded to TRACE_ALIGNMENT
+//   item column: count * item_width bytes, only when TRACE_HAS_ITEMS is set
+//
+// Columns are aligned, so a mapped file is handed to the caches as a
+// RequestSpan straight over the mapping.
+
+static constexpr char          TRACE_MAGIC[8]  = {'A', 'R', 'C', 'T', 'R', 'A', 'C', 'E'};
+static constexpr std::uint32_t TRACE_VERSION   = 1;
+static constexpr std::uint32_t TRACE_HAS_ITEMS = 1u << 0;
+static constexpr std::size_t   TRACE_ALIGNMENT = 64;
+
+struct TraceHeader
+{
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint32_t key_width;
+    std::uint32_t item_width;
+    std::uint64_t count;
+    std::uint64_t capacity;     // capacity the text input came with, 0 if none
+};
+
+static_assert(sizeof(TraceHeader) <= TRACE_ALIGNMENT, "trace header outgrew its padding");
+
+inline std::size_t trace_align_up(std::size_t size)
+{
+    return (size + TRACE_ALIGNMENT - 1) / TRACE_ALIGNMENT * TRACE_ALIGNMENT;
+}
+
+template <typename key_t, typename item_t>
+bool write_binary_trace(const std::string &path, const RequestSpan<key_t, item_t> &requests,
+                        std::uint64_t capacity, bool with_items)
+{
+    static_assert(std::is_trivially_copyable<key_t>::value &&
+                  std::is_trivially_copyable<item_t>::value, "binary traces store raw keys and items");
+
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        LOG_ERROR("Binary trace", "CAN NOT OPEN FOR WRITING: ", path);
+        return false;
+    }
+
+    TraceHeader header{};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version    = TRACE_VERSION;
+    header.flags      = with_items ? TRACE_HAS_ITEMS : 0;
+    header.key_width  = sizeof(key_t);
+    header.item_width = with_items ? sizeof(item_t) : 0;
+    header.count      = requests.size();
+    header.capacity   = capacity;
+
+    const char padding[TRACE_ALIGNMENT] = {};
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(padding, TRACE_ALIGNMENT - sizeof(header), 1, file) == 1;
+
+    for (std::size_t i = 0; ok && i < requests.size(); i++)
+        ok = std::fwrite(&requests.key(i), sizeof(key_t), 1, file) == 1;
+
+    const std::size_t key_column = requests.size() * sizeof(key_t);
+    if (ok && trace_align_up(key_column) != key_column)
+        ok = std::fwrite(padding, trace_align_up(key_column) - key_column, 1, file) == 1;
+
+    for (std::size_t i = 0; ok && with_items && i < requests.size(); i++)
+    {
+        const item_t item = requests.item(i);
+        ok = std::fwrite(&item, sizeof(item_t), 1, file) == 1;
+    }
+
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok)
+        LOG_ERROR("Binary trace", "WRITE FAILED: ", path);
+
+    return ok;
+}
+
+// Read-only mapping of a binary trace. Nothing is copied: requests() views
+// the key and item columns inside the mapping.
+template <typename key_t, typename item_t>
+class MappedTrace
+{
+    static_assert(std::is_trivially_copyable<key_t>::value &&
+                  std::is_trivially_copyable<item_t>::value, "binary traces store raw keys and items");
+
+private:
+    void         *data_;
+    std::size_t   length_;
+    TraceHeader   header_;
+
+    void unmap()
+    {
+        if (data_ != nullptr)
+            munmap(data_, length_);
+
+        data_   = nullptr;
+        length_ = 0;
+    }
+
+    bool validate(const std::string &path) const
+    {
+        if (std::memcmp(header_.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+            header_.version != TRACE_VERSION)
+        {
+            LOG_ERROR("Binary trace", "NOT A TRACE FILE (or unknown version): ", path);
+            return false;
+        }
+
+        if (header_.key_width != sizeof(key_t) ||
+            ((header_.flags & TRACE_HAS_ITEMS) && header_.item_width != sizeof(item_t)))
+        {
+            LOG_ERROR("Binary trace", "KEY/ITEM WIDTH MISMATCH in ", path,
+                                      "\nkey width: ", header_.key_width, " item width: ", header_.item_width);
+            return false;
+        }
+
+        // every request takes a key, and an item when there are items; this
+        // also keeps the sizes below from overflowing on a corrupt count
+        if (header_.count > length_ / header_.key_width ||
+            ((header_.flags & TRACE_HAS_ITEMS) && header_.count > length_ / header_.item_width))
+        {
+            LOG_ERROR("Binary trace", "TRUNCATED FILE: ", path, "\nsize: ", length_, " requests: ", header_.count);
+            return false;
+        }
+
+        std::size_t expected = TRACE_ALIGNMENT + trace_align_up(header_.count * header_.key_width);
+        if (header_.flags & TRACE_HAS_ITEMS)
+            expected += header_.count * header_.item_width;
+
+        if (length_ < expected)
+        {
+            LOG_ERROR("Binary trace", "TRUNCATED FILE: ", path, "\nsize: ", length_, " expected: ", expected);
+            return false;
+        }
+
+        return true;
+    }
+
+public:
+    MappedTrace() : data_(nullptr), length_(0), header_() {}
+
+    MappedTrace(const MappedTrace &) = delete;
+    MappedTrace &operator=(const MappedTrace &) = delete;
+
+    ~MappedTrace() { unmap(); }
+
+    bool open(const std::string &path)
+    {
+        unmap();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            LOG_ERROR("Binary trace", "CAN NOT OPEN: ", path);
+            return false;
+        }
+
+        struct stat file_stat{};
+        if (fstat(fd, &file_stat) != 0 || static_cast<std::size_t>(file_stat.st_size) < TRACE_ALIGNMENT)
+        {
+            LOG_ERROR("Binary trace", "FILE IS TOO SMALL: ", path);
+            ::close(fd);
+            return false;
+        }
+
+        length_ = static_cast<std::size_t>(file_stat.st_size);
+        data_   = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if (data_ == MAP_FAILED)
+        {
+            LOG_ERROR("Binary trace", "MMAP FAILED: ", path);
+            data_ = nullptr;
+            length_ = 0;
+            return false;
+        }
+
+        // replay walks the columns front to back
+        madvise(data_, length_, MADV_SEQUENTIAL);
+
+        std::memcpy(&header_, data_, sizeof(header_));
+        if (!validate(path))
+        {
+            unmap();
+            return false;
+        }
+
+        return true;
+    }
+
+    inline bool is_open() const { return data_ != nullptr; }
+
+    inline const TraceHeader &header() const { return header_; }
+
+    inline std::uint64_t capacity() const { return header_.capacity; }
+
+    RequestSpan<key_t, item_t> requests() const
+    {
+        if (data_ == nullptr) return RequestSpan<key_t, item_t>();
+
+        const unsigned char *base = static_cast<const unsigned char *>(data_);
+        const key_t  *keys  = reinterpret_cast<const key_t *>(base + TRACE_ALIGNMENT);
+        const item_t *items = nullptr;
+
+        if (header_.flags & TRACE_HAS_ITEMS)
+            items = reinterpret_cast<const item_t *>(base + TRACE_ALIGNMENT +
+                                                     trace_align_up(header_.count * header_.key_width));
+
+        return RequestSpan<key_t, item_t>(keys, items, header_.count);
+    }
+};
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef WORKLOAD_HPP
+#define WORKLOAD_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Synthetic request streams for benchmarks. Every generator is seeded, so
+// a given set of parameters always yields the same trace; items equal keys
+// like in CacheDriver::generate_requests.
+namespace workload
+{
+
+using request_t = std::pair<ssize_t, ssize_t>;
+using trace_t   = std::vector<request_t>;
+
+// draws ranks 0..universe-1 with P(rank) ~ 1 / (rank + 1)^skew through a
+// cumulative table, so skew may be anything >= 0
+class ZipfSampler
+{
+private:
+    std::vector<double> cumulative_;
+
+public:
+    ZipfSampler(std::size_t universe, double skew) : cumulative_(universe > 0 ? universe : 1)
+    {
+        double sum = 0.0;
+        for (std::size_t rank = 0; rank < cumulative_.size(); rank++)
+        {
+            sum += 1.0 / std::pow(static_cast<double>(rank + 1), skew);
+            cumulative_[rank] = sum;
+        }
+
+        for (double &value : cumulative_)
+            value /= sum;
+    }
+
+    template <typename rng_t>
+    std::size_t operator()(rng_t &rng) const
+    {
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        const auto rank = std::lower_bound(cumulative_.begin(), cumulative_.end(), u);
+
+        return std::min<std::size_t>(static_cast<std::size_t>(rank - cumulative_.begin()), cumulative_.size() - 1);
+    }
+};
+
+// popular keys are scattered over the key space rather than 0, 1, 2...
+inline ssize_t scatter(std::size_t rank)
+{
+    std::uint64_t h = static_cast<std::uint64_t>(rank) + 1;
+    h *= 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 29;
+    return static_cast<ssize_t>(h & 0x7FFFFFFFFFFFULL);
+}
+
+inline trace_t zipf(std::size_t length, std::size_t universe, double skew, std::uint64_t seed = 1)
+{
+    std::mt19937_64 rng(seed);
+    ZipfSampler sampler(universe, skew);
+
+    trace_t trace;
+    trace.reserve(length);
+
+    for (std::size_t i = 0; i < length; i++)
+    {
+        const ssize_t key = scatter(sampler(rng));
+        trace.emplace_back(key, key);
+    }
+
+    return trace;
+}
+
+// a loop over loop_size keys repeated back to back, with a one-time scan of
+// scan_size never seen keys after every loop_repeats loops. A loop just
+// larger than the cache is the classic LRU worst case.
+inline trace_t scan_loop(std::size_t length, std::size_t loop_size, std::size_t scan_size,
+                         std::size_t loop_repeats = 4)
+{
+    trace_t trace;
+    trace.reserve(length);
+
+    ssize_t next_scan_key = static_cast<ssize_t>(loop_size);
+    while (trace.size() < length)
+    {
+        for (std::size_t loop = 0; loop < loop_repeats && trace.size() < length; loop++)
+            for (std::size_t i = 0; i < loop_size && trace.size() < length; i++)
+                trace.emplace_back(static_cast<ssize_t>(i), static_cast<ssize_t>(i));
+
+        for (std::size_t i = 0; i < scan_size && trace.size() < length; i++, next_scan_key++)
+            trace.emplace_back(next_scan_key, next_scan_key);
+    }
+
+    return trace;
+}
+
+// Zipf over a working set of set_size keys that moves to fresh keys every
+// phase_length requests; overlap is the share kept from the previous phase
+inline trace_t shifting_working_set(std::size_t length, std::size_t set_size, std::size_t phase_length,
+                                    double overlap = 0.5, double skew = 0.8, std::uint64_t seed = 2)
+{
+    std::mt19937_64 rng(seed);
+    ZipfSampler sampler(set_size, skew);
+
+    const std::size_t shift = std::max<std::size_t>(1, static_cast<std::size_t>(set_size * (1.0 - overlap)));
+
+    trace_t trace;
+    trace.reserve(length);
+
+    std::size_t base = 0;
+    for (std::size_t i = 0; i < length; i++)
+    {
+        if (i != 0 && i % phase_length == 0)
+            base += shift;
+
+        const ssize_t key = scatter(base + sampler(rng));
+        trace.emplace_back(key, key);
+    }
+
+    return trace;
+}
+
+// the ARC paper's motivating mix: a Zipf hot set that recency-only and
+// frequency-only policies each handle, cut by long one-time sequential
+// scans that flush a plain LRU
+inline trace_t arc_scan(std::size_t length, std::size_t hot_set, std::size_t scan_size,
+                        std::size_t scan_period, std::uint64_t seed = 3)
+{
+    std::mt19937_64 rng(seed);
+    ZipfSampler sampler(hot_set, 0.9);
+
+    trace_t trace;
+    trace.reserve(length);
+
+    ssize_t next_scan_key = -1;
+    while (trace.size() < length)
+    {
+        for (std::size_t i = 0; i < scan_period && trace.size() < length; i++)
+        {
+            const ssize_t key = scatter(sampler(rng));
+            trace.emplace_back(key, key);
+        }
+
+        for (std::size_t i = 0; i < scan_size && trace.size() < length; i++, next_scan_key--)
+            trace.emplace_back(next_scan_key, next_scan_key);
+    }
+
+    return trace;
+}
+
+// alternates a recency phase (uniform reuse of a small recent window) and a
+// frequency phase (Zipf over a large set), so the best split between T1
+// and T2 keeps moving and only an adaptive policy follows it
+inline trace_t arc_phases(std::size_t length, std::size_t recent_window, std::size_t frequent_set,
+                          std::size_t phase_length, std::uint64_t seed = 4)
+{
+    std::mt19937_64 rng(seed);
+    ZipfSampler sampler(frequent_set, 1.0);
+
+    trace_t trace;
+    trace.reserve(length);
+
+    ssize_t next_new_key = -1;
+    for (std::size_t i = 0; i < length; i++)
+    {
+        const bool recency_phase = (i / phase_length) % 2 == 0;
+        ssize_t key = 0;
+
+        if (!recency_phase)
+            key = scatter(sampler(rng));
+        else if (rng() % 4 == 0 || static_cast<std::size_t>(-next_new_key) <= recent_window)
+            key = next_new_key--;
+        else
+            key = next_new_key + 1 + static_cast<ssize_t>(rng() % recent_window);
+
+        trace.emplace_back(key, key);
+    }
+
+    return trace;
+}
+
+// keys of tenant_mix carry their tenant in the bits above scatter()'s
+static constexpr unsigned TENANT_SHIFT = 47;
+
+inline std::size_t tenant_of(ssize_t key) { return static_cast<std::size_t>(key >> TENANT_SHIFT); }
+
+// tenants tenants interleaved in one stream. Tenant t gets a Zipf (0.8)
+// share of the requests and draws from its own Zipf over set_size << (t % 4)
+// keys, with a skew of 0.6, 0.9 or 1.2 by t % 3, so the tenants differ in
+// load and in how much cache they can put to use
+inline trace_t tenant_mix(std::size_t length, std::size_t tenants, std::size_t set_size, std::uint64_t seed = 5)
+{
+    std::mt19937_64 rng(seed);
+    ZipfSampler tenant_sampler(tenants, 0.8);
+
+    static constexpr double SKEWS[] = {0.6, 0.9, 1.2};
+
+    std::vector<ZipfSampler> samplers;
+    samplers.reserve(tenants);
+    for (std::size_t t = 0; t < tenants; t++)
+        samplers.emplace_back(set_size << (t % 4), SKEWS[t % 3]);
+
+    trace_t trace;
+    trace.reserve(length);
+
+    for (std::size_t i = 0; i < length; i++)
+    {
+        const std::size_t tenant = tenant_sampler(rng);
+        const ssize_t     key    = static_cast<ssize_t>(tenant) << TENANT_SHIFT | scatter(samplers[tenant](rng));
+
+        trace.emplace_back(key, key);
+    }
+
+    return trace;
+}
+
+} // namespace workload
+
+#endif
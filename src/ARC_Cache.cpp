@@ -1,26 +1,310 @@
 #include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
 
 #include "../include/ARC/ARC_Cache.hpp"
+#include "../include/ARC/ShardedARC_Cache.hpp"
+#include "../include/ARC/BatchedARC_Cache.hpp"
+#include "../include/ARC/CAR_Cache.hpp"
+#include "../include/ARC/WeightedARC_Cache.hpp"
+#include "../include/ARC/ARC_Snapshot.hpp"
+#include "../include/ARC/TieredARC_Cache.hpp"
+#include "../include/ARC/MultiTenantARC_Cache.hpp"
+#include "../include/optimal/optimal_cache.hpp"
+#include "../include/LRU/LRU_Cache.hpp"
+#include "../include/LRU/LRU_ListCache.hpp"
+#include "../include/TwoQ/TwoQ_Cache.hpp"
+#include "../include/LIRS/LIRS_Cache.hpp"
+#include "../include/ClockPro/ClockPro_Cache.hpp"
+#include "../include/TinyLFU/TinyLFU_Cache.hpp"
 #include "../include/utils/driver/driver.hpp"
 
+static std::vector<ssize_t> parse_capacities(const std::string &list)
+{
+    std::vector<ssize_t> capacities;
+    std::stringstream stream(list);
+
+    for (std::string capacity; std::getline(stream, capacity, ','); )
+        if (!capacity.empty())
+            capacities.push_back(std::stoll(capacity));
 
-int main()
+    return capacities;
+}
+
+int main(int argc, char *argv[])
 {
-    HtmlLogger::init("arc_cache_log");
+    log_open("arc_cache_log");
 
     LOG_INFO("DOLBAEB", "HELLO\n", 5);
 
     ssize_t capacity = 0;
     ssize_t amount_numbers = 0;
     
-    std::cin >> capacity >> amount_numbers;
+    ssize_t threads_amount = 0;
+    ssize_t shards_amount  = 0;
+    bool    batched        = false;
+    bool    streaming      = false;
+    ssize_t batch_size     = 0;
+
+    std::string trace_path;
+    std::string csv_path;
+    std::string stats_format;
+
+    std::vector<ssize_t> sweep_capacities;
+    double sample_rate = 0.0;
+    bool   exact       = false;
+    bool   compare     = false;
+    bool   weighted    = false;
+    bool   memory      = false;
+
+    ssize_t load_us = -1;
+
+    std::string save_snapshot_path;
+    std::string restore_snapshot_path;
+
+    std::string l2_path;
+    ssize_t     l2_bytes  = 64 << 20;
+    bool        direct_io = false;
+
+    ssize_t tenants_amount   = 0;
+    ssize_t rebalance_period = MultiTenantARCCache<ssize_t, ssize_t>::STD_REBALANCE_PERIOD;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+
+        if      (option == "--threads" && i + 1 < argc) threads_amount = std::stoll(argv[++i]);
+        else if (option == "--shards"  && i + 1 < argc) shards_amount  = std::stoll(argv[++i]);
+        else if (option == "--batched")                 batched        = true;
+        else if (option == "--trace"   && i + 1 < argc) trace_path     = argv[++i];
+        else if (option == "--capacity" && i + 1 < argc) capacity      = std::stoll(argv[++i]);
+        else if (option == "--stream")                   streaming     = true;
+        else if (option == "--batch"   && i + 1 < argc) batch_size     = std::stoll(argv[++i]);
+        else if (option == "--sweep"   && i + 1 < argc) sweep_capacities = parse_capacities(argv[++i]);
+        else if (option == "--csv"     && i + 1 < argc) csv_path       = argv[++i];
+        else if (option == "--sample"  && i + 1 < argc) sample_rate    = std::stod(argv[++i]);
+        else if (option == "--exact")                   exact          = true;
+        else if (option == "--compare")                 compare        = true;
+        else if (option == "--stats"   && i + 1 < argc) stats_format   = argv[++i];
+        else if (option == "--bytes")                   weighted       = true;
+        else if (option == "--memory")                  memory         = true;
+        else if (option == "--load-us" && i + 1 < argc) load_us        = std::stoll(argv[++i]);
+        else if (option == "--save-snapshot"    && i + 1 < argc) save_snapshot_path    = argv[++i];
+        else if (option == "--restore-snapshot" && i + 1 < argc) restore_snapshot_path = argv[++i];
+        else if (option == "--l2-file"  && i + 1 < argc) l2_path   = argv[++i];
+        else if (option == "--l2-bytes" && i + 1 < argc) l2_bytes  = std::stoll(argv[++i]);
+        else if (option == "--direct")                   direct_io = true;
+        else if (option == "--tenants"   && i + 1 < argc) tenants_amount   = std::stoll(argv[++i]);
+        else if (option == "--rebalance" && i + 1 < argc) rebalance_period = std::stoll(argv[++i]);
+    }
 
     CacheDriver<ssize_t, ssize_t> driver;
-    auto arc_cache_requests = driver.generate_requests(amount_numbers);
+    RequestSpan<ssize_t, ssize_t> arc_cache_requests;
+
+    // text input is simulated while it is still being read
+    if (streaming && trace_path.empty() && threads_amount <= 0)
+    {
+        ssize_t input_capacity = 0;
+        std::cin >> input_capacity >> amount_numbers;
+        if (capacity == 0) capacity = input_capacity;
+
+        ARCCache<ssize_t, ssize_t> arc_cache(capacity);
+        if (batch_size > 0) driver.run_cache_streaming(arc_cache, amount_numbers, batch_size);
+        else                driver.run_cache_streaming(arc_cache, amount_numbers);
+
+        log_close();
+        return 0;
+    }
+
+    if (!trace_path.empty())
+    {
+        arc_cache_requests = driver.map_trace(trace_path);
+        if (capacity == 0) capacity = driver.trace_capacity();
+    }
+    else
+    {
+        ssize_t input_capacity = 0;
+        std::cin >> input_capacity >> amount_numbers;
+        if (capacity == 0) capacity = input_capacity;
+
+        arc_cache_requests = weighted ? driver.generate_sized_requests(amount_numbers)
+                                      : driver.generate_requests(amount_numbers);
+    }
+
+    // capacity is in bytes and every item is the size of its object
+    if (weighted)
+    {
+        using size_cost = ItemSizeCost<ssize_t, ssize_t>;
+
+        WeightedARCCache<ssize_t, ssize_t, size_cost> weighted_cache(capacity);
+        OPT_cache<ssize_t, ssize_t> optimal_cache(capacity);
+
+        weighted_cache.run_cache(arc_cache_requests);
+        optimal_cache.run_cache_weighted(arc_cache_requests, size_cost());
+
+        driver.print_weighted_ratio("ARC", weighted_cache.get_hit_count(), weighted_cache.get_request_count(),
+                                    weighted_cache.get_byte_hit_count(), weighted_cache.get_byte_request_count());
+        driver.print_weighted_ratio("OPT", optimal_cache.get_hit_count(), optimal_cache.get_request_count(),
+                                    optimal_cache.get_byte_hit_count(), optimal_cache.get_byte_request_count());
+    }
+    else if (compare)
+    {
+        ARCCache<ssize_t, ssize_t>      arc_cache(capacity);
+        CARCache<ssize_t, ssize_t>      car_cache(capacity);
+        LRUListCache<ssize_t, ssize_t>  lru_cache(capacity);
+        TwoQCache<ssize_t, ssize_t>     two_q_cache(capacity);
+        LIRSCache<ssize_t, ssize_t>     lirs_cache(capacity);
+        ClockProCache<ssize_t, ssize_t> clock_pro_cache(capacity);
+        TinyLFUCache<ssize_t, ssize_t>  tiny_lfu_cache(capacity);
+        OPT_cache<ssize_t, ssize_t>     optimal_cache(capacity);
+
+        driver.compare_caches({{"ARC",       &arc_cache},
+                               {"CAR",       &car_cache},
+                               {"LRU",       &lru_cache},
+                               {"2Q",        &two_q_cache},
+                               {"LIRS",      &lirs_cache},
+                               {"CLOCK-Pro", &clock_pro_cache},
+                               {"W-TinyLFU", &tiny_lfu_cache},
+                               {"OPT",       &optimal_cache}}, arc_cache_requests);
+    }
+    else if (memory)
+    {
+        // full keys against 32-bit fingerprints in B1/B2, over the same index
+        ARCCache<ssize_t, ssize_t, FlatHashIndex, KeyGhosts>         key_ghosts_cache(capacity);
+        ARCCache<ssize_t, ssize_t, FlatHashIndex, FingerprintGhosts> fingerprint_ghosts_cache(capacity);
+
+        driver.compare_caches({{"key ghosts",   &key_ghosts_cache},
+                               {"fingerprints", &fingerprint_ghosts_cache}}, arc_cache_requests);
+
+        std::cout << "key ghosts, ";
+        key_ghosts_cache.print_memory_report();
+        std::cout << "fingerprints, ";
+        fingerprint_ghosts_cache.print_memory_report();
+    }
+    else if (!sweep_capacities.empty() && sample_rate > 0.0)
+    {
+        std::vector<CacheDriver<ssize_t, ssize_t>::sweep_policy_t> policies =
+        {
+            {"ARC", [](RequestSpan<ssize_t, ssize_t> requests, ssize_t sweep_capacity)
+                    {
+                        ARCCache<ssize_t, ssize_t> cache(sweep_capacity);
+                        return cache.run_cache(requests);
+                    }}
+        };
+
+        if (csv_path.empty())
+            driver.run_sampled_sweep(arc_cache_requests, sweep_capacities, policies, sample_rate, exact, threads_amount);
+        else
+        {
+            std::ofstream csv(csv_path);
+            driver.run_sampled_sweep(arc_cache_requests, sweep_capacities, policies, sample_rate, exact, threads_amount, csv);
+        }
+    }
+    else if (!sweep_capacities.empty())
+    {
+        // the next-use table depends on the trace only, every OPT run shares
+        // it; one stack-distance pass answers LRU for every capacity
+        std::vector<ssize_t> next_use;
+        OPT_cache<ssize_t, ssize_t>::build_next_use(arc_cache_requests, next_use);
+
+        LRUCache<ssize_t, ssize_t> lru_cache(sweep_capacities.front());
+        lru_cache.run_cache(arc_cache_requests);
+
+        std::vector<CacheDriver<ssize_t, ssize_t>::sweep_policy_t> policies =
+        {
+            {"ARC", [](RequestSpan<ssize_t, ssize_t> requests, ssize_t sweep_capacity)
+                    {
+                        ARCCache<ssize_t, ssize_t> cache(sweep_capacity);
+                        return cache.run_cache(requests);
+                    }},
+            {"OPT", [&next_use](RequestSpan<ssize_t, ssize_t>, ssize_t sweep_capacity)
+                    {
+                        OPT_cache<ssize_t, ssize_t> cache(sweep_capacity);
+                        return cache.run_cache(next_use);
+                    }},
+            {"LRU", [&lru_cache](RequestSpan<ssize_t, ssize_t>, ssize_t sweep_capacity)
+                    {
+                        return lru_cache.get_hit_count(sweep_capacity);
+                    }}
+        };
+
+        if (csv_path.empty())
+            driver.run_capacity_sweep(arc_cache_requests, sweep_capacities, policies, threads_amount);
+        else
+        {
+            std::ofstream csv(csv_path);
+            driver.run_capacity_sweep(arc_cache_requests, sweep_capacities, policies, threads_amount, csv);
+        }
+    }
+    else if (threads_amount > 0 && batched)
+    {
+        BatchedARCCache<ssize_t, ssize_t> batched_cache(capacity, (shards_amount > 0) ? shards_amount : 4 * threads_amount);
+        driver.run_cache_parallel(batched_cache, arc_cache_requests, threads_amount);
+
+        ARCCache<ssize_t, ssize_t> serial_cache(capacity);
+        driver.compare_hit_ratio(serial_cache, batched_cache, arc_cache_requests);
+    }
+    else if (!l2_path.empty())
+    {
+        // ARC in memory over a file-backed second tier of l2_bytes
+        TieredARCCache<ssize_t, ssize_t> tiered_cache(capacity, l2_path, static_cast<std::size_t>(std::max<ssize_t>(0, l2_bytes)),
+                                                      direct_io);
+        driver.run_cache(tiered_cache, arc_cache_requests);
+        tiered_cache.print_tier_report();
+    }
+    else if (tenants_amount > 0)
+    {
+        // keys hashed over tenants sharing capacity: the even split against
+        // capacity moved by ghost hits every rebalance_period requests
+        MultiTenantARCCache<ssize_t, ssize_t> static_cache(capacity, tenants_amount, 0);
+        MultiTenantARCCache<ssize_t, ssize_t> adaptive_cache(capacity, tenants_amount, rebalance_period);
+
+        driver.compare_caches({{"static",   &static_cache},
+                               {"adaptive", &adaptive_cache}}, arc_cache_requests);
+        adaptive_cache.print_tenant_report();
+    }
+    else if (load_us >= 0)
+    {
+        // read-through: every miss is a load of load_us microseconds
+        ShardedARCCache<ssize_t, ssize_t> sharded_cache(capacity, (shards_amount > 0) ? shards_amount : 4 * std::max<ssize_t>(1, threads_amount));
+        driver.run_read_through(sharded_cache, arc_cache_requests, std::max<ssize_t>(1, threads_amount),
+                                std::chrono::microseconds(load_us));
+    }
+    else if (threads_amount > 0 && !stats_format.empty())
+    {
+        ShardedARCCache<ssize_t, ssize_t, SpinLock, FlatHashIndex, ARCStats>
+            sharded_cache(capacity, (shards_amount > 0) ? shards_amount : 4 * threads_amount);
+        driver.run_cache_parallel(sharded_cache, arc_cache_requests, threads_amount);
+
+        ARCStats stats;
+        sharded_cache.collect_stats(stats);
+        driver.export_stats(stats, stats_format);
+    }
+    else if (threads_amount > 0)
+    {
+        ShardedARCCache<ssize_t, ssize_t> sharded_cache(capacity, (shards_amount > 0) ? shards_amount : 4 * threads_amount);
+        driver.run_cache_parallel(sharded_cache, arc_cache_requests, threads_amount);
+    }
+    else if (!stats_format.empty())
+    {
+        ARCCache<ssize_t, ssize_t, StdHashIndex, KeyGhosts, ARCStats> arc_cache(capacity);
+        driver.run_cache(arc_cache, arc_cache_requests);
+        driver.export_stats(arc_cache.stats(), stats_format);
+    }
+    else
+    {
+        // a warm run starts from the state an earlier run saved
+        ARCCache<ssize_t, ssize_t> arc_cache(capacity);
+        if (!restore_snapshot_path.empty() && !restore_arc_snapshot(restore_snapshot_path, arc_cache))
+            std::cerr << "can not restore " << restore_snapshot_path << ", starting cold" << std::endl;
+
+        driver.run_cache(arc_cache, arc_cache_requests);
 
-    ARCCache<ssize_t, ssize_t> arc_cache(capacity);
-    driver.run_cache(arc_cache, arc_cache_requests);
+        if (!save_snapshot_path.empty() && !save_arc_snapshot(save_snapshot_path, arc_cache))
+            std::cerr << "can not save " << save_snapshot_path << std::endl;
+    }
 
     LOG_INFO("DOLBAEB", "HELLO\n", 5);
-    HtmlLogger::close();
+    log_close();
 }
\ No newline at end of file
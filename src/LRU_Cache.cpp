@@ -0,0 +1,52 @@
+#include <vector>
+#include <string>
+
+#include "../include/LRU/LRU_Cache.hpp"
+#include "../include/utils/driver/driver.hpp"
+
+
+int main(int argc, char *argv[])
+{
+    log_open("lru_cache_log");
+
+    ssize_t capacity = 0;
+    ssize_t amount_numbers = 0;
+    ssize_t curve_capacity = 0;
+
+    std::string trace_path;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+
+        if      (option == "--trace"    && i + 1 < argc) trace_path     = argv[++i];
+        else if (option == "--capacity" && i + 1 < argc) capacity       = std::stoll(argv[++i]);
+        else if (option == "--curve"    && i + 1 < argc) curve_capacity = std::stoll(argv[++i]);
+    }
+
+    CacheDriver<ssize_t, ssize_t> driver;
+    RequestSpan<ssize_t, ssize_t> lru_cache_requests;
+
+    if (!trace_path.empty())
+    {
+        lru_cache_requests = driver.map_trace(trace_path);
+        if (capacity == 0) capacity = driver.trace_capacity();
+    }
+    else
+    {
+        ssize_t input_capacity = 0;
+        std::cin >> input_capacity >> amount_numbers;
+        if (capacity == 0) capacity = input_capacity;
+
+        lru_cache_requests = driver.generate_requests(amount_numbers);
+    }
+
+    LRUCache<ssize_t, ssize_t> lru_cache(capacity);
+    driver.run_cache(lru_cache, lru_cache_requests);
+
+    // the same pass already holds the answer for every other capacity
+    if (curve_capacity > 0)
+        lru_cache.print_curve(std::cout, static_cast<std::size_t>(curve_capacity));
+
+    log_close();
+}
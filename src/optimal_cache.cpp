@@ -1,24 +1,133 @@
+#include <algorithm>
+#include <chrono>
 #include <vector>
+#include <string>
+#include <sstream>
 
 #include "../include/optimal/optimal_cache.hpp"
 #include "../include/utils/driver/driver.hpp"
+#include "../include/utils/workload/workload.hpp"
 
+// requests of the synthetic trace --time replays when no --trace is given
+static constexpr ssize_t STD_TIMED_REQUESTS = 1 << 24;
 
-int main()
+static std::vector<ssize_t> parse_capacities(const std::string &list)
 {
-    HtmlLogger::init("optimal_cache_log");
+    std::vector<ssize_t> capacities;
+    std::stringstream stream(list);
+
+    for (std::string capacity; std::getline(stream, capacity, ','); )
+        if (!capacity.empty())
+            capacities.push_back(std::stoll(capacity));
+
+    return capacities;
+}
+
+// one full replay per capacity, next-use pass included. A replay is
+// O(N log C), so ns per request should grow with log C and not with C
+static void time_replays(RequestSpan<ssize_t, ssize_t> requests, const std::vector<ssize_t> &capacities)
+{
+    for (ssize_t capacity : capacities)
+    {
+        OPT_cache<ssize_t, ssize_t> optimal_cache(capacity);
+
+        auto start = std::chrono::steady_clock::now();
+        const ssize_t hits = optimal_cache.run_cache(requests);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "capacity: " << capacity << ", requests: " << requests.size() << ", hits: " << hits
+                  << ", time: " << elapsed.count() * 1e3 << " ms, ns per request: "
+                  << elapsed.count() * 1e9 / static_cast<double>(std::max<std::size_t>(1, requests.size()))
+                  << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    log_open("optimal_cache_log");
 
     ssize_t capacity = 0;
     ssize_t amount_numbers = 0;
     
-    std::cin >> capacity >> amount_numbers;
+    std::string trace_path;
+
+    bool    streaming  = false;
+    ssize_t batch_size = 0;
+    ssize_t lookahead  = 0;
+
+    std::vector<ssize_t> timed_capacities;
+    ssize_t timed_requests = STD_TIMED_REQUESTS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+
+        if      (option == "--trace"    && i + 1 < argc) trace_path = argv[++i];
+        else if (option == "--capacity" && i + 1 < argc) capacity   = std::stoll(argv[++i]);
+        else if (option == "--stream")                    streaming  = true;
+        else if (option == "--batch"     && i + 1 < argc) batch_size = std::stoll(argv[++i]);
+        else if (option == "--lookahead" && i + 1 < argc) lookahead  = std::stoll(argv[++i]);
+        else if (option == "--time"      && i + 1 < argc) timed_capacities = parse_capacities(argv[++i]);
+        else if (option == "--requests"  && i + 1 < argc) timed_requests   = std::stoll(argv[++i]);
+    }
 
     CacheDriver<ssize_t, ssize_t> driver;
-    auto optimal_cache_requests = driver.generate_requests(amount_numbers);
+    RequestSpan<ssize_t, ssize_t> optimal_cache_requests;
+
+    // the trace, or a seeded Zipf(0.99) trace over 4 times the largest
+    // capacity, so every capacity keeps evicting
+    if (!timed_capacities.empty())
+    {
+        workload::trace_t synthetic;
+        if (!trace_path.empty())
+            optimal_cache_requests = driver.map_trace(trace_path);
+        else
+        {
+            const ssize_t largest = *std::max_element(timed_capacities.begin(), timed_capacities.end());
+            synthetic = workload::zipf(static_cast<std::size_t>(std::max<ssize_t>(0, timed_requests)),
+                                       static_cast<std::size_t>(4 * std::max<ssize_t>(1, largest)), 0.99);
+            optimal_cache_requests = RequestSpan<ssize_t, ssize_t>(synthetic);
+        }
+
+        time_replays(optimal_cache_requests, timed_capacities);
+
+        log_close();
+        return 0;
+    }
+
+    // text input is simulated with a bounded look-ahead while it is read
+    if (streaming && trace_path.empty())
+    {
+        ssize_t input_capacity = 0;
+        std::cin >> input_capacity >> amount_numbers;
+        if (capacity == 0) capacity = input_capacity;
+
+        OPT_cache<ssize_t, ssize_t> optimal_cache = (lookahead > 0) ? OPT_cache<ssize_t, ssize_t>(capacity, lookahead)
+                                                                    : OPT_cache<ssize_t, ssize_t>(capacity);
+        if (batch_size > 0) driver.run_cache_streaming(optimal_cache, amount_numbers, batch_size);
+        else                driver.run_cache_streaming(optimal_cache, amount_numbers);
+
+        log_close();
+        return 0;
+    }
+
+    if (!trace_path.empty())
+    {
+        optimal_cache_requests = driver.map_trace(trace_path);
+        if (capacity == 0) capacity = driver.trace_capacity();
+    }
+    else
+    {
+        ssize_t input_capacity = 0;
+        std::cin >> input_capacity >> amount_numbers;
+        if (capacity == 0) capacity = input_capacity;
+
+        optimal_cache_requests = driver.generate_requests(amount_numbers);
+    }
 
     OPT_cache<ssize_t, ssize_t> optimal_cache(capacity);
     driver.run_cache(optimal_cache, optimal_cache_requests);
 
     LOG_INFO("DOLBAEB", "HELLO\n", 5);
-    HtmlLogger::close();
+    log_close();
 }
\ No newline at end of file
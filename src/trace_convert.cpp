@@ -0,0 +1,42 @@
+#include <vector>
+#include <string>
+
+#include "../include/utils/driver/driver.hpp"
+#include "../include/utils/trace/binary_trace.hpp"
+
+// converts the text input of arc_cache/opt_cache (capacity, amount, keys)
+// into a binary trace that both of them replay with --trace; --sized reads
+// "key size" pairs for arc_cache --bytes
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: trace_convert <output trace> [--items | --sized] < input" << std::endl;
+        return 1;
+    }
+
+    log_open("trace_convert_log");
+
+    std::string output_path = argv[1];
+    // --sized input has a size after every key, stored as the item column
+    const bool sized = (argc > 2 && std::string(argv[2]) == "--sized");
+    bool with_items  = sized || (argc > 2 && std::string(argv[2]) == "--items");
+
+    ssize_t capacity = 0;
+    ssize_t amount_numbers = 0;
+
+    std::cin >> capacity >> amount_numbers;
+
+    CacheDriver<ssize_t, ssize_t> driver;
+    const auto &requests = sized ? driver.generate_sized_requests(amount_numbers)
+                                 : driver.generate_requests(amount_numbers);
+
+    bool is_written = write_binary_trace(output_path, RequestSpan<ssize_t, ssize_t>(requests),
+                                         static_cast<std::uint64_t>(capacity), with_items);
+
+    std::cout << (is_written ? "written " : "FAILED to write ") << requests.size()
+              << " requests to " << output_path << std::endl;
+
+    log_close();
+    return is_written ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "alloc_counter.hpp"
+
+// every heap allocation of a binary linked with this goes through here,
+// so cache_tests and cache_bench can count what a cache call made
+static std::atomic<std::size_t> allocations_counter{0};
+
+std::size_t allocations() { return allocations_counter.load(std::memory_order_relaxed); }
+
+void *operator new(std::size_t size)
+{
+    allocations_counter.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+// GCC pairs the free() below with the new-expressions it inlines into and
+// does not know this operator new is malloc underneath
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
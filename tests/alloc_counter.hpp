@@ -0,0 +1,10 @@
+#ifndef ALLOC_COUNTER_HPP
+#define ALLOC_COUNTER_HPP
+
+#include <cstddef>
+
+// heap allocations the whole binary made so far, counted by the global
+// operator new of alloc_counter.cpp; compare it before and after a call
+std::size_t allocations();
+
+#endif
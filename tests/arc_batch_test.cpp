@@ -0,0 +1,136 @@
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ARC/ARC_Cache.hpp"
+#include "ARC/ARC_Stats.hpp"
+#include "utils/workload/workload.hpp"
+
+namespace
+{
+    // above PREFETCH_MIN_CAPACITY, so add_cache_batch takes the prefetch path
+    constexpr ssize_t PREFETCH_CAPACITY = 1 << 15;
+
+    // every list of a state copy, least recent first
+    template <typename cache_t>
+    std::vector<std::vector<long>> list_keys(const cache_t &cache)
+    {
+        const auto state = cache.copy_state();
+        std::vector<std::vector<long>> lists(ARC_LISTS);
+
+        for (ARCList list : {ARCList::T1, ARCList::T2})
+            state.for_each_entry(list, [&](const long &key, const long &)
+                                 { lists[static_cast<std::size_t>(list)].push_back(key); });
+
+        for (ARCList list : {ARCList::B1, ARCList::B2})
+            state.for_each_ghost(list, [&](const auto &ghost)
+                                 { lists[static_cast<std::size_t>(list)].push_back(static_cast<long>(ghost)); });
+
+        return lists;
+    }
+
+    template <typename cache_t>
+    void expect_batch_matches_sequential(double skew)
+    {
+        const workload::trace_t trace = workload::zipf(1 << 19, 20 * PREFETCH_CAPACITY, skew);
+
+        cache_t sequential(PREFETCH_CAPACITY);
+        for (const auto &request : trace)
+            sequential.add_cache(request.first, request.second);
+
+        cache_t batched(PREFETCH_CAPACITY);
+        const ssize_t batch_hits = batched.add_cache_batch(RequestSpan<long, long>(trace));
+
+        EXPECT_EQ(batch_hits, sequential.get_hit_count());
+        EXPECT_EQ(batched.get_hit_count(), sequential.get_hit_count());
+        EXPECT_EQ(batched.get_request_count(), sequential.get_request_count());
+        EXPECT_EQ(batched.get_ghost_hit_count(), sequential.get_ghost_hit_count());
+        EXPECT_EQ(batched.copy_state().adapt_param(), sequential.copy_state().adapt_param());
+        EXPECT_EQ(list_keys(batched), list_keys(sequential));
+    }
+}
+
+// get_batch only looks keys up, so its misses must be counted by it
+TEST(ArcBatch, GetBatchCountsEveryKey)
+{
+    ARCCache<long, long, FlatHashIndex, KeyGhosts, ARCStats> cache(64);
+    for (long key = 0; key < 32; key++)
+        cache.add_cache(key, key);
+
+    const ssize_t requests_before = cache.get_request_count();
+    const ssize_t hits_before     = cache.get_hit_count();
+
+    std::vector<long> keys;
+    for (long key = 16; key < 48; key++)
+        keys.push_back(key);
+
+    std::vector<long> items(keys.size());
+    std::unique_ptr<bool[]> found(new bool[keys.size()]);
+
+    EXPECT_EQ(cache.get_batch(keys.data(), keys.size(), items.data(), found.get()), 16u);
+
+    EXPECT_EQ(cache.get_request_count() - requests_before, static_cast<ssize_t>(keys.size()));
+    EXPECT_EQ(cache.get_hit_count() - hits_before, 16);
+    EXPECT_EQ(cache.stats().requests(), static_cast<std::uint64_t>(cache.get_request_count()));
+
+    for (std::size_t i = 0; i < keys.size(); i++)
+    {
+        EXPECT_EQ(found[i], keys[i] < 32);
+
+        if (found[i])
+        {
+            EXPECT_EQ(items[i], keys[i]);
+        }
+    }
+}
+
+TEST(ArcBatch, GetBatchOnlyWorkloadIsNotAllHits)
+{
+    ARCCache<long, long, FlatHashIndex> cache(64);
+
+    std::vector<long> keys(100);
+    for (std::size_t i = 0; i < keys.size(); i++)
+        keys[i] = static_cast<long>(i);
+
+    std::vector<long> items(keys.size());
+    std::unique_ptr<bool[]> found(new bool[keys.size()]);
+
+    EXPECT_EQ(cache.get_batch(keys.data(), keys.size(), items.data(), found.get()), 0u);
+    EXPECT_EQ(cache.get_request_count(), 100);
+    EXPECT_EQ(cache.get_hit_count(), 0);
+}
+
+// an entry past its TTL is a miss of the batch, not a skipped key
+TEST(ArcBatch, GetBatchCountsExpiredEntries)
+{
+    ARCCache<long, long, FlatHashIndex, KeyGhosts, NoARCStats, WheelExpiry<>> cache(16);
+    cache.add_cache(1, 1, std::chrono::nanoseconds(1));
+    cache.add_cache(2, 2);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+
+    const ssize_t requests_before = cache.get_request_count();
+
+    const long keys[] = {1, 2};
+    long items[2]  = {};
+    bool found[2]  = {};
+
+    EXPECT_EQ(cache.get_batch(keys, 2, items, found), 1u);
+    EXPECT_FALSE(found[0]);
+    EXPECT_TRUE(found[1]);
+    EXPECT_EQ(cache.get_request_count() - requests_before, 2);
+}
+
+// the batched replay overlaps index walks only: hits and every list, in
+// order, must be those of add_cache one request at a time
+TEST(ArcBatch, AddCacheBatchMatchesSequentialAddCache)
+{
+    for (double skew : {0.7, 0.99})
+    {
+        expect_batch_matches_sequential<ARCCache<long, long, FlatHashIndex>>(skew);
+        expect_batch_matches_sequential<ARCCache<long, long, FlatHashIndex, FingerprintGhosts>>(skew);
+    }
+}
@@ -0,0 +1,162 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+#include "ARC/ARC_Cache.hpp"
+#include "test_counters.hpp"
+
+// longer than any small-string buffer, so every std::string built from
+// one of these allocates
+static std::string long_key(int i)
+{
+    return "arc_insert_test/a_key_too_long_for_sso/" + std::to_string(i);
+}
+
+using FlatStringCache = ARCCache<std::string, long, FlatHashIndex>;
+
+TEST(ArcInsert, EmplaceMissBuildsKeyOnceForNodeAndOnceForIndex)
+{
+    FlatStringCache cache(16);
+    const std::string key = long_key(0);
+
+    const std::size_t before = allocations();
+    EXPECT_FALSE(cache.emplace(std::string_view(key), 1L));
+
+    EXPECT_EQ(allocations() - before, 2u);
+}
+
+TEST(ArcInsert, EmplaceHitThroughStringViewAllocatesNothing)
+{
+    FlatStringCache cache(16);
+    const std::string key = long_key(0);
+    cache.emplace(std::string_view(key), 1L);
+
+    const std::size_t before = allocations();
+    EXPECT_TRUE(cache.emplace(std::string_view(key), 2L));
+    EXPECT_TRUE(cache.emplace(key.c_str(), 3L));
+
+    EXPECT_EQ(allocations() - before, 0u);
+    EXPECT_EQ(cache.get_item(std::string_view(key)), 1L);
+}
+
+TEST(ArcInsert, HitAllocatesNothing)
+{
+    FlatStringCache string_cache(16);
+    ARCCache<long, long, FlatHashIndex> long_cache(16);
+    ARCCache<long, long>                std_cache(16);
+
+    const std::string key = long_key(0);
+    string_cache.add_cache(key, 1L);
+    long_cache.add_cache(7, 7);
+    std_cache.add_cache(7, 7);
+
+    const std::size_t before = allocations();
+    EXPECT_TRUE(string_cache.add_cache(key, 1L));
+    EXPECT_NE(string_cache.lookup(std::string_view(key)), nullptr);
+    EXPECT_TRUE(long_cache.add_cache(7, 7));
+    EXPECT_NE(long_cache.lookup(7L), nullptr);
+    EXPECT_TRUE(std_cache.add_cache(7, 7));
+    EXPECT_NE(std_cache.lookup(7L), nullptr);
+
+    EXPECT_EQ(allocations() - before, 0u);
+}
+
+TEST(ArcInsert, RvalueAddCacheMovesTheItemAndCopiesTheKeyOnlyIntoTheIndex)
+{
+    ARCCache<Counted, Counted, FlatHashIndex> cache(16);
+
+    Counted::reset();
+    EXPECT_FALSE(cache.add_cache(Counted(1), Counted(10)));
+
+    // key: moved into the node, copied once into the index; item: moved
+    EXPECT_EQ(Counted::copies, 1u);
+    EXPECT_EQ(Counted::moves, 2u);
+
+    Counted::reset();
+    EXPECT_TRUE(cache.add_cache(Counted(1), Counted(20)));
+
+    EXPECT_EQ(Counted::copies, 0u);
+    EXPECT_EQ(Counted::moves, 0u);
+    EXPECT_EQ(cache.get_item(Counted(1)).value, 10);
+}
+
+TEST(ArcInsert, EmplaceBuildsTheItemInPlace)
+{
+    ARCCache<long, Counted, FlatHashIndex> cache(16);
+
+    Counted::reset();
+    EXPECT_FALSE(cache.emplace(1L, 10L));
+    EXPECT_TRUE(cache.emplace(1L, 20L));
+
+    // the miss builds a temporary from the long and moves it into the node
+    EXPECT_EQ(Counted::copies, 0u);
+    EXPECT_EQ(Counted::moves, 1u);
+}
+
+TEST(ArcInsert, EvictionMovesTheKeyIntoTheGhostList)
+{
+    // 1 goes to T2 and 2 to T1, so 3 makes REPLACE push 2 into B1
+    ARCCache<Counted, long, FlatHashIndex> cache(2);
+    cache.add_cache(Counted(1), 1L);
+    cache.add_cache(Counted(1), 1L);
+    cache.add_cache(Counted(2), 2L);
+
+    Counted::reset();
+    cache.add_cache(Counted(3), 3L);
+
+    // new key: node + index copy; evicted key: moved out of its node into
+    // the ghost slab, then copied into the ghost index
+    EXPECT_EQ(Counted::copies, 2u);
+    EXPECT_EQ(cache.get_ghost_hit_count(), 0);
+
+    EXPECT_FALSE(cache.add_cache(Counted(2), 2L));
+    EXPECT_EQ(cache.get_ghost_hit_count(), 1);
+}
+
+TEST(ArcInsert, MoveOnlyItems)
+{
+    ARCCache<long, std::unique_ptr<long>, FlatHashIndex> cache(2);
+
+    EXPECT_FALSE(cache.add_cache(1L, std::make_unique<long>(10)));
+    EXPECT_FALSE(cache.emplace(2L, std::make_unique<long>(20)));
+
+    std::unique_ptr<long> *item = cache.lookup(1L);
+    ASSERT_NE(item, nullptr);
+    EXPECT_EQ(**item, 10);
+
+    // a hit keeps the resident item and leaves the argument alone
+    auto unused = std::make_unique<long>(11);
+    EXPECT_TRUE(cache.add_cache(1L, std::move(unused)));
+    EXPECT_EQ(**cache.lookup(1L), 10);
+
+    const std::size_t before = allocations();
+    EXPECT_NE(cache.lookup(2L), nullptr);
+    EXPECT_EQ(allocations() - before, 0u);
+
+    // evictions drop move-only items like any other
+    EXPECT_FALSE(cache.emplace(3L, std::make_unique<long>(30)));
+    EXPECT_FALSE(cache.emplace(4L, std::make_unique<long>(40)));
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(**cache.lookup(4L), 40);
+
+    // a span can not hand out move-only items, and a silent no-op would
+    // read as a replay without hits
+    EXPECT_THROW(cache.run_cache(RequestSpan<long, std::unique_ptr<long>>()), std::logic_error);
+    EXPECT_EQ(cache.size(), 2u);
+}
+
+// dump() is built at every log level; keys and items without an
+// operator<< are printed as a placeholder instead of failing to compile
+TEST(ArcInsert, DumpsUnprintableKeysAndItems)
+{
+    ARCCache<Counted, std::unique_ptr<long>, FlatHashIndex> cache(2);
+    cache.add_cache(Counted(1), std::make_unique<long>(1));
+    cache.add_cache(Counted(2), std::make_unique<long>(2));
+    cache.add_cache(Counted(3), std::make_unique<long>(3));
+
+    cache.dump();
+    EXPECT_EQ(cache.size(), 2u);
+}
@@ -0,0 +1,64 @@
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ARC/ARC_Cache.hpp"
+#include "ARC/WeightedARC_Cache.hpp"
+#include "utils/cost/item_cost.hpp"
+#include "test_traces.hpp"
+
+// with every entry costing 1, the byte-capacity cache is ARC: same hit or
+// miss on every request, over traces from mostly-hits to mostly-scans
+TEST(ArcWeighted, UnitCostMatchesARCRequestByRequest)
+{
+    for (unsigned seed = 0; seed < 300; seed++)
+    {
+        std::mt19937 rng(seed);
+        const ssize_t capacity = 1 + static_cast<ssize_t>(rng() % 200);
+        const long    keys     = 1 + static_cast<long>(rng() % (8 * capacity));
+
+        ARCCache<long, long>         arc(capacity);
+        WeightedARCCache<long, long> weighted(capacity);
+
+        for (int i = 0; i < 5000; i++)
+        {
+            // a hot set of an eighth of the keys takes half the requests
+            const long key = (rng() % 2) ? static_cast<long>(rng() % (keys / 8 + 1))
+                                         : static_cast<long>(rng() % keys);
+
+            ASSERT_EQ(weighted.add_cache(key, key), arc.add_cache(key, key))
+                << "seed " << seed << ", request " << i;
+        }
+
+        EXPECT_EQ(weighted.get_hit_count(), arc.get_hit_count());
+        EXPECT_EQ(weighted.get_used_bytes(), static_cast<ssize_t>(arc.size()));
+    }
+}
+
+// items are their own size here; T1 + T2 stay within the byte capacity
+// after every request, and an item larger than the cache is never kept
+TEST(ArcWeighted, UsedBytesNeverExceedCapacity)
+{
+    using SizedCache = WeightedARCCache<long, long, ItemSizeCost<long, long>>;
+
+    for (ssize_t capacity : {4096, 65536, 1 << 20})
+    {
+        const std::vector<Request> trace = sized_trace(50000, 2000, static_cast<unsigned>(capacity));
+
+        SizedCache cache(capacity);
+        for (const Request &request : trace)
+        {
+            cache.add_cache(request.first, request.second);
+            ASSERT_LE(cache.get_used_bytes(), capacity);
+        }
+
+        EXPECT_GT(cache.get_hit_count(), 0);
+    }
+
+    SizedCache small(100);
+    EXPECT_FALSE(small.add_cache(1, 101));
+    EXPECT_FALSE(small.add_cache(1, 101));
+    EXPECT_EQ(small.get_used_bytes(), 0);
+    EXPECT_EQ(small.get_item(1), 0);
+}
@@ -0,0 +1,31 @@
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "ARC/BatchedARC_Cache.hpp"
+
+// get_item misses never reach a shard cache, yet they are requests
+TEST(BatchedArc, GetItemCountsMisses)
+{
+    BatchedARCCache<long, long> cache(64, 4, 1);
+    for (long key = 0; key < 32; key++)
+        cache.add_cache(key, key);
+
+    const ssize_t requests_before = cache.get_request_count();
+    const ssize_t hits_before     = cache.get_hit_count();
+
+    for (long key = 16; key < 48; key++)
+        EXPECT_EQ(cache.get_item(key), key < 32 ? key : 0);
+
+    EXPECT_EQ(cache.get_request_count() - requests_before, 32);
+    EXPECT_EQ(cache.get_hit_count() - hits_before, 16);
+}
+
+TEST(BatchedArc, ShardsAddUpToTheCapacity)
+{
+    for (ssize_t capacity : {1000, 1001, 1023, 1024, 3})
+    {
+        BatchedARCCache<long, long> cache(capacity, 8, 1);
+        EXPECT_EQ(cache.capacity(), std::max<ssize_t>(capacity, 8)) << "capacity " << capacity;
+    }
+}
@@ -0,0 +1,48 @@
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ARC/BatchedARC_Cache.hpp"
+
+// built with -fsanitize=thread and run with tests/tsan.supp: any report
+// besides the optimistic reads fails the test. Items equal their keys, so
+// a torn read that got through would show up as a wrong item
+TEST(BatchedTsan, ReadersAndWritersShareShards)
+{
+    constexpr int  THREADS  = 4;
+    constexpr int  REQUESTS = 50000;
+    constexpr long KEYS     = 5000;
+
+    BatchedARCCache<long, long> cache(1000, 8);
+    std::vector<long> wrong(THREADS, 0);
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < THREADS; thread++)
+        threads.emplace_back([&cache, &wrong, thread]()
+        {
+            std::mt19937_64 rng(static_cast<std::uint64_t>(thread) + 1);
+            for (int i = 0; i < REQUESTS; i++)
+            {
+                const long key = static_cast<long>(rng() % KEYS);
+                if (i % 2 == 0)
+                    cache.add_cache(key, key);
+                else
+                {
+                    const long item = cache.get_item(key);
+                    if (item != 0 && item != key) wrong[thread]++;
+                }
+            }
+        });
+
+    for (auto &thread : threads)
+        thread.join();
+
+    cache.maintenance();
+
+    for (long count : wrong)
+        EXPECT_EQ(count, 0);
+
+    EXPECT_EQ(cache.get_request_count(), static_cast<ssize_t>(THREADS) * REQUESTS);
+}
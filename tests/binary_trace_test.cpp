@@ -0,0 +1,63 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "utils/trace/binary_trace.hpp"
+
+namespace
+{
+    constexpr char TRACE_PATH[] = "binary_trace_test.bin";
+
+    void write_trace(std::size_t requests)
+    {
+        std::vector<std::pair<long, long>> trace;
+        for (std::size_t i = 0; i < requests; i++)
+            trace.emplace_back(static_cast<long>(i), static_cast<long>(i));
+
+        ASSERT_TRUE(write_binary_trace(TRACE_PATH, RequestSpan<long, long>(trace), 10, true));
+    }
+
+    void patch_count(std::uint64_t count)
+    {
+        std::FILE *file = std::fopen(TRACE_PATH, "r+b");
+        ASSERT_NE(file, nullptr);
+
+        ASSERT_EQ(std::fseek(file, offsetof(TraceHeader, count), SEEK_SET), 0);
+        ASSERT_EQ(std::fwrite(&count, sizeof(count), 1, file), 1u);
+        std::fclose(file);
+    }
+}
+
+TEST(BinaryTrace, RoundTrip)
+{
+    write_trace(100);
+
+    MappedTrace<long, long> trace;
+    ASSERT_TRUE(trace.open(TRACE_PATH));
+    EXPECT_EQ(trace.capacity(), 10u);
+
+    const RequestSpan<long, long> requests = trace.requests();
+    ASSERT_EQ(requests.size(), 100u);
+    EXPECT_EQ(requests.key(99), 99);
+    EXPECT_EQ(requests.item(42), 42);
+
+    std::remove(TRACE_PATH);
+}
+
+// count * width wraps around to 8 bytes here, which a plain size check
+// against the product would let through
+TEST(BinaryTrace, RejectsCountThatOverflowsTheColumns)
+{
+    write_trace(100);
+    patch_count((std::uint64_t(1) << 61) + 1);
+
+    MappedTrace<long, long> trace;
+    EXPECT_FALSE(trace.open(TRACE_PATH));
+    EXPECT_FALSE(trace.is_open());
+
+    std::remove(TRACE_PATH);
+}
@@ -0,0 +1,94 @@
+#include <cstddef>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "utils/flat_map/flat_hash_map.hpp"
+#include "alloc_counter.hpp"
+
+namespace
+{
+    constexpr std::size_t KEYS  = 20000;
+    constexpr std::size_t CHURN = 1000000;
+}
+
+TEST(FlatHashMap, ChurnKeepsEveryLiveEntry)
+{
+    FlatHashMap<long, std::string> map(KEYS);
+    std::unordered_map<long, std::string> expected;
+    std::vector<long> live;
+
+    std::mt19937_64 gen(7);
+    long next = 0;
+
+    for (; next < static_cast<long>(KEYS); next++)
+    {
+        map.emplace(next, std::to_string(next));
+        expected.emplace(next, std::to_string(next));
+        live.push_back(next);
+    }
+
+    // erases a random live key and inserts a fresh one, so the table stays
+    // at the size it was reserved for while tombstones pile up
+    const std::size_t buckets = map.bucket_count();
+    for (std::size_t i = 0; i < CHURN; i++, next++)
+    {
+        long &victim = live[gen() % live.size()];
+        map.erase(victim);
+        expected.erase(victim);
+
+        map.emplace(next, std::to_string(next));
+        expected.emplace(next, std::to_string(next));
+        victim = next;
+    }
+
+    EXPECT_EQ(map.bucket_count(), buckets);
+    ASSERT_EQ(map.size(), expected.size());
+
+    std::size_t visited = 0;
+    for (const auto &entry : map)
+    {
+        visited++;
+        EXPECT_EQ(expected.at(entry.first), entry.second);
+    }
+    EXPECT_EQ(visited, expected.size());
+
+    for (const auto &entry : expected)
+    {
+        auto it = map.find(entry.first);
+        ASSERT_NE(it, map.end()) << "key " << entry.first;
+        EXPECT_EQ(it->second, entry.second);
+    }
+}
+
+// dropping tombstones reuses the slot array and needs no buffer
+TEST(FlatHashMap, ChurnAfterReserveDoesNotAllocate)
+{
+    FlatHashMap<long, long> map(KEYS);
+    std::vector<long> live;
+    live.reserve(KEYS);
+
+    const std::size_t before = allocations();
+    std::mt19937_64 gen(11);
+    long next = 0;
+
+    for (; next < static_cast<long>(KEYS); next++)
+    {
+        map.emplace(next, next);
+        live.push_back(next);
+    }
+
+    for (std::size_t i = 0; i < CHURN; i++, next++)
+    {
+        long &victim = live[gen() % live.size()];
+        map.erase(victim);
+        map.emplace(next, next);
+        victim = next;
+    }
+
+    EXPECT_EQ(allocations(), before);
+    EXPECT_EQ(map.size(), KEYS);
+}
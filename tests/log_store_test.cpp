@@ -0,0 +1,71 @@
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "utils/log_store/log_store.hpp"
+
+namespace
+{
+    // a fixed record is the key and the item, nothing else
+    using FixedStore = LogStore<std::int64_t, std::int64_t>;
+
+    constexpr std::int64_t RECORDS_PER_SEGMENT = FixedStore::SEGMENT_SIZE / (2 * sizeof(std::int64_t));
+
+    std::string make_item(std::int64_t key) { return std::string(key % 700, char('a' + key % 26)); }
+}
+
+// the keys of a recycled segment are read back from its records
+TEST(LogStore, WrapDropsKeysOfTheOverwrittenSegment)
+{
+    FixedStore store("log_store_test_fixed.bin", 2 * FixedStore::SEGMENT_SIZE);
+    ASSERT_TRUE(store.is_open());
+
+    for (std::int64_t key = 0; key < RECORDS_PER_SEGMENT; key++)
+        ASSERT_TRUE(store.put(key, key));
+
+    // rewritten into segment 1 before segment 0 comes around, so it stays
+    ASSERT_TRUE(store.put(5, 5));
+    for (std::int64_t key = RECORDS_PER_SEGMENT; key < 2 * RECORDS_PER_SEGMENT - 1; key++)
+        ASSERT_TRUE(store.put(key, key));
+
+    EXPECT_EQ(store.dropped(), 0u);
+
+    // both segments are full, so this one goes over segment 0
+    ASSERT_TRUE(store.put(2 * RECORDS_PER_SEGMENT, 0));
+
+    EXPECT_EQ(store.dropped(), static_cast<std::uint64_t>(RECORDS_PER_SEGMENT - 1));
+    EXPECT_FALSE(store.contains(0));
+    EXPECT_FALSE(store.contains(RECORDS_PER_SEGMENT - 1));
+
+    std::int64_t item = -1;
+    EXPECT_TRUE(store.get(5, item));
+    EXPECT_EQ(item, 5);
+    EXPECT_TRUE(store.get(RECORDS_PER_SEGMENT, item));
+    EXPECT_EQ(item, RECORDS_PER_SEGMENT);
+}
+
+TEST(LogStore, VariableRecordsSurviveManyWraps)
+{
+    LogStore<std::int64_t, std::string, StringItemCodec> store("log_store_test_strings.bin",
+                                                               4 * FixedStore::SEGMENT_SIZE);
+    ASSERT_TRUE(store.is_open());
+
+    for (std::int64_t i = 0; i < 200000; i++)
+    {
+        const std::int64_t key = i * 7919 % 50000;
+        ASSERT_TRUE(store.put(key, make_item(key)));
+    }
+
+    EXPECT_GT(store.dropped(), 0u);
+    EXPECT_EQ(store.rejected(), 0u);
+
+    std::string item;
+    for (std::int64_t key = 0; key < 50000; key++)
+    {
+        if (!store.contains(key)) continue;
+
+        ASSERT_TRUE(store.get(key, item));
+        EXPECT_EQ(item, make_item(key));
+    }
+}
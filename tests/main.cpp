@@ -0,0 +1,14 @@
+#include <gtest/gtest.h>
+
+#include "utils/log_config/log_config.hpp"
+
+int main(int argc, char **argv)
+{
+    log_open("cache_tests_log");
+
+    testing::InitGoogleTest(&argc, argv);
+    const int result = RUN_ALL_TESTS();
+
+    log_close();
+    return result;
+}
@@ -0,0 +1,49 @@
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "optimal/optimal_cache.hpp"
+#include "utils/cost/item_cost.hpp"
+#include "test_traces.hpp"
+
+// a budget of bytes far above what the distinct keys take: nothing is
+// ever evicted, so only first requests miss, and the budget does not size
+// any buffer
+TEST(OptWeighted, ByteBudgetFarAboveDistinctKeys)
+{
+    const std::vector<Request> trace = sized_trace(20000, 300, 1);
+
+    std::unordered_set<long> distinct;
+    long bytes = 0, first_bytes = 0;
+    for (const Request &request : trace)
+    {
+        bytes += request.second;
+        if (distinct.insert(request.first).second) first_bytes += request.second;
+    }
+
+    for (ssize_t budget : {ssize_t(1) << 32, ssize_t(1) << 40, ssize_t(1) << 61})
+    {
+        OPT_cache<long, long> cache(budget);
+        const ssize_t hits = cache.run_cache_weighted(trace, ItemSizeCost<long, long>());
+
+        EXPECT_EQ(hits, static_cast<ssize_t>(trace.size() - distinct.size()));
+        EXPECT_EQ(cache.get_request_count(), static_cast<ssize_t>(trace.size()));
+        EXPECT_EQ(cache.get_byte_hit_count(), bytes - first_bytes);
+    }
+}
+
+// with every entry of size 1 the size-aware rule is Belady's
+TEST(OptWeighted, UnitCostMatchesEntryCountOPT)
+{
+    const std::vector<Request> trace = sized_trace(50000, 2000, 2);
+
+    for (ssize_t capacity : {1, 10, 300, 1999, 5000})
+    {
+        OPT_cache<long, long> weighted(capacity);
+        OPT_cache<long, long> plain(capacity);
+
+        EXPECT_EQ(weighted.run_cache_weighted(trace, UnitCost<long, long>()), plain.run_cache(trace))
+            << "capacity " << capacity;
+    }
+}
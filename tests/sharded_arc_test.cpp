@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <future>
+
+#include <gtest/gtest.h>
+
+#include "ARC/ARC_Stats.hpp"
+#include "ARC/ShardedARC_Cache.hpp"
+#include "utils/thread_pool/thread_pool.hpp"
+
+// a request that joins a load in flight is served by it: it is a request
+// and a hit, and the key it touched a second time goes to T2
+TEST(ShardedArc, JoinedLoadCountsAndPromotes)
+{
+    ShardedARCCache<long, long, SpinLock, FlatHashIndex, ARCStats> cache(64, 1);
+    ThreadPool pool(1);
+
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+
+    auto loader = [opened](long key) { opened.wait(); return 10 * key; };
+
+    std::shared_future<long> leader = cache.get_or_load_async(7, loader, pool);
+    std::shared_future<long> joined = cache.get_or_load_async(7, loader, pool);
+    EXPECT_EQ(cache.get_coalesced_count(), 1);
+
+    gate.set_value();
+    EXPECT_EQ(leader.get(), 70);
+    EXPECT_EQ(joined.get(), 70);
+
+    EXPECT_EQ(cache.get_request_count(), 2);
+    EXPECT_EQ(cache.get_hit_count(), 1);
+
+    EXPECT_EQ(cache.get_or_load(7, loader), 70);
+
+    ARCStats stats;
+    cache.collect_stats(stats);
+    EXPECT_EQ(stats.hits(ARCList::T2), 1u);
+    EXPECT_EQ(stats.hits(ARCList::T1), 0u);
+}
+
+// the shards split the capacity with no entry to spare, and a capacity
+// under one entry per shard is raised to exactly that
+TEST(ShardedArc, ShardsAddUpToTheCapacity)
+{
+    for (ssize_t capacity : {1000, 1001, 1023, 1024, 3})
+    {
+        ShardedARCCache<long, long> cache(capacity, 8);
+        EXPECT_EQ(cache.capacity(), std::max<ssize_t>(capacity, 8)) << "capacity " << capacity;
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef TEST_COUNTERS_HPP
+#define TEST_COUNTERS_HPP
+
+#include <cstddef>
+#include <functional>
+
+#include "alloc_counter.hpp"
+
+// key and item type that counts how often it is copied and moved
+struct Counted
+{
+    static inline std::size_t copies = 0;
+    static inline std::size_t moves  = 0;
+
+    long value;
+
+    Counted() : value(0) {}
+    Counted(long v) : value(v) {}
+
+    Counted(const Counted &other) : value(other.value) { copies++; }
+    Counted(Counted &&other) noexcept : value(other.value) { moves++; }
+
+    Counted &operator=(const Counted &other) { value = other.value; copies++; return *this; }
+    Counted &operator=(Counted &&other) noexcept { value = other.value; moves++; return *this; }
+
+    bool operator==(const Counted &other) const { return value == other.value; }
+
+    static inline void reset() { copies = 0; moves = 0; }
+};
+
+namespace std
+{
+template <>
+struct hash<Counted>
+{
+    std::size_t operator()(const Counted &key) const { return std::hash<long>()(key.value); }
+};
+}
+
+#endif
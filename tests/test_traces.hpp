@@ -0,0 +1,26 @@
+#ifndef TEST_TRACES_HPP
+#define TEST_TRACES_HPP
+
+#include <random>
+#include <utility>
+#include <vector>
+
+using Request = std::pair<long, long>;
+
+// keys drawn from distinct_keys, each with a fixed size of 1 to 4096 bytes
+inline std::vector<Request> sized_trace(std::size_t length, long distinct_keys, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<Request> trace;
+    trace.reserve(length);
+
+    for (std::size_t i = 0; i < length; i++)
+    {
+        const long key = static_cast<long>(rng() % static_cast<unsigned>(distinct_keys));
+        trace.emplace_back(key, 1 + (key * 2654435761L) % 4096);
+    }
+
+    return trace;
+}
+
+#endif